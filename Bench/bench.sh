@@ -0,0 +1,155 @@
+#!/bin/sh
+#	$Id$
+#
+#	Copyright (c) 2026
+#
+#	This source code is released for free distribution under the terms of the
+#	GNU General Public License.
+#
+#	Runs the benchmark cases of "make bench" (see benchmark.mak) over the
+#	corpus written by mkcorpus, reporting the throughput, tags per second and
+#	peak memory of each against a baseline, or recording a new baseline.
+#
+#	Usage: bench.sh ctags corpus scale runs baseline threshold [record]
+#
+#	Each case is run `runs' times and its fastest run reported. Its figures
+#	are taken from --totals=json, its rates being measured in processor time,
+#	which varies less than elapsed time from one run to the next. A case
+#	regresses when its throughput or its tags per second fall, or its peak
+#	memory rises, by more than `threshold' percent of the baseline. The exit
+#	status is 1 if any case regressed.
+
+if [ $# -lt 6 ]; then
+	echo "Usage: $0 ctags corpus scale runs baseline threshold [record]" >&2
+	exit 2
+fi
+CTAGS=$1
+CORPUS=$2
+SCALE=$3
+RUNS=$4
+BASELINE=$5
+THRESHOLD=$6
+RECORD=$7
+TAGS=bench.tags
+RESULTS=bench.results
+
+#	Runs one case, appending "name tags MB/s tags/s kB" to $RESULTS.
+#
+run_case ()
+{
+	name=$1
+	shift
+	printf "%-16s" "$name"
+	run=0
+	best=
+	while [ $run -lt "$RUNS" ]; do
+		$CTAGS -f $TAGS --totals=json "$@" 2>&1 >/dev/null |
+			awk '/^\{"files"/ {
+				match ($0, /"bytes":[0-9]+/)
+				bytes = substr ($0, RSTART + 8, RLENGTH - 8)
+				match ($0, /"tags":[0-9]+/)
+				tags = substr ($0, RSTART + 7, RLENGTH - 7)
+				match ($0, /"peakMemoryKB":[0-9]+/)
+				kb = substr ($0, RSTART + 15, RLENGTH - 15)
+				cpu = 0
+				rest = $0
+				while (match (rest, /"cpu":[0-9.]+/)) {
+					cpu += substr (rest, RSTART + 6, RLENGTH - 6)
+					rest = substr (rest, RSTART + RLENGTH)
+				}
+				print bytes, tags, cpu, kb
+			}' > $TAGS.run
+		if [ ! -s $TAGS.run ]; then
+			echo " failed"
+			rm -f $TAGS $TAGS.run
+			exit 2
+		fi
+		best=`{ echo "$best"; cat $TAGS.run; } |
+			awk 'NF == 4 && (best == "" || $3 < cpu) { best = $0; cpu = $3 }
+				END { print best }'`
+		run=`expr $run + 1`
+	done
+	echo "$best" | awk -v name="$name" '{
+		cpu = $3 > 0 ? $3 : 0.000001
+		printf "%s %d %.2f %.0f %d\n", name, $2, $1 / cpu / 1048576, $2 / cpu, $4
+	}' >> $RESULTS
+	tail -1 $RESULTS | awk '{ printf "%10d tags %9.2f MB/s %11d tags/s %8d kB\n", $2, $3, $4, $5 }'
+}
+
+rm -f $RESULTS
+echo "Benchmarking $CTAGS on $CORPUS (scale $SCALE, best of $RUNS runs)"
+
+#	Each language with the default options.
+for language in c c++ javascript sql fortran python; do
+	run_case $language -R "$CORPUS/$language"
+done
+
+#	The whole corpus with fixed option sets.
+run_case all -R "$CORPUS"
+run_case all-fields -R --fields=+afmikKlnsStz --extra=+fq --c-kinds=+lpx "$CORPUS"
+run_case all-etags -R -e "$CORPUS"
+run_case all-json -R --output-format=json "$CORPUS"
+rm -f $TAGS $TAGS.run
+
+if [ -n "$RECORD" ]; then
+	{
+		echo "# Baseline for make bench, recorded by make bench-baseline."
+		echo "# Rates depend upon the machine, and must be recorded again"
+		echo "# before comparing the results of another."
+		echo "# case tags MB/s tags/s peak-kB"
+		echo "scale $SCALE"
+		cat $RESULTS
+	} > "$BASELINE"
+	rm -f $RESULTS
+	echo "Baseline recorded in $BASELINE"
+	exit 0
+fi
+
+if [ ! -f "$BASELINE" ]; then
+	echo "No baseline found in $BASELINE; make bench-baseline records one"
+	rm -f $RESULTS
+	exit 0
+fi
+if ! grep "^scale $SCALE\$" "$BASELINE" >/dev/null; then
+	echo "Baseline in $BASELINE was not recorded at scale $SCALE; not compared"
+	rm -f $RESULTS
+	exit 0
+fi
+
+echo "Comparing with $BASELINE (threshold $THRESHOLD%)"
+awk -v threshold="$THRESHOLD" '
+	FNR == NR {
+		if ($1 != "scale" && $1 !~ /^#/) {
+			tags [$1] = $2; mbps [$1] = $3; tps [$1] = $4; kb [$1] = $5
+		}
+		next
+	}
+	function change (now, then) {
+		return then > 0 ? (now - then) * 100 / then : 0
+	}
+	{
+		if (! ($1 in mbps)) {
+			printf "%-16s not in baseline\n", $1
+			next
+		}
+		status = "ok"
+		if (change($3, mbps [$1]) < -threshold || change($4, tps [$1]) < -threshold ||
+			change($5, kb [$1]) > threshold) {
+			status = "REGRESSED"
+			++regressed
+		}
+		printf "%-16s %+7.1f%% MB/s %+7.1f%% tags/s %+7.1f%% kB  %s", $1,
+			change($3, mbps [$1]), change($4, tps [$1]), change($5, kb [$1]), status
+		if ($2 != tags [$1])
+			printf " (%d tags, baseline %d)", $2, tags [$1]
+		printf "\n"
+	}
+	END {
+		if (regressed > 0) {
+			printf "%d case%s regressed\n", regressed, regressed == 1 ? "" : "s"
+			exit 1
+		}
+	}' "$BASELINE" $RESULTS
+status=$?
+rm -f $RESULTS
+exit $status
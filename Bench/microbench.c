@@ -0,0 +1,520 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This program times the primitives upon which the speed of ctags depends,
+*   one at a time, so that a change to any one of them may be measured apart
+*   from the rest. It is linked with the objects of ctags itself (its main ()
+*   being renamed) and of the readtags library.
+*
+*   Each benchmark is first calibrated, doubling its number of iterations
+*   until one sample takes at least the minimum sample time, so that the
+*   resolution of the clock is immaterial. It is then sampled repeatedly, and
+*   the median time per operation is reported, together with the median
+*   absolute deviation from it (as a percentage), which unlike the standard
+*   deviation is not swayed by the occasional sample interrupted by another
+*   process, and the fastest sample.
+*
+*   Usage: microbench [-s samples] [-t milliseconds] [-l] [benchmark...]
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "args.h"
+#include "entry.h"
+#include "get.h"
+#include "keyword.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "sort.h"
+#include "vstring.h"
+#include "microbench.h"
+
+/*
+*   MACROS
+*/
+#define SOURCE_SIZE  262144L  /* size of the source file read */
+#define SORT_COUNT   20000    /* lines of the tag file sorted */
+
+/*
+*   DATA DEFINITIONS
+*/
+static unsigned int Samples = 11;
+static double MinimumSampleTime = 0.02;  /* seconds */
+
+static volatile unsigned long Sink;  /* defeats the optimizer */
+
+static langType LangC;
+static langType LangSql;
+static char *SourceName = NULL;
+static vString **SourceLines = NULL;
+static unsigned int SourceLineCount = 0;
+static vString *String = NULL;
+static vString *Tokens [10];
+
+static const char *const SourceText [] = {
+	"#include <stdio.h>\n",
+	"#define BUFFER_SIZE 1024\n",
+	"/* A comment, with \"quotes\" and 'c' in it */\n",
+	"typedef struct sEntry {\n",
+	"\tconst char *name;  /* name of entry */\n",
+	"\tunsigned long count;\n",
+	"} entry;\n",
+	"\n",
+	"static int compareEntries (const void *a, const void *b)\n",
+	"{\n",
+	"\tconst entry *const x = (const entry *) a;\n",
+	"#ifdef DEBUG\n",
+	"\tprintf (\"%s\\n\", x->name);\n",
+	"#endif\n",
+	"\treturn strcmp (x->name, ((const entry *) b)->name);\n",
+	"}\n",
+	"#define MAX(a, b) ((a) > (b) ? (a) : (b))\n",
+	"\n"
+};
+
+static const char *const Words [] = {
+	"if", "while", "struct", "return", "typedef", "static", "unsigned",
+	"const", "entry", "count", "name", "buffer", "compareEntries", "x",
+	"result", "value"
+};
+
+static const char *const SqlWords [] = {
+	"SELECT", "Begin", "procedure", "Create", "TABLE", "end", "tbl_orders",
+	"CustomerId", "v_total", "ix_name"
+};
+
+static const char *const Pieces [] = {
+	"compareEntries", " (const ", "void *a", ");\n"
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*
+ *  Benchmarks
+ */
+
+static unsigned long lookupKeywords (const unsigned long count)
+{
+	const unsigned int words = sizeof (Words) / sizeof (Words [0]);
+	unsigned long i;
+	unsigned int w;
+
+	for (i = 0  ;  i < count  ;  ++i)
+		for (w = 0  ;  w < words  ;  ++w)
+			Sink += (unsigned long) lookupKeyword (Words [w], LangC);
+	return count * words;
+}
+
+static unsigned long analyzeTokens (const unsigned long count)
+{
+	const unsigned int words = sizeof (SqlWords) / sizeof (SqlWords [0]);
+	unsigned long i;
+	unsigned int w;
+
+	for (i = 0  ;  i < count  ;  ++i)
+		for (w = 0  ;  w < words  ;  ++w)
+			Sink += (unsigned long) analyzeToken (Tokens [w], LangSql);
+	return count * words;
+}
+
+static unsigned long putCharacters (const unsigned long count)
+{
+	unsigned long i;
+	int c;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		vStringClear (String);
+		for (c = 0  ;  c < 64  ;  ++c)
+			vStringPut (String, 'a' + c % 26);
+		Sink += vStringLength (String);
+	}
+	return count * 64;
+}
+
+static unsigned long catenateStrings (const unsigned long count)
+{
+	unsigned long i;
+	unsigned int p;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		vStringClear (String);
+		for (p = 0  ;  p < 16  ;  ++p)
+			vStringCatS (String, Pieces [p % 4]);
+		Sink += vStringLength (String);
+	}
+	return count * 16;
+}
+
+static void openSource (void)
+{
+	if (! fileOpen (SourceName, LangC))
+		error (FATAL, "cannot open \"%s\"", SourceName);
+}
+
+static unsigned long readCharacters (const unsigned long count)
+{
+	unsigned long characters = 0;
+	unsigned long i;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		openSource ();
+		while (fileGetc () != EOF)
+			++characters;
+		fileClose ();
+	}
+	return characters;
+}
+
+static unsigned long readPreprocessed (const unsigned long count)
+{
+	unsigned long characters = 0;
+	unsigned long i;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		openSource ();
+		cppInit (FALSE, FALSE);
+		while (cppGetc () != EOF)
+			++characters;
+		cppTerminate ();
+		fileClose ();
+	}
+	return characters;
+}
+
+/*  Tags are written to the start of the tag file for each sample, lest it
+ *  grow without limit.
+ */
+static void rewindTagFile (void)
+{
+	rewind (TagFile.fp);
+}
+
+#ifdef HAVE_REGEX
+static unsigned long matchLines (const unsigned long count)
+{
+	unsigned long i;
+	unsigned int n;
+
+	openSource ();
+	for (i = 0  ;  i < count  ;  ++i)
+		for (n = 0  ;  n < SourceLineCount  ;  ++n)
+			Sink += (unsigned long) matchRegex (SourceLines [n], LangC);
+	fileClose ();
+	return count * SourceLineCount;
+}
+#endif
+
+/*  Makes tags in the ctags format, through makeTagEntry (), which adds
+ *  little to writeCtagsEntry () when no other output options are set.
+ */
+static unsigned long writeEntries (const unsigned long count)
+{
+	const unsigned int words = sizeof (Words) / sizeof (Words [0]);
+	tagEntryInfo e;
+	unsigned long i;
+
+	openSource ();
+	fileReadLine ();
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		initTagEntry (&e, Words [i % words]);
+		e.kindName = "function";
+		e.kind     = 'f';
+		makeTagEntry (&e);
+	}
+	fileClose ();
+	return count;
+}
+
+#ifndef EXTERNAL_SORT
+static void writeUnsortedTags (void)
+{
+	FILE *const fp = fopen (tagFileName (), "w");
+	unsigned long i;
+
+	if (fp == NULL)
+		error (FATAL | PERROR, "cannot write \"%s\"", tagFileName ());
+	for (i = 0  ;  i < SORT_COUNT  ;  ++i)
+	{
+		const unsigned long n = (i * 7919UL) % SORT_COUNT;
+		fprintf (fp, "t%06lu\tfile%lu.c\t/^int t%06lu (void)$/;\"\tf\n",
+				n, n % 100, n);
+	}
+	fclose (fp);
+	TagFile.numTags.added = SORT_COUNT;
+	TagFile.numTags.prev = 0;
+}
+
+static unsigned long sortTags (const unsigned long count)
+{
+	internalSortTags (FALSE);
+	return count * SORT_COUNT;
+}
+#endif
+
+static const microBenchmark Benchmarks [] = {
+	{ "lookupKeyword",   "lookup",    NULL,          lookupKeywords,   FALSE },
+	{ "analyzeToken",    "token",     NULL,          analyzeTokens,    FALSE },
+	{ "vStringPut",      "character", NULL,          putCharacters,    FALSE },
+	{ "vStringCatS",     "string",    NULL,          catenateStrings,  FALSE },
+	{ "fileGetc",        "character", NULL,          readCharacters,   FALSE },
+	{ "cppGetc",         "character", NULL,          readPreprocessed, FALSE },
+#ifdef HAVE_REGEX
+	{ "matchRegex",      "line",      rewindTagFile, matchLines,       FALSE },
+#endif
+	{ "writeCtagsEntry", "tag",       rewindTagFile, writeEntries,     FALSE },
+#ifndef EXTERNAL_SORT
+	{ "internalSortTags", "line", writeUnsortedTags, sortTags,         TRUE },
+#endif
+};
+
+/*
+ *  Measurement
+ */
+
+static double timeSample (const microBenchmark *const bench,
+		const unsigned long count, unsigned long *const operations)
+{
+	double start;
+
+	if (bench->prepare != NULL)
+		bench->prepare ();
+	start = wallClock ();
+	*operations = bench->run (count);
+	return wallClock () - start;
+}
+
+static int compareTimes (const void *const a, const void *const b)
+{
+	const double x = *(const double *) a;
+	const double y = *(const double *) b;
+	return (x > y) - (x < y);
+}
+
+static double median (double *const values, const unsigned int count)
+{
+	qsort (values, count, sizeof (double), compareTimes);
+	if (count % 2 == 1)
+		return values [count / 2];
+	else
+		return (values [count / 2 - 1] + values [count / 2]) / 2.0;
+}
+
+static void measure (const microBenchmark *const bench)
+{
+	double *const times = xMalloc (Samples, double);
+	double *const deviations = xMalloc (Samples, double);
+	unsigned long count = 1;
+	unsigned long operations;
+	double middle, fastest;
+	unsigned int i;
+
+	/*  Calibrate, which also serves to warm the caches.
+	 */
+	if (! bench->single)
+	{
+		while (timeSample (bench, count, &operations) < MinimumSampleTime  &&
+			   count < 0x40000000UL)
+			count *= 2;
+	}
+	else
+		timeSample (bench, count, &operations);
+
+	for (i = 0  ;  i < Samples  ;  ++i)
+	{
+		const double seconds = timeSample (bench, count, &operations);
+		times [i] = seconds * 1.0e9 / (double) (operations > 0 ? operations : 1);
+	}
+	middle = median (times, Samples);
+	fastest = times [0];
+	for (i = 0  ;  i < Samples  ;  ++i)
+		deviations [i] = times [i] > middle ? times [i] - middle : middle - times [i];
+	printf ("%-18s %-10s %12.2f %7.1f%% %12.2f %10lu x %u\n",
+			bench->name, bench->unit, middle,
+			middle > 0.0 ? median (deviations, Samples) * 100.0 / middle : 0.0,
+			fastest, count, Samples);
+	fflush (stdout);
+	eFree (times);
+	eFree (deviations);
+}
+
+/*
+ *  Set up
+ */
+
+static void writeSource (void)
+{
+	const unsigned int lines = sizeof (SourceText) / sizeof (SourceText [0]);
+	FILE *const fp = tempFile ("w", &SourceName);
+	unsigned int allocated = 0;
+	long size = 0;
+	unsigned int i = 0;
+
+	while (size < SOURCE_SIZE)
+	{
+		const char *const text = SourceText [i++ % lines];
+
+		fputs (text, fp);
+		size += (long) strlen (text);
+		if (SourceLineCount == allocated)
+		{
+			allocated = allocated == 0 ? 1024 : allocated * 2;
+			SourceLines = xRealloc (SourceLines, allocated, vString *);
+		}
+		SourceLines [SourceLineCount] = vStringNewInit (text);
+		++SourceLineCount;
+	}
+	if (fclose (fp) != 0)
+		error (FATAL | PERROR, "cannot write \"%s\"", SourceName);
+}
+
+static void setUp (const char *const program)
+{
+	cookedArgs *args;
+	unsigned int i;
+
+	setCurrentDirectory ();
+	setExecutableName (program);
+	checkRegex ();
+	initializeParsing ();
+	initOptions ();
+	LangC = getNamedLanguage ("c");
+	LangSql = getNamedLanguage ("sql");
+#ifdef HAVE_REGEX
+	addLanguageRegex (LangC, "/^#define[ \t]+([A-Za-z_][A-Za-z0-9_]*)/\\1/d,definition/");
+#endif
+	String = vStringNew ();
+	for (i = 0  ;  i < sizeof (SqlWords) / sizeof (SqlWords [0])  ;  ++i)
+		Tokens [i] = vStringNewInit (SqlWords [i]);
+	writeSource ();
+
+	/*  Tags are written to a temporary tag file, as with "-f -".
+	 */
+	args = cArgNewFromString ("-f -");
+	parseOptions (args);
+	cArgDelete (args);
+	openTagFile ();
+}
+
+static void tearDown (void)
+{
+	unsigned int i;
+
+	fclose (TagFile.fp);
+	TagFile.fp = NULL;
+	remove (TagFile.name);
+	remove (SourceName);
+	eFree (SourceName);
+	for (i = 0  ;  i < SourceLineCount  ;  ++i)
+		vStringDelete (SourceLines [i]);
+	eFree (SourceLines);
+	for (i = 0  ;  i < sizeof (SqlWords) / sizeof (SqlWords [0])  ;  ++i)
+		vStringDelete (Tokens [i]);
+	vStringDelete (String);
+	freeTagFileResources ();
+	freeKeywordTable ();
+	freeRoutineResources ();
+	freeSourceFileResources ();
+	freeOptionResources ();
+	freeParserResources ();
+	freeRegexResources ();
+}
+
+static boolean isSelected (const char *const name, char **const names)
+{
+	boolean selected = (boolean) (*names == NULL);
+	char **p;
+
+	for (p = names  ;  *p != NULL  &&  ! selected  ;  ++p)
+		if (strcmp (*p, name) == 0)
+			selected = TRUE;
+	return selected;
+}
+
+static void usage (const char *const program)
+{
+	fprintf (stderr,
+		"Usage: %s [-s samples] [-t milliseconds] [-l] [benchmark...]\n", program);
+	exit (1);
+}
+
+extern int main (int argc, char **argv)
+{
+	const unsigned int count = sizeof (Benchmarks) / sizeof (Benchmarks [0]);
+	const char *const program = argv [0];
+	boolean list = FALSE;
+	char *tagsName;
+	unsigned int i;
+
+	while (argc > 1  &&  argv [1][0] == '-')
+	{
+		if (strcmp (argv [1], "-l") == 0)
+			list = TRUE;
+		else if (argc > 2  &&  strcmp (argv [1], "-s") == 0)
+		{
+			Samples = (unsigned int) atoi (argv [2]);
+			++argv;  --argc;
+		}
+		else if (argc > 2  &&  strcmp (argv [1], "-t") == 0)
+		{
+			MinimumSampleTime = atof (argv [2]) / 1000.0;
+			++argv;  --argc;
+		}
+		else
+			usage (program);
+		++argv;  --argc;
+	}
+	if (Samples < 1)
+		usage (program);
+	++argv;
+	if (list)
+	{
+		for (i = 0  ;  i < count  ;  ++i)
+			puts (Benchmarks [i].name);
+		for (i = 0  ;  i < ReadTagsBenchmarkCount  ;  ++i)
+			puts (ReadTagsBenchmarks [i].name);
+		return 0;
+	}
+
+	setUp (program);
+	printf ("%-18s %-10s %12s %8s %12s %s\n", "benchmark", "operation",
+			"median ns", "MAD", "fastest ns", "iterations x samples");
+	for (i = 0  ;  i < count  ;  ++i)
+		if (isSelected (Benchmarks [i].name, argv))
+			measure (Benchmarks + i);
+
+	fclose (tempFile ("w", &tagsName));
+	if (! beginReadTagsBenchmarks (tagsName))
+		error (FATAL | PERROR, "cannot open \"%s\"", tagsName);
+	for (i = 0  ;  i < ReadTagsBenchmarkCount  ;  ++i)
+		if (isSelected (ReadTagsBenchmarks [i].name, argv))
+			measure (ReadTagsBenchmarks + i);
+	endReadTagsBenchmarks ();
+	remove (tagsName);
+	eFree (tagsName);
+
+	tearDown ();
+	return 0;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
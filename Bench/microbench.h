@@ -0,0 +1,48 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   Interface between the micro-benchmark driver (microbench.c) and the
+*   benchmarks of the readtags library (microtags.c), which are kept apart
+*   because readtags.h and entry.h each define a type named tagFile.
+*/
+#ifndef _MICROBENCH_H
+#define _MICROBENCH_H
+
+/*
+*   DATA DECLARATIONS
+*/
+
+/*  A benchmark of one primitive. Its run function performs `count'
+ *  iterations and returns the number of operations performed, by which the
+ *  time taken is divided. Unless NULL, its prepare function is called, untimed,
+ *  before each sample. A single benchmark is run for one iteration per
+ *  sample, rather than for as many as fill the minimum sample time.
+ */
+typedef struct sMicroBenchmark {
+	const char *name;       /* name by which it is selected */
+	const char *unit;       /* the operation timed */
+	void (*prepare) (void);
+	unsigned long (*run) (const unsigned long count);
+	int single;
+} microBenchmark;
+
+/*
+*   GLOBAL VARIABLES
+*/
+extern const microBenchmark ReadTagsBenchmarks [];
+extern const unsigned int ReadTagsBenchmarkCount;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern int beginReadTagsBenchmarks (const char *const path);
+extern void endReadTagsBenchmarks (void);
+
+#endif  /* _MICROBENCH_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
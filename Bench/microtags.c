@@ -0,0 +1,99 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains the micro-benchmarks of the readtags library (see
+*   microbench.c).
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "readtags.h"
+#include "microbench.h"
+
+/*
+*   MACROS
+*/
+#define TAG_COUNT    50000
+#define NAME_LENGTH  8
+
+/*
+*   DATA DEFINITIONS
+*/
+static tagFile *Tags = NULL;
+static char (*Names) [NAME_LENGTH] = NULL;
+static volatile unsigned long Found;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*  Looks up tags by name with a binary search of the sorted tag file,
+ *  visiting the names in an order unrelated to that of the file.
+ */
+static unsigned long findTags (const unsigned long count)
+{
+	tagEntry entry;
+	unsigned long i;
+
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const char *const name = Names [(i * 7919UL) % TAG_COUNT];
+
+		if (tagsFind (Tags, &entry, name, TAG_FULLMATCH) == TagSuccess)
+			++Found;
+	}
+	return count;
+}
+
+/*  Writes a sorted tag file of TAG_COUNT tags to `path' and opens it.
+ *  Returns zero on failure.
+ */
+extern int beginReadTagsBenchmarks (const char *const path)
+{
+	tagFileInfo info;
+	FILE *fp;
+	unsigned int i;
+
+	Names = malloc (TAG_COUNT * sizeof (*Names));
+	fp = fopen (path, "w");
+	if (Names == NULL  ||  fp == NULL)
+		return 0;
+	fputs ("!_TAG_FILE_FORMAT\t2\t/extended format/\n", fp);
+	fputs ("!_TAG_FILE_SORTED\t1\t/0=unsorted, 1=sorted, 2=foldcase/\n", fp);
+	for (i = 0  ;  i < TAG_COUNT  ;  ++i)
+	{
+		sprintf (Names [i], "t%06u", i);
+		fprintf (fp, "%s\tfile%u.c\t/^int %s (void)$/;\"\tf\n",
+				Names [i], i % 100, Names [i]);
+	}
+	if (fclose (fp) != 0)
+		return 0;
+	Tags = tagsOpen (path, &info);
+	return Tags != NULL;
+}
+
+extern void endReadTagsBenchmarks (void)
+{
+	if (Tags != NULL)
+		tagsClose (Tags);
+	Tags = NULL;
+	free (Names);
+	Names = NULL;
+}
+
+const microBenchmark ReadTagsBenchmarks [] = {
+	{ "tagsFind", "search", NULL, findTags, 0 }
+};
+const unsigned int ReadTagsBenchmarkCount =
+		sizeof (ReadTagsBenchmarks) / sizeof (ReadTagsBenchmarks [0]);
+
+/* vi:set tabstop=4 shiftwidth=4: */
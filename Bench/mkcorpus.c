@@ -0,0 +1,401 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This program writes the synthetic source corpus tagged by "make bench"
+*   (see benchmark.mak). Each language is given a directory of files written
+*   to resemble the input which is hardest on its parser: C and C++ dense
+*   with preprocessor conditionals and macros, minified JavaScript on very
+*   long lines, long SQL scripts, fixed-form Fortran and Python. The contents
+*   of each file depend only upon its name, so that the corpus is the same on
+*   every machine and a larger scale only adds files to a smaller one.
+*
+*   Usage: mkcorpus directory [scale]
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/*
+*   MACROS
+*/
+#define NAME_LENGTH  48
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef void (*writer) (FILE *const fp, const long size);
+
+typedef struct sCorpusLanguage {
+	const char *directory;  /* subdirectory of the corpus */
+	const char *extension;  /* extension of its files */
+	writer write;           /* writes the contents of one file */
+	int files;              /* number of files at scale 1 */
+	long size;              /* approximate size of each file */
+} corpusLanguage;
+
+/*
+*   DATA DEFINITIONS
+*/
+static unsigned long Seed;
+
+static const char *const Syllables [] = {
+	"ab", "al", "ar", "ba", "be", "co", "da", "de", "el", "en", "fo", "ga",
+	"in", "ka", "lo", "ma", "ne", "or", "pa", "qu", "re", "si", "ta", "un",
+	"ve", "xi", "yo", "ze"
+};
+
+static const char *const CTypes [] = {
+	"int", "long", "unsigned int", "char *", "const char *", "double",
+	"size_t", "void *"
+};
+
+static const char *const SqlTypes [] = {
+	"INTEGER", "NUMBER(10)", "VARCHAR2(40)", "CHAR(1)", "DATE", "CLOB"
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*  Returns a pseudo-random number below `limit' (at most 65536). A generator
+ *  of our own is used in place of rand () so that the corpus does not depend
+ *  upon the C library.
+ */
+static unsigned int nextRandom (const unsigned int limit)
+{
+	Seed = (Seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+	return (unsigned int) ((Seed >> 16) % limit);
+}
+
+static void setSeed (const unsigned int language, const unsigned int file)
+{
+	Seed = (unsigned long) language * 7919UL + (unsigned long) file * 104729UL + 1UL;
+}
+
+/*  Makes an identifier of two to four syllables, capitalizing each syllable
+ *  after the first if `camel' is set, and appending a number.
+ */
+static const char *makeName (char *const buffer, const char *const prefix,
+		const int camel)
+{
+	const unsigned int count = 2 + nextRandom (3);
+	unsigned int i;
+
+	strcpy (buffer, prefix);
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		char *const end = buffer + strlen (buffer);
+
+		strcpy (end, Syllables [nextRandom (sizeof (Syllables) / sizeof (Syllables [0]))]);
+		if (camel  &&  (i > 0  ||  *prefix != '\0'))
+			*end = (char) toupper ((unsigned char) *end);
+	}
+	sprintf (buffer + strlen (buffer), "%u", nextRandom (1000));
+	return buffer;
+}
+
+static const char *upperName (char *const buffer, const char *const prefix)
+{
+	char *p;
+
+	makeName (buffer, prefix, 0);
+	for (p = buffer  ;  *p != '\0'  ;  ++p)
+		*p = (char) toupper ((unsigned char) *p);
+	return buffer;
+}
+
+/*  Fortran 77 names are kept to six characters.
+ */
+static const char *fortranName (char *const buffer)
+{
+	upperName (buffer, "");
+	if (strlen (buffer) > 6)
+		buffer [6] = '\0';
+	return buffer;
+}
+
+static void writeC (FILE *const fp, const long size)
+{
+	char guard [NAME_LENGTH], name [NAME_LENGTH], other [NAME_LENGTH];
+
+	fprintf (fp, "#ifndef %s\n#define %s\n\n", upperName (guard, "_H_"), guard);
+	fputs ("#include <stdio.h>\n#include <stdlib.h>\n#include \"config.h\"\n\n", fp);
+	while (ftell (fp) < size)
+	{
+		const char *const type = CTypes [nextRandom (sizeof (CTypes) / sizeof (CTypes [0]))];
+
+		fprintf (fp, "#define %s %u\n", upperName (name, "MAX_"), nextRandom (4096));
+		fprintf (fp, "#define %s(a, b) ((a) > (b) ? (a) : (b))\n",
+				upperName (name, ""));
+		fprintf (fp, "#define %s(x) \\\n\tdo { \\\n\t\t(x) += %u; \\\n\t} while (0)\n\n",
+				upperName (name, "BUMP_"), nextRandom (16));
+		fprintf (fp, "#if defined (%s) && %s > %u\n",
+				upperName (other, "HAVE_"), other, nextRandom (8));
+		fprintf (fp, "typedef struct s%s {\n\t%s %s;\n\tlong count;\n} %s;\n",
+				makeName (name, "", 1), type, makeName (other, "", 0), name);
+		fprintf (fp, "#elif defined (%s)\n", upperName (other, "USE_"));
+		fprintf (fp, "typedef struct s%s {\n\tint %s;\n} %s;\n#else\n",
+				name, makeName (other, "", 0), name);
+		fprintf (fp, "typedef %s %s;\n#endif\n\n", type, name);
+		fprintf (fp, "enum e%s {\n\t%s, %s = %u,\n\t%s\n};\n\n",
+				makeName (name, "", 1), upperName (other, "K_"),
+				upperName (guard, "K_"), nextRandom (64), upperName (name, "K_"));
+		fprintf (fp, "extern %s %s (const void *const item, int flags);\n",
+				type, makeName (name, "", 1));
+		fprintf (fp, "static %s %s (int %s, const char *%s)\n{\n",
+				type, makeName (name, "", 1), makeName (other, "", 0),
+				makeName (guard, "", 0));
+		fprintf (fp, "#ifdef DEBUG\n\tprintf (\"%%s: %%d {\\n\", %s, %s);\n#endif\n",
+				guard, other);
+		fprintf (fp, "\tif (%s > %u)\n\t{\n#if %u\n\t\treturn (%s) 0;\n#else\n\t\treturn (%s) %s;\n#endif\n\t}\n",
+				other, nextRandom (100), nextRandom (2), type, type, other);
+		fprintf (fp, "\treturn (%s) %s;\n}\n\n", type, guard);
+		if (nextRandom (4) == 0)
+			fprintf (fp, "#if 0\nstatic int %s (void) { return %u; }\n#endif\n\n",
+					makeName (name, "", 1), nextRandom (10));
+	}
+	fputs ("#endif\n", fp);
+}
+
+static void writeCpp (FILE *const fp, const long size)
+{
+	char space [NAME_LENGTH], name [NAME_LENGTH], other [NAME_LENGTH];
+
+	fputs ("#include <vector>\n#include <string>\n\n", fp);
+	while (ftell (fp) < size)
+	{
+		fprintf (fp, "namespace %s {\n\n", makeName (space, "", 0));
+		fprintf (fp, "#ifdef %s\n", upperName (other, "WITH_"));
+		fprintf (fp, "template <typename T>\nclass %s : public std::vector<T> {\n#else\n",
+				makeName (name, "C", 1));
+		fprintf (fp, "template <typename T>\nclass %s {\n#endif\npublic:\n", name);
+		fprintf (fp, "\t%s ();\n\tvirtual ~%s ();\n", name, name);
+		fprintf (fp, "\tint %s (int a) const { return a * %u; }\n",
+				makeName (other, "", 1), nextRandom (10));
+		fprintf (fp, "\tstatic std::string %s (const T& t);\n", makeName (other, "", 1));
+		fprintf (fp, "private:\n\tT %s_;\n\tint %s_;\n};\n\n",
+				makeName (other, "", 0), makeName (other, "", 0));
+		fprintf (fp, "template <typename T>\nint %s<T>::%s (int x)\n{\n\treturn x + %u;\n}\n\n",
+				name, makeName (other, "", 1), nextRandom (100));
+		fprintf (fp, "struct %s\n{\n\tenum { %s, %s };\n\tunsigned %s : %u;\n};\n\n",
+				makeName (name, "S", 1), upperName (other, "E_"),
+				upperName (space, "E_"), makeName (other, "", 0), 1 + nextRandom (7));
+		fputs ("}\n\n", fp);
+	}
+}
+
+/*  Minified script is written on lines of some thousands of characters, as
+ *  it is found in bundled sources. Since each tag repeats its line as its
+ *  search pattern, longer lines soon make the tag file many times larger
+ *  than the corpus.
+ */
+static void writeJavaScript (FILE *const fp, const long size)
+{
+	char name [NAME_LENGTH], other [NAME_LENGTH];
+	unsigned int units = 0;
+
+	fputs ("\"use strict\";", fp);
+	while (ftell (fp) < size)
+	{
+		switch (nextRandom (5))
+		{
+			case 0:
+				fprintf (fp, "function %s(a,b){if(a>b){return a-b}return \"}\"+b}",
+						makeName (name, "", 1));
+				break;
+			case 1:
+				fprintf (fp, "var %s=function(c){return c*%u};",
+						makeName (name, "", 1), nextRandom (100));
+				break;
+			case 2:
+				fprintf (fp, "%s.prototype.%s=function(){return this.%s};",
+						makeName (name, "", 1), makeName (other, "", 1),
+						makeName (other, "", 0));
+				break;
+			case 3:
+				fprintf (fp, "var %s={%s:function(d){return d},%s:%u,s:'{'};",
+						makeName (name, "", 1), makeName (other, "", 0),
+						makeName (other, "", 0), nextRandom (1000));
+				break;
+			default:
+				fprintf (fp, "%s.%s=function(e,f){for(var i=0;i<e;i++){f(i)}};",
+						makeName (name, "", 1), makeName (other, "", 1));
+				break;
+		}
+		if (++units % 50 == 0)
+			putc ('\n', fp);
+	}
+	putc ('\n', fp);
+}
+
+static void writeSql (FILE *const fp, const long size)
+{
+	char table [NAME_LENGTH], name [NAME_LENGTH], column [NAME_LENGTH];
+	unsigned int i;
+
+	while (ftell (fp) < size)
+	{
+		fprintf (fp, "CREATE TABLE %s (\n    id INTEGER PRIMARY KEY",
+				makeName (table, "t_", 0));
+		for (i = 0  ;  i < 3 + nextRandom (6)  ;  ++i)
+			fprintf (fp, ",\n    %s %s", makeName (column, "", 0),
+					SqlTypes [nextRandom (sizeof (SqlTypes) / sizeof (SqlTypes [0]))]);
+		fputs ("\n);\n\n", fp);
+		fprintf (fp, "CREATE INDEX %s ON %s (%s);\n\n",
+				makeName (name, "ix_", 0), table, column);
+		fprintf (fp, "CREATE OR REPLACE VIEW %s AS\n    SELECT id, %s FROM %s WHERE id > %u;\n\n",
+				makeName (name, "v_", 0), column, table, nextRandom (1000));
+		fprintf (fp, "CREATE OR REPLACE PROCEDURE %s (p_id IN NUMBER) IS\n",
+				makeName (name, "p_", 0));
+		fprintf (fp, "    %s NUMBER := 0;\nBEGIN\n", makeName (column, "l_", 0));
+		fprintf (fp, "    UPDATE %s SET id = id + 1 WHERE id = p_id;\n", table);
+		fprintf (fp, "    %s := %s + 1;\nEND %s;\n/\n\n", column, column, name);
+		fprintf (fp, "CREATE OR REPLACE FUNCTION %s (p_value IN VARCHAR2)\n"
+				"RETURN NUMBER IS\nBEGIN\n    RETURN LENGTH (p_value);\nEND %s;\n/\n\n",
+				makeName (name, "f_", 0), name);
+		for (i = 0  ;  i < 20 + nextRandom (40)  ;  ++i)
+			fprintf (fp, "INSERT INTO %s (id) VALUES (%u);\n", table, nextRandom (60000));
+		putc ('\n', fp);
+	}
+}
+
+/*  Fixed-form Fortran, with statements in columns 7 to 72, comment lines
+ *  marked in column 1 and continuation lines in column 6.
+ */
+static void writeFortran (FILE *const fp, const long size)
+{
+	char name [NAME_LENGTH], a [NAME_LENGTH], b [NAME_LENGTH];
+	unsigned int label = 10;
+
+	fprintf (fp, "      PROGRAM %s\n      CALL INIT\n      END\n\n", fortranName (name));
+	while (ftell (fp) < size)
+	{
+		fprintf (fp, "C     %s computes a new table.\n", fortranName (name));
+		fprintf (fp, "      SUBROUTINE %s(%s, %s, N)\n", name, fortranName (a), fortranName (b));
+		fprintf (fp, "      INTEGER N, I\n      REAL %s(N), %s(N)\n", a, b);
+		fprintf (fp, "      COMMON /%s/ X, Y\n", fortranName (name));
+		fprintf (fp, "      DO %u I = 1, N\n", label);
+		fprintf (fp, "         %s(I) = %s(I) * %u.0\n     &           + X\n", a, b, nextRandom (10));
+		fprintf (fp, "%5u CONTINUE\n      RETURN\n      END\n\n", label);
+		fprintf (fp, "      REAL FUNCTION %s(Z)\n      REAL Z\n", fortranName (name));
+		fprintf (fp, "*     Square the argument\n      %s = Z * Z + %u.0\n      END\n\n",
+				name, nextRandom (100));
+		fprintf (fp, "      BLOCK DATA %s\n      COMMON /%s/ X, Y\n", fortranName (name),
+				fortranName (a));
+		fprintf (fp, "      DATA X, Y /%u.0, %u.0/\n      END\n\n", nextRandom (10), nextRandom (10));
+		label = 10 + (label + 10) % 9000;
+	}
+}
+
+static void writePython (FILE *const fp, const long size)
+{
+	char name [NAME_LENGTH], other [NAME_LENGTH];
+	unsigned int i;
+
+	fputs ("import os\nimport sys\n\n", fp);
+	while (ftell (fp) < size)
+	{
+		fprintf (fp, "class %s(%s):\n", makeName (name, "C", 1),
+				nextRandom (2) ? "object" : "dict");
+		fprintf (fp, "    \"\"\"Holds the state of a %s.\n\n    def not_a_method(self): pass\n    \"\"\"\n",
+				makeName (other, "", 0));
+		fprintf (fp, "    %s = %u\n\n", makeName (other, "", 0), nextRandom (100));
+		fputs ("    def __init__(self, a, b=None):\n        self.a = a\n\n", fp);
+		for (i = 0  ;  i < 2 + nextRandom (4)  ;  ++i)
+		{
+			if (nextRandom (3) == 0)
+				fputs ("    @property\n", fp);
+			fprintf (fp, "    def %s(self, *args, **kwargs):\n", makeName (other, "", 0));
+			fprintf (fp, "        return [x for x in args if x > %u]\n\n", nextRandom (10));
+		}
+		fprintf (fp, "def %s(value, %s=(1, 2)):\n", makeName (name, "", 0),
+				makeName (other, "", 0));
+		fprintf (fp, "    def %s(x):\n        return x + %u\n", makeName (other, "_", 0),
+				nextRandom (10));
+		fprintf (fp, "    return %s(value)\n\n", other);
+		fprintf (fp, "%s = lambda y: y * %u\n\n", upperName (name, ""), nextRandom (10));
+	}
+}
+
+static const corpusLanguage Languages [] = {
+	{ "c",          ".c",   writeC,          24, 65536L },
+	{ "c++",        ".cpp", writeCpp,        16, 65536L },
+	{ "javascript", ".js",  writeJavaScript,  4, 262144L },
+	{ "sql",        ".sql", writeSql,        16, 65536L },
+	{ "fortran",    ".f",   writeFortran,    16, 65536L },
+	{ "python",     ".py",  writePython,     16, 65536L }
+};
+
+static void makeDirectory (const char *const path)
+{
+	if (mkdir (path, 0777) != 0  &&  errno != EEXIST)
+	{
+		perror (path);
+		exit (1);
+	}
+}
+
+int main (int argc, char **argv)
+{
+	const unsigned int count = sizeof (Languages) / sizeof (Languages [0]);
+	char path [1024];
+	int scale = 1;
+	unsigned int i;
+
+	if (argc < 2  ||  argc > 3  ||  (argc == 3  &&  (scale = atoi (argv [2])) < 1))
+	{
+		fprintf (stderr, "Usage: %s directory [scale]\n", argv [0]);
+		return 1;
+	}
+	if (strlen (argv [1]) + 64 > sizeof (path))
+	{
+		fprintf (stderr, "%s: directory name too long\n", argv [0]);
+		return 1;
+	}
+	makeDirectory (argv [1]);
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const corpusLanguage *const language = Languages + i;
+		const unsigned int files = (unsigned int) (language->files * scale);
+		unsigned int f;
+
+		sprintf (path, "%s/%s", argv [1], language->directory);
+		makeDirectory (path);
+		for (f = 0  ;  f < files  ;  ++f)
+		{
+			FILE *fp;
+
+			sprintf (path, "%s/%s/file%04u%s", argv [1], language->directory,
+					f, language->extension);
+			fp = fopen (path, "w");
+			if (fp == NULL)
+			{
+				perror (path);
+				return 1;
+			}
+			setSeed (i, f);
+			language->write (fp, language->size);
+			if (fclose (fp) != 0)
+			{
+				perror (path);
+				return 1;
+			}
+		}
+	}
+	return 0;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
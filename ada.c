@@ -2188,6 +2188,7 @@ static void findAdaTags(void)
   readNewLine();
 
   /* tokenize entire file */
+  catchParseTimeout(&eofError, EXCEPTION_EOF);
   exception = setjmp(eofError);
   while(exception != EXCEPTION_EOF && adaParse(ADA_ROOT, &root) != NULL);
 
@@ -0,0 +1,53 @@
+#	$Id$
+#
+#	Copyright (c) 2026
+#
+#	Benchmarking makefile for Exuberant Ctags, measuring its speed and memory
+#	use on a synthetic corpus against a stored baseline (see Bench/bench.sh).
+#	Requires GNU make.
+
+CTAGS_BENCH = ./ctags
+BENCH_DIR = Bench
+BENCH_CORPUS = bench.corpus
+BENCH_SCALE = 4
+BENCH_RUNS = 3
+BENCH_BASELINE = $(BENCH_DIR)/baseline
+BENCH_THRESHOLD = 10
+MKCORPUS = ./mkcorpus
+MICROBENCH = ./microbench
+MICROBENCH_OPTIONS =
+
+BENCH_STAMP = $(BENCH_CORPUS)/.scale-$(BENCH_SCALE)
+BENCH_ARGS = $(CTAGS_BENCH) $(BENCH_CORPUS) $(BENCH_SCALE) $(BENCH_RUNS) \
+			 $(BENCH_BASELINE) $(BENCH_THRESHOLD)
+
+.PHONY: bench bench-baseline bench-corpus bench-micro clean-bench
+
+bench: $(CTAGS_BENCH) $(BENCH_STAMP)
+	@ sh $(BENCH_DIR)/bench.sh $(BENCH_ARGS)
+
+bench-baseline: $(CTAGS_BENCH) $(BENCH_STAMP)
+	@ sh $(BENCH_DIR)/bench.sh $(BENCH_ARGS) record
+
+bench-corpus: $(BENCH_STAMP)
+
+#	Times the primitives of ctags one at a time (see Bench/microbench.c);
+#	MICROBENCH_OPTIONS may name those to be timed.
+bench-micro: $(MICROBENCH)
+	@ $(MICROBENCH) $(MICROBENCH_OPTIONS)
+
+$(BENCH_STAMP): $(MKCORPUS)
+	@ echo "Generating benchmark corpus (scale $(BENCH_SCALE))"
+	@ rm -rf $(BENCH_CORPUS)
+	@ $(MKCORPUS) $(BENCH_CORPUS) $(BENCH_SCALE)
+	@ touch $@
+
+$(MKCORPUS): $(BENCH_DIR)/mkcorpus.c
+	$(CC) $(CFLAGS) -o $@ $(BENCH_DIR)/mkcorpus.c
+
+BENCH_ARTIFACTS = $(MKCORPUS) $(BENCH_CORPUS) bench.tags bench.tags.run bench.results
+
+clean-bench:
+	rm -rf $(BENCH_ARTIFACTS)
+
+# vi:ts=4 sw=4
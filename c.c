@@ -44,6 +44,10 @@
 
 #define isHighChar(c)       ((c) != EOF && (unsigned char)(c) >= 0xc0)
 
+/*  Least number of lines between checkpoints (see takeCheckpoint ()).
+ */
+#define CHECKPOINT_INTERVAL 64
+
 /*
 *   DATA DECLARATIONS
 */
@@ -281,8 +285,15 @@ static langType Lang_vera;
 static vString *Signature;
 static boolean CollectingSignature;
 
-/* Number used to uniquely identify anonymous structs and unions. */
-static int AnonymousID = 0;
+/*  The last top level statement boundary from which parsing may resume
+ *  using brace formatting, rather than starting again.
+ */
+static struct sCheckpoint {
+	boolean valid;
+	boolean frozen;            /* no further checkpoints may be taken */
+	unsigned long lineNumber;  /* input line at which it was taken */
+	unsigned int anonymousCount;  /* value of getAnonymousCount () */
+} Checkpoint;
 
 /* Used to index into the CKinds table. */
 typedef enum {
@@ -1385,6 +1396,52 @@ static void qualifyVariableTag (const statementInfo *const st,
 	}
 }
 
+/*
+*   Checkpoints
+*/
+
+/*  Called at the end of each top level statement. When a brace formatting
+ *  error is later found, the tags made after the last checkpoint are
+ *  discarded and parsing resumes from it using brace formatting, so that
+ *  only the rest of the file is parsed again. Checkpoints are taken at most
+ *  once every CHECKPOINT_INTERVAL lines, to keep their cost negligible, and
+ *  none after a brace is matched across levels of a #if conditional, since
+ *  brace formatting may match it differently (see freezeCheckpoint ()).
+ */
+static void takeCheckpoint (void)
+{
+	if (! isBraceFormat ()  &&  ! Checkpoint.frozen  &&
+		getInputLineNumber () >= Checkpoint.lineNumber + CHECKPOINT_INTERVAL  &&
+		checkpointTagEntries ())
+	{
+		fileCheckpoint ();
+		cppCheckpoint ();
+		Checkpoint.valid = TRUE;
+		Checkpoint.lineNumber = getInputLineNumber ();
+		Checkpoint.anonymousCount = getAnonymousCount ();
+	}
+}
+
+/*  Called when a brace is matched across levels of a #if conditional.
+ */
+static void freezeCheckpoint (void)
+{
+	Checkpoint.frozen = TRUE;
+}
+
+static void resumeFromCheckpoint (void)
+{
+	Assert (Checkpoint.valid);
+	verbose ("%s: resuming at line %lu with fallback brace matching algorithm\n",
+			getInputFileName (), Checkpoint.lineNumber);
+	rewindTagEntries ();
+	fileResume ();
+	cppResume ();
+	setAnonymousCount (Checkpoint.anonymousCount);
+	CollectingSignature = FALSE;
+	Checkpoint.valid = FALSE;
+}
+
 /*
 *   Parsing functions
 */
@@ -1465,19 +1522,27 @@ static void skipToMatch (const char *const pair)
 		if (c == begin)
 		{
 			++matchLevel;
-			if (braceFormatting  &&  getDirectiveNestLevel () != initialLevel)
+			if (braceMatching  &&  getDirectiveNestLevel () != initialLevel)
 			{
-				skipToFormattedBraceMatch ();
-				break;
+				freezeCheckpoint ();
+				if (braceFormatting)
+				{
+					skipToFormattedBraceMatch ();
+					break;
+				}
 			}
 		}
 		else if (c == end)
 		{
 			--matchLevel;
-			if (braceFormatting  &&  getDirectiveNestLevel () != initialLevel)
+			if (braceMatching  &&  getDirectiveNestLevel () != initialLevel)
 			{
-				skipToFormattedBraceMatch ();
-				break;
+				freezeCheckpoint ();
+				if (braceFormatting)
+				{
+					skipToFormattedBraceMatch ();
+					break;
+				}
 			}
 		}
 	}
@@ -2849,7 +2914,8 @@ static void tagCheck (statementInfo *const st)
 					 *  a number, so that the members can be found.
 					 */
 					char buf [20];  /* length of "_anon" + digits  + null */
-					sprintf (buf, "__anon%d", ++AnonymousID);
+					sprintf (buf, ANONYMOUS_PREFIX "%u",
+							nextAnonymousNumber ());
 					vStringCopyS (st->blockName->name, buf);
 					st->blockName->type = TOKEN_NAME;
 					st->blockName->keyword = KEYWORD_NONE;
@@ -2898,18 +2964,24 @@ static void createTags (const unsigned int nestLevel,
 						statementInfo *const parent)
 {
 	statementInfo *const st = newStatement (parent);
+	const unsigned int directiveLevel = getDirectiveNestLevel ();
 
 	DebugStatement ( if (nestLevel > 0) debugParseNest (TRUE, nestLevel); )
 	while (TRUE)
 	{
 		tokenInfo *token;
+		boolean ended;
 
 		nextToken (st);
 		token = activeToken (st);
 		if (isType (token, TOKEN_BRACE_CLOSE))
 		{
 			if (nestLevel > 0)
+			{
+				if (getDirectiveNestLevel () != directiveLevel)
+					freezeCheckpoint ();
 				break;
+			}
 			else
 			{
 				verbose ("%s: unexpected closing brace at line %lu\n",
@@ -2927,36 +2999,64 @@ static void createTags (const unsigned int nestLevel,
 			tagCheck (st);
 			if (isType (token, TOKEN_BRACE_OPEN))
 				nest (st, nestLevel + 1);
+			ended = (boolean) (nestLevel == 0  &&
+					! isType (activeToken (st), TOKEN_COMMA)  &&  isStatementEnd (st));
 			checkStatementEnd (st);
+			if (ended)
+				takeCheckpoint ();
 		}
 	}
 	deleteStatement ();
 	DebugStatement ( if (nestLevel > 0) debugParseNest (FALSE, nestLevel - 1); )
 }
 
+/*  A brace formatting error found in the first pass over a file is handled
+ *  by resuming from the last checkpoint, if any, else by asking for a second
+ *  pass. An error found after resuming also asks for a second pass, which
+ *  then starts from the top of the file.
+ */
 static boolean findCTags (const unsigned int passCount)
 {
 	exception_t exception;
 	boolean retry;
+	boolean resumed;
 
 	Assert (passCount < 3);
 	cppInit ((boolean) (passCount > 1), isLanguage (Lang_csharp));
 	Signature = vStringNew ();
+	Checkpoint.valid = FALSE;
+	Checkpoint.frozen = FALSE;
+	Checkpoint.lineNumber = 0;
 
-	exception = (exception_t) setjmp (Exception);
-	retry = FALSE;
-	if (exception == ExceptionNone)
-		createTags (0, NULL);
-	else
+	do
 	{
-		deleteAllStatements ();
-		if (exception == ExceptionBraceFormattingError  &&  passCount == 1)
+		resumed = FALSE;
+		exception = (exception_t) setjmp (Exception);
+		retry = FALSE;
+		if (exception == ExceptionNone)
 		{
-			retry = TRUE;
-		   verbose ("%s: retrying file with fallback brace matching algorithm\n",
-					getInputFileName ());
+			catchParseTimeout (&Exception, (int) ExceptionEOF);
+			createTags (0, NULL);
 		}
-	}
+		else
+		{
+			deleteAllStatements ();
+			if (exception == ExceptionBraceFormattingError  &&  passCount == 1)
+			{
+				if (Checkpoint.valid)
+				{
+					resumeFromCheckpoint ();
+					resumed = TRUE;
+				}
+				else
+				{
+					retry = TRUE;
+				   verbose ("%s: retrying file with fallback brace matching algorithm\n",
+							getInputFileName ());
+				}
+			}
+		}
+	} while (resumed);
 	vStringDelete (Signature);
 	cppTerminate ();
 	return retry;
@@ -1244,6 +1244,7 @@ static void findEiffelTags (void)
 	tokenInfo *const token = newToken ();
 	exception_t exception;
 
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
 	exception = (exception_t) (setjmp (Exception));
 	while (exception == ExceptionNone)
 	{
@@ -47,11 +47,19 @@
 #include "routines.h"
 #include "sort.h"
 #include "strlist.h"
+#include "tagbinary.h"
+#include "tagcache.h"
+#include "tagindex.h"
+#include "trace.h"
 
 /*
 *   MACROS
 */
 #define PSEUDO_TAG_PREFIX       "!_"
+#define JSON_BUFFER_SIZE        (1024 * 1024)  /* bytes of JSON output buffered */
+#define FINGERPRINT_MIN_SLOTS   4096  /* initial size of fingerprint table */
+#define ETAGS_SPILL_SIZE        (4 * 1024 * 1024)  /* bytes of an etags section
+                                                      held in memory */
 
 #define includeExtensionFlags()         (Option.tagFileFormat > 1)
 
@@ -79,13 +87,43 @@ tagFile TagFile = {
     NULL,               /* tag file name */
     NULL,               /* tag file directory (absolute) */
     NULL,               /* file pointer */
-    { 0, 0 },           /* numTags */
+    { 0, 0, 0 },        /* numTags */
     { 0, 0, 0 },        /* max */
-    { NULL, NULL, 0 },  /* etags */
-    NULL                /* vLine */
+    { NULL, NULL, 0, NULL },  /* etags */
+    NULL,               /* vLine */
+    0                   /* rewinds */
 };
 
 static boolean TagsToStdout = FALSE;
+static boolean TagsStreamed = FALSE;  /* written to stdout as made, unsorted */
+static boolean TagsMerged = FALSE;    /* written in order by mergeTagFiles () */
+
+/*  State of the tag file recorded by checkpointTagEntries ().
+ */
+static struct sTagCheckpoint {
+	fpos_t position;
+	struct sNumTags numTags;
+	unsigned long journalCount;
+	size_t etagsByteCount;
+} TagCheckpoint;
+
+/*  Fingerprints of the tags made, for --dedup. The table is open addressed,
+ *  with linear probing; an all zero fingerprint marks an empty slot. The
+ *  journal lists the fingerprints added since markTagEntries (), so that
+ *  they may be discarded if the source file is parsed again.
+ */
+typedef struct sFingerprint {
+	unsigned int high, low;  /* two independent 32 bit hashes */
+} fingerprint;
+
+static struct sFingerprints {
+	fingerprint *slot;
+	unsigned long size;      /* always a power of two */
+	unsigned long count;
+	fingerprint *journal;
+	unsigned long journalCount;
+	unsigned long journalMax;
+} Fingerprints = { NULL, 0, 0, NULL, 0, 0 };
 
 /*
 *   FUNCTION PROTOTYPES
@@ -107,6 +145,18 @@ extern void freeTagFileResources (void)
 	if (TagFile.directory != NULL)
 		eFree (TagFile.directory);
 	vStringDelete (TagFile.vLine);
+	if (TagFile.etags.section != NULL)
+		vStringDelete (TagFile.etags.section);
+	if (Fingerprints.slot != NULL)
+		eFree (Fingerprints.slot);
+	if (Fingerprints.journal != NULL)
+		eFree (Fingerprints.journal);
+	Fingerprints.slot = NULL;
+	Fingerprints.journal = NULL;
+	Fingerprints.size = 0;
+	Fingerprints.count = 0;
+	Fingerprints.journalCount = 0;
+	Fingerprints.journalMax = 0;
 }
 
 extern const char *tagFileName (void)
@@ -127,12 +177,143 @@ static void rememberMaxLengths (const size_t nameLength, const size_t lineLength
 		TagFile.max.line = lineLength;
 }
 
+/*  Writes a character of a JSON string, escaping quotes, backslashes and
+ *  control characters.
+ */
+static int writeJsonCharacter (const int c)
+{
+	int length = 2;
+
+	switch (c)
+	{
+		case '"':  fputs ("\\\"", TagFile.fp); break;
+		case '\\': fputs ("\\\\", TagFile.fp); break;
+		case '\b': fputs ("\\b", TagFile.fp);  break;
+		case '\f': fputs ("\\f", TagFile.fp);  break;
+		case '\n': fputs ("\\n", TagFile.fp);  break;
+		case '\r': fputs ("\\r", TagFile.fp);  break;
+		case '\t': fputs ("\\t", TagFile.fp);  break;
+		default:
+			if (c < 0x20)
+				length = fprintf (TagFile.fp, "\\u%04x", c);
+			else
+			{
+				putc (c, TagFile.fp);
+				length = 1;
+			}
+			break;
+	}
+	return length;
+}
+
+/*  Returns the length of the well-formed UTF-8 sequence of more than one
+ *  byte starting at `p', or zero if there is none.
+ */
+static size_t utf8SequenceLength (const unsigned char *const p)
+{
+	size_t length = 0;
+	size_t i;
+
+	if (p [0] >= 0xC2  &&  p [0] <= 0xDF)
+		length = 2;
+	else if (p [0] >= 0xE0  &&  p [0] <= 0xEF)
+		length = 3;
+	else if (p [0] >= 0xF0  &&  p [0] <= 0xF4)
+		length = 4;
+	for (i = 1  ;  i < length  ;  ++i)
+	{
+		if ((p [i] & 0xC0) != 0x80)
+			length = 0;
+	}
+	/*  Reject overlong forms, surrogates and code points above U+10FFFF.
+	 */
+	if (length > 0  &&  ((p [0] == 0xE0  &&  p [1] < 0xA0)  ||
+						 (p [0] == 0xED  &&  p [1] > 0x9F)  ||
+						 (p [0] == 0xF0  &&  p [1] < 0x90)  ||
+						 (p [0] == 0xF4  &&  p [1] > 0x8F)))
+	{
+		length = 0;
+	}
+	return length;
+}
+
+/*  Writes the character starting at `*p' in a JSON string, advancing `*p'
+ *  past it. A byte which does not begin a well-formed UTF-8 sequence is
+ *  written as the Latin-1 character of the same value, so that every line
+ *  is valid JSON whatever the encoding of the source files.
+ */
+static int writeJsonSequence (const unsigned char **const p)
+{
+	int length;
+
+	if (**p < 0x80)
+	{
+		length = writeJsonCharacter ((int) **p);
+		++*p;
+	}
+	else
+	{
+		const size_t count = utf8SequenceLength (*p);
+
+		if (count == 0)
+		{
+			length = fprintf (TagFile.fp, "\\u%04x", (unsigned int) **p);
+			++*p;
+		}
+		else
+		{
+			fwrite (*p, (size_t) 1, count, TagFile.fp);
+			length = (int) count;
+			*p += count;
+		}
+	}
+	return length;
+}
+
+static int writeJsonString (const char *const string)
+{
+	const unsigned char *p = (const unsigned char *) string;
+	int length = 2;
+
+	putc ('"', TagFile.fp);
+	while (*p != '\0')
+		length += writeJsonSequence (&p);
+	putc ('"', TagFile.fp);
+	return length;
+}
+
+/*  Writes a member of a JSON object following the first, unless `value' is
+ *  null.
+ */
+static int writeJsonMember (const char *const key, const char *const value)
+{
+	int length = 0;
+
+	if (value != NULL)
+	{
+		length = fprintf (TagFile.fp, ",\"%s\":", key);
+		length += writeJsonString (value);
+	}
+	return length;
+}
+
 static void writePseudoTag (
 		const char *const tagName,
 		const char *const fileName,
 		const char *const pattern)
 {
-	const int length = fprintf (
+	int length;
+
+	if (Option.outputFormat == OUTPUT_JSON)
+	{
+		length = fprintf (TagFile.fp, "{\"name\":\"%s%s\"",
+				PSEUDO_TAG_PREFIX, tagName);
+		length += writeJsonMember ("path", fileName);
+		length += writeJsonMember ("pattern", pattern);
+		length += fprintf (TagFile.fp, ",\"_type\":\"ptag\"}\n");
+	}
+	else
+		length = fprintf (
 			TagFile.fp, "%s%s\t%s\t/%s/\n",
 			PSEUDO_TAG_PREFIX, tagName, fileName, pattern);
 	++TagFile.numTags.added;
@@ -316,6 +497,11 @@ static boolean isEtagsLine (const char *const line)
 	return result;
 }
 
+static boolean isJsonLine (const char *const line)
+{
+	return (boolean) (strncmp (line, "{\"name\":", (size_t) 8) == 0);
+}
+
 static boolean isTagFile (const char *const filename)
 {
 	boolean ok = FALSE;  /* we assume not unless confirmed */
@@ -330,7 +516,8 @@ static boolean isTagFile (const char *const filename)
 		if (line == NULL)
 			ok = TRUE;
 		else
-			ok = (boolean) (isCtagsLine (line) || isEtagsLine (line));
+			ok = (boolean) (isCtagsLine (line) || isEtagsLine (line) ||
+					isBinaryTagLine (line) || isJsonLine (line));
 		fclose (fp);
 	}
 	return ok;
@@ -374,17 +561,45 @@ extern void copyFile (const char *const from, const char *const to, const long s
 	}
 }
 
+/*  Returns a stream of its own writing to standard output, so that it may
+ *  be given a large buffer, or NULL if one cannot be opened.
+ */
+static FILE *openStdout (void)
+{
+	FILE *fp = NULL;
+#ifdef HAVE_UNISTD_H
+	const int fd = dup (fileno (stdout));
+
+	fflush (stdout);
+	if (fd >= 0)
+	{
+		fp = fdopen (fd, "w");
+		if (fp == NULL)
+			close (fd);
+	}
+#endif
+	return fp;
+}
+
 extern void openTagFile (void)
 {
 	setDefaultTagFileName ();
 	TagsToStdout = isDestinationStdout ();
+	TagsStreamed = FALSE;
 
 	if (TagFile.vLine == NULL)
 		TagFile.vLine = vStringNew ();
 
-	/*  Open the tags file.
+	/*  Open the tags file. JSON lines need no sorting or other processing
+	 *  once written, so unsorted JSON output to stdout is written directly.
 	 */
-	if (TagsToStdout)
+	if (TagsToStdout  &&  Option.outputFormat == OUTPUT_JSON  &&
+		Option.sorted == SO_UNSORTED  &&  (TagFile.fp = openStdout ()) != NULL)
+	{
+		TagsStreamed = TRUE;
+		TagFile.name = eStrdup ("-");
+	}
+	else if (TagsToStdout)
 		TagFile.fp = tempFile ("w", &TagFile.name);
 	else
 	{
@@ -430,6 +645,8 @@ extern void openTagFile (void)
 			exit (1);
 		}
 	}
+	if (Option.outputFormat == OUTPUT_JSON)
+		setvbuf (TagFile.fp, NULL, _IOFBF, JSON_BUFFER_SIZE);
 	if (TagsToStdout)
 		TagFile.directory = eStrdup (CurrentDirectory);
 	else
@@ -459,7 +676,7 @@ static void sortTagFile (void)
 {
 	if (TagFile.numTags.added > 0L)
 	{
-		if (Option.sorted != SO_UNSORTED)
+		if (Option.sorted != SO_UNSORTED  &&  ! TagsMerged)
 		{
 			verbose ("sorting tag file\n");
 #ifdef EXTERNAL_SORT
@@ -523,46 +740,134 @@ extern void closeTagFile (const boolean resize)
 {
 	long desiredSize, size;
 
-	if (Option.etags)
-		writeEtagsIncludes (TagFile.fp);
-	desiredSize = ftell (TagFile.fp);
-	fseek (TagFile.fp, 0L, SEEK_END);
-	size = ftell (TagFile.fp);
-	fclose (TagFile.fp);
-	if (resize  &&  desiredSize < size)
-	{
-		DebugStatement (
-			debugPrintf (DEBUG_STATUS, "shrinking %s from %ld to %ld bytes\n",
-				TagFile.name, size, desiredSize); )
-		resizeTagFile (desiredSize);
-	}
-	sortTagFile ();
+	if (TagsStreamed)
+	{
+		if (fclose (TagFile.fp) != 0)
+			error (FATAL | PERROR, "cannot write tags to stdout");
+	}
+	else
+	{
+		if (Option.etags)
+			writeEtagsIncludes (TagFile.fp);
+		desiredSize = ftell (TagFile.fp);
+		fseek (TagFile.fp, 0L, SEEK_END);
+		size = ftell (TagFile.fp);
+		fclose (TagFile.fp);
+		if (resize  &&  desiredSize < size)
+		{
+			DebugStatement (
+				debugPrintf (DEBUG_STATUS, "shrinking %s from %ld to %ld bytes\n",
+					TagFile.name, size, desiredSize); )
+			resizeTagFile (desiredSize);
+		}
+		traceBegin ("sort", "sort", TagFile.name);
+		sortTagFile ();
+		traceEnd ();
+		if (Option.outputFormat == OUTPUT_BINARY)
+		{
+			traceBegin ("output", "binary tag file", TagFile.name);
+			writeBinaryTagFile (TagFile.name);
+			traceEnd ();
+		}
+		if (Option.tagIndex)
+		{
+			traceBegin ("output", "tag index", TagFile.name);
+			writeTagIndex (TagFile.name);
+			traceEnd ();
+		}
+	}
 	eFree (TagFile.name);
 	TagFile.name = NULL;
 }
 
+/*  Writes the tag file by merging the sorted tag files named, in place of
+ *  generating tags from source files. Its pseudo tags are written as for
+ *  any other tag file, replacing those of the files merged.
+ */
+extern void mergeTagFiles (const stringList *const files)
+{
+	unsigned int i;
+
+	setDefaultTagFileName ();
+	if (! isDestinationStdout ())
+	{
+		for (i = 0  ;  i < stringListCount (files)  ;  ++i)
+		{
+			const char *const name = vStringValue (stringListItem (files, i));
+
+			if (isSameFile (Option.tagFileName, name))
+				error (FATAL, "cannot merge \"%s\" into itself", name);
+		}
+	}
+	openTagFile ();
+	TagsMerged = TRUE;
+	traceBegin ("sort", "merge", NULL);
+	mergeSortedTags (files, TagFile.fp);
+	traceEnd ();
+	closeTagFile (FALSE);
+	TagsMerged = FALSE;
+}
+
+/*  The etags section of each source file is preceded by its size, so is
+ *  assembled in memory, and only written to a temporary file if it grows
+ *  larger than ETAGS_SPILL_SIZE.
+ */
 extern void beginEtagsFile (void)
 {
-	TagFile.etags.fp = tempFile ("w+b", &TagFile.etags.name);
+	if (TagFile.etags.section == NULL)
+		TagFile.etags.section = vStringNew ();
+	vStringClear (TagFile.etags.section);
+	TagFile.etags.fp = NULL;
 	TagFile.etags.byteCount = 0;
 }
 
-extern void endEtagsFile (const char *const name)
+static void addEtagsText (const char *const text)
 {
-	const char *line;
+	const size_t length = strlen (text);
+
+	if (TagFile.etags.fp != NULL)
+		fputs (text, TagFile.etags.fp);
+	else
+	{
+		vString *const section = TagFile.etags.section;
 
+		vStringCatS (section, text);
+		if (vStringLength (section) > ETAGS_SPILL_SIZE)
+		{
+			TagFile.etags.fp = tempFile ("w+b", &TagFile.etags.name);
+			fwrite (vStringValue (section), (size_t) 1,
+					vStringLength (section), TagFile.etags.fp);
+			vStringClear (section);
+		}
+	}
+	TagFile.etags.byteCount += length;
+}
+
+extern void endEtagsFile (const char *const name)
+{
 	fprintf (TagFile.fp, "\f\n%s,%ld\n", name, (long) TagFile.etags.byteCount);
 	if (TagFile.etags.fp != NULL)
 	{
+		/*  The section may have been rewound by rewindTagEntries (), leaving
+		 *  discarded bytes beyond its end.
+		 */
 		rewind (TagFile.etags.fp);
-		while ((line = readLine (TagFile.vLine, TagFile.etags.fp)) != NULL)
-			fputs (line, TagFile.fp);
+		if (TagFile.etags.byteCount > 0)
+			copyBytes (TagFile.etags.fp, TagFile.fp,
+					(long) TagFile.etags.byteCount);
 		fclose (TagFile.etags.fp);
 		remove (TagFile.etags.name);
 		eFree (TagFile.etags.name);
 		TagFile.etags.fp = NULL;
 		TagFile.etags.name = NULL;
 	}
+	else if (fwrite (vStringValue (TagFile.etags.section), (size_t) 1,
+			vStringLength (TagFile.etags.section), TagFile.fp) <
+			vStringLength (TagFile.etags.section))
+	{
+		error (FATAL | PERROR, "cannot complete write");
+	}
+	vStringClear (TagFile.etags.section);
 }
 
 /*
@@ -676,30 +981,56 @@ static void truncateTagLine (
 	}
 }
 
-static int writeEtagsEntry (const tagEntryInfo *const tag)
+/*  Reads the source line of a tag, if its entry holds one in the selected
+ *  output format, cut short as it is to be written. The line is read once
+ *  for both the fingerprint of the tag and its entry. Returns NULL if the
+ *  entry holds no source line.
+ */
+static char *readTagSourceLine (
+		const tagEntryInfo *const tag, long *const seekValue)
 {
-	int length;
+	char *line = NULL;
 
-	if (tag->isFileEntry)
-		length = fprintf (TagFile.etags.fp, "\177%s\001%lu,0\n",
-				tag->name, tag->lineNumber);
-	else
+	*seekValue = 0;
+	if (Option.etags  &&  ! tag->isFileEntry)
 	{
-		long seekValue;
-		char *const line =
-				readSourceLine (TagFile.vLine, tag->filePosition, &seekValue);
-
+		line = readSourceLine (TagFile.vLine, tag->filePosition, seekValue);
+		if (line == NULL)
+			error (FATAL, "bad tag in %s", vStringValue (File.name));
 		if (tag->truncateLine)
 			truncateTagLine (line, tag->name, TRUE);
 		else
 			line [strlen (line) - 1] = '\0';
+	}
+	else if (! Option.etags  &&  ! Option.xref  &&  ! tag->lineNumberEntry)
+	{
+		line = readSourceLine (TagFile.vLine, tag->filePosition, NULL);
+		if (line == NULL)
+			error (FATAL, "bad tag in %s", vStringValue (File.name));
+		if (tag->truncateLine)
+			truncateTagLine (line, tag->name, FALSE);
+	}
+	return line;
+}
+
+static int writeEtagsEntry (const tagEntryInfo *const tag,
+		const char *const line, const long seekValue)
+{
+	const size_t start = TagFile.etags.byteCount;
+	char position [48];
 
-		length = fprintf (TagFile.etags.fp, "%s\177%s\001%lu,%ld\n", line,
-				tag->name, tag->lineNumber, seekValue);
+	if (tag->isFileEntry)
+		sprintf (position, "\001%lu,0\n", tag->lineNumber);
+	else
+	{
+		addEtagsText (line);
+		sprintf (position, "\001%lu,%ld\n", tag->lineNumber, seekValue);
 	}
-	TagFile.etags.byteCount += length;
+	addEtagsText ("\177");
+	addEtagsText (tag->name);
+	addEtagsText (position);
 
-	return length;
+	return (int) (TagFile.etags.byteCount - start);
 }
 
 static int addExtensionFields (const tagEntryInfo *const tag)
@@ -765,17 +1096,12 @@ static int addExtensionFields (const tagEntryInfo *const tag)
 #undef sep
 }
 
-static int writePatternEntry (const tagEntryInfo *const tag)
+static int writePatternEntry (const char *const line)
 {
-	char *const line = readSourceLine (TagFile.vLine, tag->filePosition, NULL);
 	const int searchChar = Option.backward ? '?' : '/';
 	boolean newlineTerminated;
 	int length = 0;
 
-	if (line == NULL)
-		error (FATAL, "bad tag in %s", vStringValue (File.name));
-	if (tag->truncateLine)
-		truncateTagLine (line, tag->name, FALSE);
 	newlineTerminated = (boolean) (line [strlen (line) - 1] == '\n');
 
 	length += fprintf (TagFile.fp, "%c^", searchChar);
@@ -790,7 +1116,8 @@ static int writeLineNumberEntry (const tagEntryInfo *const tag)
 	return fprintf (TagFile.fp, "%lu", tag->lineNumber);
 }
 
-static int writeCtagsEntry (const tagEntryInfo *const tag)
+static int writeCtagsEntry (
+		const tagEntryInfo *const tag, const char *const line)
 {
 	int length = fprintf (TagFile.fp, "%s\t%s\t",
 		tag->name, tag->sourceFileName);
@@ -798,7 +1125,7 @@ static int writeCtagsEntry (const tagEntryInfo *const tag)
 	if (tag->lineNumberEntry)
 		length += writeLineNumberEntry (tag);
 	else
-		length += writePatternEntry (tag);
+		length += writePatternEntry (line);
 
 	if (includeExtensionFlags ())
 		length += addExtensionFields (tag);
@@ -808,29 +1135,409 @@ static int writeCtagsEntry (const tagEntryInfo *const tag)
 	return length;
 }
 
+/*  Writes the pattern of a tag as a JSON string, quoting the source line as
+ *  writeSourceLine () does.
+ */
+static int writeJsonPattern (const char *const line)
+{
+	const int searchChar = Option.backward ? '?' : '/';
+	boolean newlineTerminated;
+	int length = 0;
+	const unsigned char *p;
+
+	newlineTerminated = (boolean) (line [strlen (line) - 1] == '\n');
+
+	length += fprintf (TagFile.fp, ",\"pattern\":\"%c^", searchChar);
+	p = (const unsigned char *) line;
+	while (*p != '\0'  &&  *p != CRETURN  &&  *p != NEWLINE)
+	{
+		const int next = *(p + 1);
+		const int c = *p;
+
+		if (c == BACKSLASH  ||  c == searchChar  ||
+			(c == '$'  &&  (next == NEWLINE  ||  next == CRETURN)))
+		{
+			length += writeJsonCharacter (BACKSLASH);
+		}
+		length += writeJsonSequence (&p);
+	}
+	length += fprintf (TagFile.fp, "%s%c\"",
+			newlineTerminated ? "$" : "", searchChar);
+	return length;
+}
+
+/*  Writes a tag as a JSON object on a line of its own, holding every field
+ *  of the tag regardless of --fields. The name comes first, so that sorting
+ *  the lines orders the tags by name.
+ */
+static int writeJsonEntry (
+		const tagEntryInfo *const tag, const char *const line)
+{
+	char kind [2];
+	int length = fprintf (TagFile.fp, "{\"name\":");
+
+	length += writeJsonString (tag->name);
+	length += writeJsonMember ("path", tag->sourceFileName);
+	if (! tag->lineNumberEntry)
+		length += writeJsonPattern (line);
+	length += fprintf (TagFile.fp, ",\"line\":%lu", tag->lineNumber);
+	length += writeJsonMember ("language", tag->language);
+	length += writeJsonMember ("kind", tag->kindName);
+	if (tag->kind != '\0')
+	{
+		kind [0] = tag->kind;
+		kind [1] = '\0';
+		length += writeJsonMember ("kindLetter", kind);
+	}
+	if (tag->extensionFields.scope [0] != NULL  &&
+		tag->extensionFields.scope [1] != NULL)
+	{
+		length += writeJsonMember ("scopeKind", tag->extensionFields.scope [0]);
+		length += writeJsonMember ("scope", tag->extensionFields.scope [1]);
+	}
+	if (tag->extensionFields.typeRef [0] != NULL  &&
+		tag->extensionFields.typeRef [1] != NULL)
+	{
+		length += writeJsonMember ("typerefKind", tag->extensionFields.typeRef [0]);
+		length += writeJsonMember ("typeref", tag->extensionFields.typeRef [1]);
+	}
+	length += writeJsonMember ("inherits", tag->extensionFields.inheritance);
+	length += writeJsonMember ("access", tag->extensionFields.access);
+	length += writeJsonMember ("implementation",
+			tag->extensionFields.implementation);
+	length += writeJsonMember ("signature", tag->extensionFields.signature);
+	if (tag->isFileScope)
+		length += fprintf (TagFile.fp, ",\"fileScope\":true");
+	if (tag->isFileEntry)
+		length += fprintf (TagFile.fp, ",\"fileEntry\":true");
+	length += fprintf (TagFile.fp, ",\"_type\":\"tag\"}\n");
+
+	return length;
+}
+
+/*
+ *  Duplicate tag elimination (--dedup)
+ */
+
+static void hashBytes (
+		fingerprint *const print, const char *const bytes, const size_t length)
+{
+	unsigned long high = print->high;
+	unsigned long low = print->low;
+	size_t i;
+
+	/*  FNV-1a and a multiplicative hash with a final mix, combined into a
+	 *  64 bit fingerprint.
+	 */
+	for (i = 0  ;  i < length  ;  ++i)
+	{
+		const unsigned int c = (unsigned char) bytes [i];
+
+		high = ((high ^ c) * 16777619UL) & 0xffffffffUL;
+		low = ((low + c + 1) * 0x5bd1e995UL) & 0xffffffffUL;
+		low ^= low >> 15;
+	}
+	print->high = (unsigned int) high;
+	print->low = (unsigned int) low;
+}
+
+/*  Adds a string, or its absence, to a fingerprint. Each is preceded by a
+ *  marker and strings are terminated, so that no two sequences of values
+ *  are hashed alike.
+ */
+static void hashString (fingerprint *const print, const char *const string)
+{
+	if (string == NULL)
+		hashBytes (print, "n", (size_t) 1);
+	else
+	{
+		hashBytes (print, "s", (size_t) 1);
+		hashBytes (print, string, strlen (string) + 1);
+	}
+}
+
+static void hashNumber (fingerprint *const print, const unsigned long number)
+{
+	char buffer [24];
+
+	sprintf (buffer, "%lu", number);
+	hashString (print, buffer);
+}
+
+static void hashField (fingerprint *const print,
+		const boolean written, const char *const value)
+{
+	hashString (print, written ? value : NULL);
+}
+
+/*  Computes a fingerprint of the fields from which the line written for a
+ *  tag is formed in the selected output format. Fields omitted from the line
+ *  are left out, so that tags differing only in those are duplicates, just
+ *  as their lines would be after sorting.
+ */
+static fingerprint tagFingerprint (const tagEntryInfo *const tag,
+		const char *const line, const long seekValue)
+{
+	const struct sExtFields *const fields = &Option.extensionFields;
+	fingerprint print;
+
+	print.high = 2166136261U;
+	print.low = 0;
+	hashString (&print, tag->name);
+	if (Option.etags)
+	{
+		hashString (&print, tag->sourceFileName);
+		hashNumber (&print, tag->lineNumber);
+		hashString (&print, tag->isFileEntry ? "f" : "-");
+		if (! tag->isFileEntry)
+		{
+			hashString (&print, line);
+			hashNumber (&print, (unsigned long) seekValue);
+		}
+	}
+	else
+	{
+		const boolean json = (boolean) (Option.outputFormat == OUTPUT_JSON);
+		const boolean extended = (boolean) (json  ||  includeExtensionFlags ());
+		char kind [2];
+/* "written" is true if a field is part of the tag line */
+#define written(x) (boolean) (json  ||  (extended  &&  fields->x))
+
+		kind [0] = tag->kind;
+		kind [1] = '\0';
+		hashString (&print, tag->sourceFileName);
+		hashString (&print, tag->lineNumberEntry ? "l" : "-");
+		if (! tag->lineNumberEntry)
+			hashString (&print, line);
+		if (tag->lineNumberEntry  ||  written (lineNumber))
+			hashNumber (&print, tag->lineNumber);
+		hashField (&print, (boolean) (written (kind)  ||  written (kindLong)),
+				tag->kindName);
+		hashField (&print, (boolean) (written (kind)  ||  written (kindLong)),
+				kind);
+		hashField (&print, written (language), tag->language);
+		hashField (&print, written (scope), tag->extensionFields.scope [0]);
+		hashField (&print, written (scope), tag->extensionFields.scope [1]);
+		hashField (&print, written (typeRef), tag->extensionFields.typeRef [0]);
+		hashField (&print, written (typeRef), tag->extensionFields.typeRef [1]);
+		hashField (&print, written (fileScope), tag->isFileScope ? "s" : "-");
+		hashField (&print, written (inheritance),
+				tag->extensionFields.inheritance);
+		hashField (&print, written (access), tag->extensionFields.access);
+		hashField (&print, written (implementation),
+				tag->extensionFields.implementation);
+		hashField (&print, written (signature), tag->extensionFields.signature);
+		hashField (&print, json, tag->isFileEntry ? "f" : "-");
+#undef written
+	}
+	if (print.high == 0  &&  print.low == 0)
+		print.low = 1;
+	return print;
+}
+
+static boolean isSameFingerprint (const fingerprint a, const fingerprint b)
+{
+	return (boolean) (a.high == b.high  &&  a.low == b.low);
+}
+
+static boolean isEmptySlot (const unsigned long i)
+{
+	return (boolean) (Fingerprints.slot [i].high == 0  &&
+					  Fingerprints.slot [i].low == 0);
+}
+
+static unsigned long fingerprintSlot (const fingerprint print)
+{
+	unsigned long i = (unsigned long) print.low & (Fingerprints.size - 1);
+
+	while (! isEmptySlot (i)  &&
+		   ! isSameFingerprint (Fingerprints.slot [i], print))
+	{
+		i = (i + 1) & (Fingerprints.size - 1);
+	}
+	return i;
+}
+
+static void resizeFingerprints (void)
+{
+	fingerprint *const old = Fingerprints.slot;
+	const unsigned long oldSize = Fingerprints.size;
+	unsigned long i;
+
+	if (oldSize == 0)
+		Fingerprints.size = FINGERPRINT_MIN_SLOTS;
+	else
+		Fingerprints.size = 2 * oldSize;
+	Fingerprints.slot = xCalloc (Fingerprints.size, fingerprint);
+	for (i = 0  ;  i < oldSize  ;  ++i)
+	{
+		if (old [i].high != 0  ||  old [i].low != 0)
+			Fingerprints.slot [fingerprintSlot (old [i])] = old [i];
+	}
+	if (old != NULL)
+		eFree (old);
+}
+
+/*  Records the fingerprint of a tag, returning FALSE if it was already
+ *  recorded.
+ */
+static boolean addFingerprint (const fingerprint print)
+{
+	boolean added = FALSE;
+	unsigned long i;
+
+	if (2 * (Fingerprints.count + 1) > Fingerprints.size)
+		resizeFingerprints ();
+	i = fingerprintSlot (print);
+	if (isEmptySlot (i))
+	{
+		Fingerprints.slot [i] = print;
+		++Fingerprints.count;
+		if (Fingerprints.journalCount == Fingerprints.journalMax)
+		{
+			Fingerprints.journalMax = 2 * Fingerprints.journalMax + 256;
+			Fingerprints.journal = xRealloc (Fingerprints.journal,
+					Fingerprints.journalMax, fingerprint);
+		}
+		Fingerprints.journal [Fingerprints.journalCount++] = print;
+		added = TRUE;
+	}
+	return added;
+}
+
+/*  Removes a fingerprint, moving back any later entries of its probe
+ *  sequence which could no longer be found.
+ */
+static void removeFingerprint (const fingerprint print)
+{
+	const unsigned long mask = Fingerprints.size - 1;
+	unsigned long i = fingerprintSlot (print);
+	unsigned long j = i;
+
+	if (isEmptySlot (i))
+		return;
+	for (;;)
+	{
+		unsigned long home;
+
+		Fingerprints.slot [i].high = 0;
+		Fingerprints.slot [i].low = 0;
+		do
+		{
+			j = (j + 1) & mask;
+			if (isEmptySlot (j))
+			{
+				--Fingerprints.count;
+				return;
+			}
+			home = (unsigned long) Fingerprints.slot [j].low & mask;
+		} while (i <= j ? (i < home  &&  home <= j) : (i < home  ||  home <= j));
+		Fingerprints.slot [i] = Fingerprints.slot [j];
+		i = j;
+	}
+}
+
+/*  Called before the tags of a source file are made, and again before each
+ *  further pass over it, which may repeat tags of the discarded pass.
+ */
+extern void markTagEntries (void)
+{
+	Fingerprints.journalCount = 0;
+}
+
+extern void discardTagEntries (void)
+{
+	while (Fingerprints.journalCount > 0)
+		removeFingerprint (Fingerprints.journal [--Fingerprints.journalCount]);
+}
+
+/*  Records the tags made so far for the source file, so that a parser which
+ *  finds it must reconsider the rest of the file may discard those made
+ *  afterwards, by rewindTagEntries (), without parsing it again from the
+ *  start. Returns FALSE if the tag file cannot be repositioned.
+ */
+extern boolean checkpointTagEntries (void)
+{
+	const boolean result =
+			(boolean) (fgetpos (TagFile.fp, &TagCheckpoint.position) == 0);
+
+	TagCheckpoint.numTags = TagFile.numTags;
+	TagCheckpoint.journalCount = Fingerprints.journalCount;
+	TagCheckpoint.etagsByteCount = TagFile.etags.byteCount;
+	checkpointTagCache ();
+	return result;
+}
+
+extern void rewindTagEntries (void)
+{
+	fsetpos (TagFile.fp, &TagCheckpoint.position);
+	TagFile.numTags = TagCheckpoint.numTags;
+	while (Fingerprints.journalCount > TagCheckpoint.journalCount)
+		removeFingerprint (Fingerprints.journal [--Fingerprints.journalCount]);
+	if (Option.etags)
+	{
+		const size_t length = TagCheckpoint.etagsByteCount;
+
+		if (TagFile.etags.fp != NULL)
+			fseek (TagFile.etags.fp, (long) length, SEEK_SET);
+		else
+		{
+			vStringItem (TagFile.etags.section, length) = '\0';
+			vStringSetLength (TagFile.etags.section);
+		}
+		TagFile.etags.byteCount = length;
+	}
+	rewindTagCache ();
+	++TagFile.rewinds;
+}
+
+static boolean isDuplicateTag (const tagEntryInfo *const tag,
+		const char *const line, const long seekValue)
+{
+	boolean result = FALSE;
+
+	if (Option.dedup  &&  ! Option.xref)
+		result = (boolean) ! addFingerprint (
+				tagFingerprint (tag, line, seekValue));
+	return result;
+}
+
 extern void makeTagEntry (const tagEntryInfo *const tag)
 {
 	Assert (tag->name != NULL);
+	cacheTagEntry (tag);
 	if (tag->name [0] == '\0')
 		error (WARNING, "ignoring null tag in %s", vStringValue (File.name));
 	else
 	{
+		const phase previous = switchPhase (PHASE_WRITE);
+		long seekValue;
+		const char *const line = readTagSourceLine (tag, &seekValue);
 		int length = 0;
 
-		DebugStatement ( debugEntry (tag); )
-		if (Option.xref)
-		{
-			if (! tag->isFileEntry)
-				length = writeXrefEntry (tag);
-		}
-		else if (Option.etags)
-			length = writeEtagsEntry (tag);
+		if (isDuplicateTag (tag, line, seekValue))
+			++TagFile.numTags.duplicate;
 		else
-			length = writeCtagsEntry (tag);
+		{
+			DebugStatement ( debugEntry (tag); )
+			if (Option.xref)
+			{
+				if (! tag->isFileEntry)
+					length = writeXrefEntry (tag);
+			}
+			else if (Option.etags)
+				length = writeEtagsEntry (tag, line, seekValue);
+			else if (Option.outputFormat == OUTPUT_JSON)
+				length = writeJsonEntry (tag, line);
+			else
+				length = writeCtagsEntry (tag, line);
 
-		++TagFile.numTags.added;
-		rememberMaxLengths (strlen (tag->name), (size_t) length);
-		DebugStatement ( fflush (TagFile.fp); )
+			++TagFile.numTags.added;
+			rememberMaxLengths (strlen (tag->name), (size_t) length);
+			DebugStatement ( fflush (TagFile.fp); )
+		}
+		switchPhase (previous);
+		checkParseTimeout ((unsigned long) length);
 	}
 }
 
@@ -18,6 +18,7 @@
 
 #include <stdio.h>
 
+#include "strlist.h"
 #include "vstring.h"
 
 /*
@@ -35,14 +36,16 @@ typedef struct eTagFile {
 	char *name;
 	char *directory;
 	FILE *fp;
-	struct sNumTags { unsigned long added, prev; } numTags;
+	struct sNumTags { unsigned long added, prev, duplicate; } numTags;
 	struct sMax { size_t line, tag, file; } max;
 	struct sEtags {
 		char *name;
-		FILE *fp;
+		FILE *fp;           /* temporary file, once section is spilled */
 		size_t byteCount;
+		vString *section;   /* section being assembled, until spilled */
 	} etags;
 	vString *vLine;
+	unsigned int rewinds;   /* number of times rewound to a checkpoint */
 } tagFile;
 
 typedef struct sTagFields {
@@ -93,8 +96,13 @@ extern void copyBytes (FILE* const fromFp, FILE* const toFp, const long size);
 extern void copyFile (const char *const from, const char *const to, const long size);
 extern void openTagFile (void);
 extern void closeTagFile (const boolean resize);
+extern void mergeTagFiles (const stringList *const files);
 extern void beginEtagsFile (void);
 extern void endEtagsFile (const char *const name);
+extern void markTagEntries (void);
+extern void discardTagEntries (void);
+extern boolean checkpointTagEntries (void);
+extern void rewindTagEntries (void);
 extern void makeTagEntry (const tagEntryInfo *const tag);
 extern void initTagEntry (tagEntryInfo *const e, const char *const name);
 
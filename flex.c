@@ -2393,6 +2393,7 @@ static void findFlexTags (void)
 	ClassNames = stringListNew ();
 	FunctionNames = stringListNew ();
 	
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
 	exception = (exception_t) (setjmp (Exception));
 	while (exception == ExceptionNone)
 		parseFlexFile (token);
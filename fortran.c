@@ -2149,6 +2149,7 @@ static boolean findFortranTags (const unsigned int passCount)
 	token = newToken ();
 	FreeSourceForm = (boolean) (passCount > 1);
 	Column = 0;
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
 	exception = (exception_t) setjmp (Exception);
 	if (exception == ExceptionEOF)
 		retry = FALSE;
@@ -94,6 +94,10 @@ static cppState Cpp = {
 	}  /* directive */
 };
 
+/*  State recorded by cppCheckpoint ().
+ */
+static cppState Checkpoint;
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -139,6 +143,38 @@ extern void cppTerminate (void)
 		vStringDelete (Cpp.directive.name);
 		Cpp.directive.name = NULL;
 	}
+	if (Checkpoint.directive.name != NULL)
+	{
+		vStringDelete (Checkpoint.directive.name);
+		Checkpoint.directive.name = NULL;
+	}
+}
+
+/*  Records the state of the pre-processor, to which cppResume () may later
+ *  return it. Only the last state recorded is kept.
+ */
+extern void cppCheckpoint (void)
+{
+	vString *name = Checkpoint.directive.name;
+
+	if (name == NULL)
+		name = vStringNew ();
+	vStringCopy (name, Cpp.directive.name);
+	Checkpoint = Cpp;
+	Checkpoint.directive.name = name;
+}
+
+/*  Returns the pre-processor to the state recorded by cppCheckpoint (), from
+ *  which it continues using brace formatting.
+ */
+extern void cppResume (void)
+{
+	vString *const name = Cpp.directive.name;
+
+	vStringCopy (name, Checkpoint.directive.name);
+	Cpp = Checkpoint;
+	Cpp.directive.name = name;
+	BraceFormat = TRUE;
 }
 
 extern void cppBeginStatement (void)
@@ -39,6 +39,8 @@ extern boolean isBraceFormat (void);
 extern unsigned int getDirectiveNestLevel (void);
 extern void cppInit (const boolean state, const boolean hasAtLiteralStrings);
 extern void cppTerminate (void);
+extern void cppCheckpoint (void);
+extern void cppResume (void);
 extern void cppBeginStatement (void);
 extern void cppEndStatement (void);
 extern void cppUngetc (const int c);
@@ -12,6 +12,7 @@
 #include "routines.h"
 #include "vstring.h"
 #include "options.h"
+#include "parse.h"
 
 /*
  *	 MACROS
@@ -648,6 +649,7 @@ static void findGoTags (void)
 	tokenInfo *const token = newToken ();
 	exception_t exception;
 
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
 	exception = (exception_t) (setjmp (Exception));
 	while (exception == ExceptionNone)
 		parseGoFile (token);
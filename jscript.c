@@ -1606,6 +1606,7 @@ static void findJsTags (void)
 	FunctionNames = stringListNew ();
 	
 	exception = (exception_t) (setjmp (Exception));
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
 	while (exception == ExceptionNone)
 		parseJsFile (token);
 
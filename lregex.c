@@ -34,6 +34,7 @@
 #include "parse.h"
 #include "read.h"
 #include "routines.h"
+#include "trace.h"
 
 #ifdef HAVE_REGEX
 
@@ -83,6 +84,7 @@ typedef struct {
 typedef struct {
 	regexPattern *patterns;
 	unsigned int count;
+	vString *source;  /* the patterns as defined, one per line */
 } patternSet;
 
 /*
@@ -95,6 +97,16 @@ static boolean regexBroken = FALSE;
 static patternSet* Sets = NULL;
 static int SetUpper = -1;  /* upper language index in list */
 
+#if defined (POSIX_REGEX)
+/* Name of the tag being made, kept between matches so that it is not lost
+ * when the parse of a file is abandoned part way through making the tag.
+ */
+static vString* TagName = NULL;
+#endif
+
+/* Taken when the time allowed to parse a file by --parse-timeout runs out */
+static jmp_buf Exception;
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -131,6 +143,8 @@ static void clearPatternSet (const langType language)
 			eFree (set->patterns);
 		set->patterns = NULL;
 		set->count = 0;
+		if (set->source != NULL)
+			vStringClear (set->source);
 	}
 }
 
@@ -264,6 +278,7 @@ static void addCompiledTagPattern (
 		{
 			Sets [i].patterns = NULL;
 			Sets [i].count = 0;
+			Sets [i].source = NULL;
 		}
 		SetUpper = language;
 	}
@@ -295,6 +310,7 @@ static void addCompiledCallbackPattern (
 		{
 			Sets [i].patterns = NULL;
 			Sets [i].count = 0;
+			Sets [i].source = NULL;
 		}
 		SetUpper = language;
 	}
@@ -426,12 +442,12 @@ static void processLanguageRegex (const langType language,
 
 #if defined (POSIX_REGEX)
 
-static vString* substitute (
+static void substitute (vString* const result,
 		const char* const in, const char* out,
 		const int nmatch, const regmatch_t* const pmatch)
 {
-	vString* result = vStringNew ();
 	const char* p;
+	vStringClear (result);
 	for (p = out  ;  *p != '\0'  ;  p++)
 	{
 		if (*p == '\\'  &&  isdigit ((int) *++p))
@@ -447,24 +463,24 @@ static vString* substitute (
 			vStringPut (result, *p);
 	}
 	vStringTerminate (result);
-	return result;
 }
 
 static void matchTagPattern (const vString* const line,
 		const regexPattern* const patbuf,
 		const regmatch_t* const pmatch)
 {
-	vString *const name = substitute (vStringValue (line),
+	if (TagName == NULL)
+		TagName = vStringNew ();
+	substitute (TagName, vStringValue (line),
 			patbuf->u.tag.name_pattern, BACK_REFERENCE_COUNT, pmatch);
-	vStringStripLeading (name);
-	vStringStripTrailing (name);
-	if (vStringLength (name) > 0)
-		makeRegexTag (name, &patbuf->u.tag.kind);
+	vStringStripLeading (TagName);
+	vStringStripTrailing (TagName);
+	if (vStringLength (TagName) > 0)
+		makeRegexTag (TagName, &patbuf->u.tag.kind);
 	else
 		error (WARNING, "%s:%ld: null expansion of name pattern \"%s\"",
 			getInputFileName (), getInputLineNumber (),
 			patbuf->u.tag.name_pattern);
-	vStringDelete (name);
 }
 
 static void matchCallbackPattern (
@@ -520,19 +536,47 @@ extern boolean matchRegex (const vString* const line, const langType language)
 		Sets [language].count > 0)
 	{
 		const patternSet* const set = Sets + language;
+		const boolean tracing = isTracing ();
+		const double start = tracing ? wallClock () : 0.0;
 		unsigned int i;
 		for (i = 0  ;  i < set->count  ;  ++i)
 			if (matchRegexPattern (line, set->patterns + i))
 				result = TRUE;
+		if (tracing)
+			traceRegexTime (wallClock () - start);
 	}
 	return result;
 }
 
 extern void findRegexTags (void)
 {
-	/* merely read all lines of the file */
-	while (fileReadLine () != NULL)
-		;
+	/* merely read all lines of the file, unless its time runs out */
+	catchParseTimeout (&Exception, 1);
+	if (setjmp (Exception) == 0)
+	{
+		while (fileReadLine () != NULL)
+			;
+	}
+}
+
+/*  Records the definition of the pattern last added for a language.
+ */
+static void addPatternSource (const langType language,
+		const char* const regex, const char* const name,
+		const char* const kinds, const char* const flags)
+{
+	patternSet* const set = Sets + language;
+
+	if (set->source == NULL)
+		set->source = vStringNew ();
+	vStringCatS (set->source, regex);
+	vStringPut (set->source, '\t');
+	vStringCatS (set->source, name == NULL ? "" : name);
+	vStringPut (set->source, '\t');
+	vStringCatS (set->source, kinds == NULL ? "" : kinds);
+	vStringPut (set->source, '\t');
+	vStringCatS (set->source, flags == NULL ? "" : flags);
+	vStringPut (set->source, '\n');
 }
 
 #endif  /* HAVE_REGEX */
@@ -558,6 +602,7 @@ extern void addTagRegex (
 			parseKinds (kinds, &kind, &kindName, &description);
 			addCompiledTagPattern (language, cp, eStrdup (name),
 					kind, kindName, description);
+			addPatternSource (language, regex, name, kinds, flags);
 		}
 	}
 #endif
@@ -575,7 +620,10 @@ extern void addCallbackRegex (
 	{
 		regex_t* const cp = compileRegex (regex, flags);
 		if (cp != NULL)
+		{
 			addCompiledCallbackPattern (language, cp, callback);
+			addPatternSource (language, regex, NULL, NULL, flags);
+		}
 	}
 #endif
 }
@@ -674,16 +722,48 @@ extern void printRegexKinds (const langType language __unused__, boolean indent
 #endif
 }
 
+/*  Appends to `description' the definitions of the patterns of a language
+ *  and whether each of their kinds is enabled, which together determine the
+ *  tags they make.
+ */
+extern void describeRegexPatterns (
+		const langType language __unused__, vString *const description __unused__)
+{
+#ifdef HAVE_REGEX
+	if (language <= SetUpper  &&  Sets [language].count > 0)
+	{
+		patternSet* const set = Sets + language;
+		unsigned int i;
+
+		if (set->source != NULL)
+			vStringCat (description, set->source);
+		for (i = 0  ;  i < set->count  ;  ++i)
+			if (set->patterns [i].type == PTRN_TAG)
+				vStringPut (description,
+						set->patterns [i].u.tag.kind.enabled ? '+' : '-');
+	}
+#endif
+}
+
 extern void freeRegexResources (void)
 {
 #ifdef HAVE_REGEX
 	int i;
 	for (i = 0  ;  i <= SetUpper  ;  ++i)
+	{
 		clearPatternSet (i);
+		if (Sets [i].source != NULL)
+			vStringDelete (Sets [i].source);
+	}
 	if (Sets != NULL)
 		eFree (Sets);
 	Sets = NULL;
 	SetUpper = -1;
+# if defined (POSIX_REGEX)
+	if (TagName != NULL)
+		vStringDelete (TagName);
+	TagName = NULL;
+# endif
 #endif
 }
 
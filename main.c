@@ -38,6 +38,9 @@
 #  endif
 # endif
 #endif
+#if defined (HAVE_GETRUSAGE) && defined (HAVE_SYS_RESOURCE_H)
+# include <sys/resource.h>  /* to declare getrusage() */
+#endif
 
 /*  To provide directory searching for recursion feature.
  */
@@ -82,6 +85,8 @@
 #include "options.h"
 #include "read.h"
 #include "routines.h"
+#include "tagcache.h"
+#include "trace.h"
 
 /*
 *   MACROS
@@ -93,6 +98,53 @@
 */
 static struct { long files, lines, bytes; } Totals = { 0, 0, 0 };
 
+/*  Times of the phases of the run, for --totals=extra. Reading the processor
+ *  clock is too costly to do around the writing of every tag, so it is read
+ *  only upon other changes of phase, and the processor time since it was last
+ *  read is divided among the phases in proportion to their elapsed time.
+ */
+static struct sPhaseTotals {
+	phase current;
+	double wallMark;                 /* elapsed time at last change */
+	clock_t cpuMark;                 /* processor time when last read */
+	double wall [PHASE_COUNT];       /* elapsed time of each phase */
+	double cpu [PHASE_COUNT];        /* processor time of each phase */
+	double unsampled [PHASE_COUNT];  /* elapsed time since cpuMark */
+	double parsing;                  /* elapsed time parsing current file */
+} Phases;
+
+static const char *const PhaseNames [PHASE_COUNT] = {
+	"traversal", "detection", "parsing", "writing", "sorting"
+};
+
+/*  Files, bytes and tags, and elapsed time spent parsing, by language.
+ */
+typedef struct sLanguageTotals {
+	unsigned long files, bytes, tags;
+	double seconds;
+} languageTotals;
+
+static languageTotals *LanguageTotals = NULL;
+static unsigned int LanguageTotalsCount = 0;
+
+/*  A file listed in the totals, as one of the slowest or one reparsed.
+ */
+typedef struct sFileTotals {
+	char *name;
+	unsigned long bytes, tags;
+	unsigned int passCount;
+	double seconds;
+} fileTotals;
+
+typedef struct sFileTotalsList {
+	fileTotals *file;
+	unsigned int count;
+	unsigned int max;
+} fileTotalsList;
+
+static fileTotalsList Slowest = { NULL, 0, 0 };   /* slowest first */
+static fileTotalsList Reparsed = { NULL, 0, 0 };  /* in order parsed */
+
 #ifdef AMIGA
 # include "ctags.h"
   static const char *VERsion = "$VER: "PROGRAM_NAME" "PROGRAM_VERSION" "
@@ -254,6 +306,7 @@ static boolean recurseIntoDirectory (const char *const dirName)
 	else
 	{
 		verbose ("RECURSING into directory \"%s\"\n", dirName);
+		traceBegin ("io", "directory", dirName);
 #if defined (HAVE_OPENDIR)
 		resize = recurseUsingOpendir (dirName);
 #elif defined (HAVE_FINDFIRST) || defined (HAVE__FINDFIRST)
@@ -279,10 +332,38 @@ static boolean recurseIntoDirectory (const char *const dirName)
 			vStringDelete (pattern);
 		}
 #endif
+		traceEnd ();
 	}
 	return resize;
 }
 
+/*  Determines whether a file belongs to the shard selected by --shard, by a
+ *  hash of its name which does not depend on the machine or the order in
+ *  which files are found. Leading "./" is ignored, so that "./a.c" and "a.c"
+ *  fall in the same shard.
+ */
+static boolean isInShard (const char *const fileName)
+{
+	boolean result = TRUE;
+
+	if (Option.shardCount > 1)
+	{
+		const unsigned char *p = (const unsigned char *) fileName;
+		unsigned long hash = 2166136261UL;
+
+		while (p [0] == '.'  &&  p [1] == OUTPUT_PATH_SEPARATOR)
+		{
+			p += 2;
+			while (*p == OUTPUT_PATH_SEPARATOR)
+				++p;
+		}
+		for (  ;  *p != '\0'  ;  ++p)
+			hash = ((hash ^ *p) * 16777619UL) & 0xffffffffUL;
+		result = (boolean) (hash % Option.shardCount == Option.shard - 1);
+	}
+	return result;
+}
+
 static boolean createTagsForEntry (const char *const entryName)
 {
 	boolean resize = FALSE;
@@ -299,6 +380,8 @@ static boolean createTagsForEntry (const char *const entryName)
 		resize = recurseIntoDirectory (entryName);
 	else if (! status->isNormalFile)
 		verbose ("ignoring \"%s\" (special file)\n", entryName);
+	else if (! isInShard (entryName))
+		verbose ("ignoring \"%s\" (other shard)\n", entryName);
 	else
 		resize = parseFile (entryName);
 
@@ -417,6 +500,296 @@ static clock_t clock (void)
 # define clock()  (clock_t)0
 #endif
 
+/*  Returns the peak resident memory of the process in kilobytes, or 0 if it
+ *  cannot be determined.
+ */
+static unsigned long peakMemory (void)
+{
+	unsigned long result = 0;
+#if defined (HAVE_GETRUSAGE) && defined (HAVE_SYS_RESOURCE_H)
+	struct rusage usage;
+	if (getrusage (RUSAGE_SELF, &usage) == 0)
+	{
+# ifdef __APPLE__
+		result = (unsigned long) usage.ru_maxrss / 1024;  /* in bytes */
+# else
+		result = (unsigned long) usage.ru_maxrss;
+# endif
+	}
+#endif
+	return result;
+}
+
+static void startPhases (void)
+{
+	memset (&Phases, 0, sizeof (Phases));
+	Phases.current = PHASE_TRAVERSE;
+	Phases.wallMark = wallClock ();
+	Phases.cpuMark = clock ();
+}
+
+/*  Charges the time since the last change of phase to the current phase.
+ */
+static void chargePhase (const boolean readProcessorClock)
+{
+	const double now = wallClock ();
+	const double elapsed = now - Phases.wallMark;
+
+	Phases.wall [Phases.current] += elapsed;
+	Phases.unsampled [Phases.current] += elapsed;
+	if (Phases.current == PHASE_PARSE  ||  Phases.current == PHASE_WRITE)
+		Phases.parsing += elapsed;
+	Phases.wallMark = now;
+	if (readProcessorClock)
+	{
+		const clock_t cpuNow = clock ();
+		const double cpu = (double) (cpuNow - Phases.cpuMark) / CLOCKS_PER_SEC;
+		double unsampled = 0.0;
+		int i;
+
+		for (i = 0  ;  i < PHASE_COUNT  ;  ++i)
+			unsampled += Phases.unsampled [i];
+		for (i = 0  ;  i < PHASE_COUNT  ;  ++i)
+		{
+			if (unsampled > 0.0)
+				Phases.cpu [i] += cpu * Phases.unsampled [i] / unsampled;
+			Phases.unsampled [i] = 0.0;
+		}
+		if (unsampled <= 0.0)
+			Phases.cpu [Phases.current] += cpu;
+		Phases.cpuMark = cpuNow;
+	}
+}
+
+/*  Makes `next' the current phase of the run, returning the previous one so
+ *  that it may be restored.
+ */
+extern phase switchPhase (const phase next)
+{
+	const phase previous = Phases.current;
+
+	if (Option.printTotals > TOTALS_BRIEF  &&  next != previous)
+	{
+		chargePhase ((boolean) (previous != PHASE_WRITE  &&
+								next != PHASE_WRITE));
+		Phases.current = next;
+	}
+	return previous;
+}
+
+/*  Inserts a copy of `file' into a list at `position'.
+ */
+static void insertFileTotals (
+		fileTotalsList *const list, const unsigned int position,
+		const fileTotals *const file)
+{
+	Assert (position <= list->count);
+	if (list->count == list->max)
+	{
+		list->max = (list->max == 0) ? 16 : 2 * list->max;
+		list->file = xRealloc (list->file, list->max, fileTotals);
+	}
+	memmove (list->file + position + 1, list->file + position,
+			(list->count - position) * sizeof (fileTotals));
+	list->file [position] = *file;
+	list->file [position].name = eStrdup (file->name);
+	++list->count;
+}
+
+static void freeFileTotals (fileTotalsList *const list)
+{
+	unsigned int i;
+	for (i = 0  ;  i < list->count  ;  ++i)
+		eFree (list->file [i].name);
+	if (list->file != NULL)
+		eFree (list->file);
+	list->file = NULL;
+	list->count = list->max = 0;
+}
+
+/*  Keeps the Option.slowest files parsed most slowly.
+ */
+static void addSlowestFile (const fileTotals *const file)
+{
+	if (Slowest.count < Option.slowest  ||  (Slowest.count > 0  &&
+		file->seconds > Slowest.file [Slowest.count - 1].seconds))
+	{
+		unsigned int position = Slowest.count;
+
+		if (Slowest.count == Option.slowest)
+		{
+			--Slowest.count;
+			eFree (Slowest.file [Slowest.count].name);
+			--position;
+		}
+		while (position > 0  &&
+			   file->seconds > Slowest.file [position - 1].seconds)
+		{
+			--position;
+		}
+		insertFileTotals (&Slowest, position, file);
+	}
+}
+
+/*  Adds a file just parsed to the totals of its language, and lists it if
+ *  it is among the slowest or needed more than one pass.
+ */
+extern void addFileTotals (
+		const char *const fileName, const langType language,
+		const unsigned long bytes, const unsigned long tags,
+		const unsigned int passCount)
+{
+	languageTotals *totals;
+	fileTotals file;
+
+	Assert (language >= 0);
+	if ((unsigned int) language >= LanguageTotalsCount)
+	{
+		const unsigned int count = language + 1;
+		LanguageTotals = xRealloc (LanguageTotals, count, languageTotals);
+		memset (LanguageTotals + LanguageTotalsCount, 0,
+				(count - LanguageTotalsCount) * sizeof (languageTotals));
+		LanguageTotalsCount = count;
+	}
+	totals = LanguageTotals + language;
+	++totals->files;
+	totals->bytes += bytes;
+	totals->tags += tags;
+	totals->seconds += Phases.parsing;
+
+	file.name = (char *) fileName;
+	file.bytes = bytes;
+	file.tags = tags;
+	file.passCount = passCount;
+	file.seconds = Phases.parsing;
+	addSlowestFile (&file);
+	if (passCount > 1)
+		insertFileTotals (&Reparsed, Reparsed.count, &file);
+	Phases.parsing = 0.0;
+}
+
+static double throughput (const unsigned long bytes, const double seconds)
+{
+	return seconds > 0.0 ? (double) bytes / (1024.0 * 1024.0) / seconds : 0.0;
+}
+
+static void printExtraTotals (void)
+{
+	double wall = 0.0, cpu = 0.0;
+	unsigned int i;
+
+	fprintf (errout, "%-12s %10s %10s\n", "phase", "wall (s)", "cpu (s)");
+	for (i = 0  ;  i < PHASE_COUNT  ;  ++i)
+	{
+		fprintf (errout, "%-12s %10.3f %10.3f\n",
+				PhaseNames [i], Phases.wall [i], Phases.cpu [i]);
+		wall += Phases.wall [i];
+		cpu += Phases.cpu [i];
+	}
+	fprintf (errout, "%-12s %10.3f %10.3f\n", "total", wall, cpu);
+
+	fprintf (errout, "%-12s %8s %10s %10s %8s\n",
+			"language", "files", "kB", "tags", "MB/s");
+	for (i = 0  ;  i < LanguageTotalsCount  ;  ++i)
+	{
+		const languageTotals *const totals = LanguageTotals + i;
+		if (totals->files > 0)
+			fprintf (errout, "%-12s %8lu %10lu %10lu %8.1f\n",
+					getLanguageName ((langType) i), totals->files,
+					totals->bytes / 1024L, totals->tags,
+					throughput (totals->bytes, totals->seconds));
+	}
+	if (Slowest.count > 0)
+		fprintf (errout, "slowest files:\n");
+	for (i = 0  ;  i < Slowest.count  ;  ++i)
+	{
+		const fileTotals *const file = Slowest.file + i;
+		fprintf (errout, "  %8.3f s %8lu kB %8lu tags  %s\n",
+				file->seconds, file->bytes / 1024L, file->tags, file->name);
+	}
+	if (Reparsed.count > 0)
+		fprintf (errout, "reparsed files:\n");
+	for (i = 0  ;  i < Reparsed.count  ;  ++i)
+	{
+		const fileTotals *const file = Reparsed.file + i;
+		fprintf (errout, "  %8.3f s %8u passes  %s\n",
+				file->seconds, file->passCount, file->name);
+	}
+	fprintf (errout, "peak memory: %lu kB\n", peakMemory ());
+}
+
+static void printJsonString (const char *const string)
+{
+	const unsigned char *p;
+
+	putc ('"', errout);
+	for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+	{
+		if (*p == '"'  ||  *p == '\\')
+			fprintf (errout, "\\%c", *p);
+		else if (*p < 0x20)
+			fprintf (errout, "\\u%04x", *p);
+		else
+			putc (*p, errout);
+	}
+	putc ('"', errout);
+}
+
+static void printJsonFiles (
+		const char *const key, const fileTotalsList *const list)
+{
+	unsigned int i;
+
+	fprintf (errout, ",\"%s\":[", key);
+	for (i = 0  ;  i < list->count  ;  ++i)
+	{
+		const fileTotals *const file = list->file + i;
+		fputs (i == 0 ? "{\"file\":" : ",{\"file\":", errout);
+		printJsonString (file->name);
+		fprintf (errout, ",\"seconds\":%.6f,\"bytes\":%lu,\"tags\":%lu"
+				",\"passes\":%u}",
+				file->seconds, file->bytes, file->tags, file->passCount);
+	}
+	putc (']', errout);
+}
+
+/*  Prints the totals as a single JSON object, for collection by other tools.
+ */
+static void printJsonTotals (void)
+{
+	unsigned int i;
+	const char *separator = "";
+
+	fprintf (errout, "{\"files\":%ld,\"lines\":%ld,\"bytes\":%ld",
+			Totals.files, Totals.lines, Totals.bytes);
+	fprintf (errout, ",\"tags\":%lu,\"duplicates\":%lu,\"cacheHits\":%lu",
+			TagFile.numTags.added, TagFile.numTags.duplicate, tagCacheHits ());
+	fputs (",\"phases\":{", errout);
+	for (i = 0  ;  i < PHASE_COUNT  ;  ++i)
+		fprintf (errout, "%s\"%s\":{\"wall\":%.6f,\"cpu\":%.6f}",
+				i == 0 ? "" : ",", PhaseNames [i],
+				Phases.wall [i], Phases.cpu [i]);
+	fputs ("},\"languages\":{", errout);
+	for (i = 0  ;  i < LanguageTotalsCount  ;  ++i)
+	{
+		const languageTotals *const totals = LanguageTotals + i;
+		if (totals->files > 0)
+		{
+			fputs (separator, errout);
+			printJsonString (getLanguageName ((langType) i));
+			fprintf (errout, ":{\"files\":%lu,\"bytes\":%lu,\"tags\":%lu"
+					",\"seconds\":%.6f,\"mbPerSecond\":%.3f}",
+					totals->files, totals->bytes, totals->tags, totals->seconds,
+					throughput (totals->bytes, totals->seconds));
+			separator = ",";
+		}
+	}
+	putc ('}', errout);
+	printJsonFiles ("slowest", &Slowest);
+	printJsonFiles ("reparsed", &Reparsed);
+	fprintf (errout, ",\"peakMemoryKB\":%lu}\n", peakMemory ());
+}
+
 static void printTotals (const clock_t *const timeStamps)
 {
 	const unsigned long totalTags = TagFile.numTags.added +
@@ -445,6 +818,14 @@ static void printTotals (const clock_t *const timeStamps)
 		fprintf (errout, " (now %lu tags)", totalTags);
 	fputc ('\n', errout);
 
+	if (Option.dedup)
+		fprintf (errout, "%lu duplicate tag%s dropped\n",
+				TagFile.numTags.duplicate, plural (TagFile.numTags.duplicate));
+
+	if (Option.cacheDirectory != NULL)
+		fprintf (errout, "%lu file%s read from tag cache\n",
+				tagCacheHits (), plural (tagCacheHits ()));
+
 	if (totalTags > 0  &&  Option.sorted != SO_UNSORTED)
 	{
 		fprintf (errout, "%lu tag%s sorted", totalTags, plural (totalTags));
@@ -459,6 +840,9 @@ static void printTotals (const clock_t *const timeStamps)
 	fprintf (errout, "longest tag line = %lu\n",
 			(unsigned long) TagFile.max.line);
 #endif
+
+	if (Option.printTotals == TOTALS_EXTRA)
+		printExtraTotals ();
 }
 
 static boolean etagsInclude (void)
@@ -473,6 +857,20 @@ static void makeTags (cookedArgs *args)
 	boolean files = (boolean)(! cArgOff (args) || Option.fileList != NULL
 							  || Option.filter);
 
+	if (Option.merge != NULL)
+	{
+		if (files)
+			error (FATAL, "source files cannot be given with --merge");
+		if (Option.traceFile != NULL)
+			openTrace (Option.traceFile);
+		mergeTagFiles (Option.merge);
+		closeTrace ();
+		if (Option.printTotals)
+			fprintf (errout, "%lu tag%s written, %lu duplicate%s dropped\n",
+				TagFile.numTags.added, plural (TagFile.numTags.added),
+				TagFile.numTags.duplicate, plural (TagFile.numTags.duplicate));
+		return;
+	}
 	if (! files)
 	{
 		if (filesRequired ())
@@ -481,12 +879,16 @@ static void makeTags (cookedArgs *args)
 		else if (! Option.recurse && ! etagsInclude ())
 			return;
 	}
+	if (Option.traceFile != NULL)
+		openTrace (Option.traceFile);
 
 #define timeStamp(n) timeStamps[(n)]=(Option.printTotals ? clock():(clock_t)0)
 	if (! Option.filter)
 		openTagFile ();
 
 	timeStamp (0);
+	if (Option.printTotals > TOTALS_BRIEF)
+		startPhases ();
 
 	if (! cArgOff (args))
 	{
@@ -508,13 +910,25 @@ static void makeTags (cookedArgs *args)
 
 	timeStamp (1);
 
+	switchPhase (PHASE_SORT);
 	if (! Option.filter)
 		closeTagFile (resize);
 
 	timeStamp (2);
+	closeTrace ();
 
-	if (Option.printTotals)
+	if (Option.printTotals > TOTALS_BRIEF)
+		chargePhase (TRUE);
+	if (Option.printTotals == TOTALS_JSON)
+		printJsonTotals ();
+	else if (Option.printTotals)
 		printTotals (timeStamps);
+	if (LanguageTotals != NULL)
+		eFree (LanguageTotals);
+	LanguageTotals = NULL;
+	LanguageTotalsCount = 0;
+	freeFileTotals (&Slowest);
+	freeFileTotals (&Reparsed);
 #undef timeStamp
 }
 
@@ -568,6 +982,7 @@ extern int main (int __unused__ argc, char **argv)
 	freeRoutineResources ();
 	freeSourceFileResources ();
 	freeTagFileResources ();
+	freeTagCacheResources ();
 	freeOptionResources ();
 	freeParserResources ();
 	freeRegexResources ();
@@ -18,12 +18,30 @@
 
 #include <stdio.h>
 
+#include "parse.h"
 #include "vstring.h"
 
+/*
+*   DATA DECLARATIONS
+*/
+
+/*  Phases of a run, between which its time is divided by --totals=extra.
+ */
+typedef enum ePhase {
+	PHASE_TRAVERSE,  /* finding the files to tag */
+	PHASE_DETECT,    /* determining their languages */
+	PHASE_PARSE,     /* parsing them */
+	PHASE_WRITE,     /* writing their tags */
+	PHASE_SORT,      /* sorting and completing the tag file */
+	PHASE_COUNT
+} phase;
+
 /*
 *   FUNCTION PROTOTYPES
 */
 extern void addTotals (const unsigned int files, const long unsigned int lines, const long unsigned int bytes);
+extern void addFileTotals (const char *const fileName, const langType language, const unsigned long bytes, const unsigned long tags, const unsigned int passCount);
+extern phase switchPhase (const phase next);
 extern boolean isDestinationStdout (void);
 extern int main (int argc, char **argv);
 
@@ -89,7 +89,7 @@ MAN2HTML := tbl | groff -Wall -mtty-char -mandoc -Thtml -c
 default: all
 ifeq ($(findstring clean,$(MAKECMDGOALS)),)
 ifeq ($(wildcard config.h),)
-ctags dctags ctags.prof ctags.cov:
+ctags dctags ctags.prof ctags.cov microbench:
 	$(MAKE) config.h
 	$(MAKE) $(MAKECMDGOALS)
 else
@@ -128,6 +128,16 @@ etyperef: etyperef.o keyword.o routines.o strlist.o vstring.o
 etyperef.o: eiffel.c
 	$(CC) -DTYPE_REFERENCE_TOOL $(OPT) $(COMP_FLAGS) -o $@ -c $<
 
+microbench: $(OBJECTS:main.o=benchmain.o) microbench.o microtags.o readtags.o
+	@ echo "-- Linking $@"
+	@ $(LD) -o $@ $(LDFLAGS) $^
+
+benchmain.o: main.c
+	$(CC) -Dmain=ctagsMain $(COMP_FLAGS) -DEXTERNAL_SORT $(OPT) -o $@ -c $<
+
+microbench.o microtags.o: %.o: Bench/%.c Bench/microbench.h
+	$(CC) $(COMP_FLAGS) $(OPT) -o $@ -c $<
+
 endif
 endif
 
@@ -159,8 +169,8 @@ profclean:
 gcovclean:
 	rm -f $(COV_GEN)
 
-clean: depclean profclean gcovclean clean-test
-	rm -f *.[ois] *.o[dm] ctags dctags ctags*.exe readtags etyperef \
+clean: depclean profclean gcovclean clean-test clean-bench
+	rm -f *.[ois] *.o[dm] ctags dctags ctags*.exe readtags etyperef microbench \
 		ctags.man ctags.html ctags.prof ctags.cov *.bb *.bbg tags TAGS syntax.vim
 
 distclean: clean
@@ -194,6 +204,11 @@ syntax.vim: $(DSOURCES) $(HEADERS) $(LIB_FILES)
 #
 -include testing.mak
 
+#
+# Benchmarking
+#
+-include benchmark.mak
+
 #
 # Help
 #
@@ -201,6 +216,7 @@ help:
 	@ echo "Major targets:"
 	@ echo "default     : Build dctags, with debugging support"
 	@ echo "ctags       : Build optimized binary"
+	@ echo "bench       : Compare the speed of ctags with the stored baseline"
 	@ echo "help-release: Print help on releasing ctags"
 
 #
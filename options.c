@@ -18,6 +18,8 @@
 #include <string.h>
 #include <stdio.h>
 #include <ctype.h>  /* to declare isspace () */
+#include <errno.h>
+#include <limits.h>  /* to define UINT_MAX */
 
 #include "ctags.h"
 #include "debug.h"
@@ -94,6 +96,7 @@ typedef const struct {
 static boolean NonOptionEncountered;
 static stringList *OptionFiles;
 static stringList* Excluded;
+static stringList* GeneratedMarkers;
 static boolean FilesRequired = TRUE;
 static boolean SkipConfiguration;
 
@@ -146,8 +149,21 @@ optionValues Option = {
 	FALSE,      /* --filter */
 	NULL,       /* --filter-terminator */
 	FALSE,      /* --tag-relative */
-	FALSE,      /* --totals */
+	TOTALS_NONE,/* --totals */
 	FALSE,      /* --line-directives */
+	FALSE,      /* --tag-index */
+	FALSE,      /* --dedup */
+	NULL,       /* --merge */
+	0, 0,       /* --shard */
+	NULL,       /* --cache */
+	10,         /* --slowest */
+	NULL,       /* --trace */
+	0,          /* --max-file-size */
+	0.0,        /* --parse-timeout */
+	FALSE,      /* --skip-binary */
+	FALSE,      /* --skip-generated */
+	0,          /* --skip-long-lines */
+	OUTPUT_CTAGS,/* --output-format */
 #ifdef DEBUG
 	0, 0        /* -D, -b */
 #endif
@@ -195,6 +211,10 @@ static optionDescription LongOptionDescription [] = {
  {1,"  -x   Print a tabular cross reference file to standard output."},
  {1,"  --append=[yes|no]"},
  {1,"       Should tags should be appended to existing tag file [no]?"},
+ {1,"  --cache=directory"},
+ {1,"       Reuse the tags of unchanged files from a cache in 'directory'."},
+ {1,"  --dedup=[yes|no]"},
+ {1,"       Drop duplicate tags as they are generated, even when unsorted [no]."},
  {1,"  --etags-include=file"},
  {1,"      Include reference to 'file' in Emacs-style tag file (requires -e)."},
  {1,"  --exclude=pattern"},
@@ -224,6 +244,9 @@ static optionDescription LongOptionDescription [] = {
 #else
  {0,"       Force output of specified tag file format [2]."},
 #endif
+ {1,"  --generated-marker=[text]"},
+ {1,"       Add text marking a file as generated for --skip-generated."},
+ {1,"       If no text is supplied, the list of markers is cleared."},
  {1,"  --help"},
  {1,"       Print this option summary."},
  {1,"  --if0=[yes|no]"},
@@ -252,8 +275,17 @@ static optionDescription LongOptionDescription [] = {
  {1,"       Output list of supported languages."},
  {1,"  --list-maps=[language|all]"},
  {1,"       Output list of language mappings."},
+ {1,"  --max-file-size=size"},
+ {1,"       Skip files larger than 'size' bytes, or k, m or g bytes [0: no limit]."},
+ {1,"  --merge=file[,file[...]]"},
+ {1,"       Merge sorted tag files into the tag file, in place of generating tags."},
  {1,"  --options=file"},
  {1,"       Specify file from which command line options should be read."},
+ {1,"  --output-format=[ctags|binary|json]"},
+ {1,"       Write tags as text lines, as a compact binary tag file, or as"},
+ {1,"       JSON objects, one per line [ctags]."},
+ {1,"  --parse-timeout=seconds"},
+ {1,"       Abandon the tags of a file not parsed within 'seconds' [0: no limit]."},
  {1,"  --recurse=[yes|no]"},
 #ifdef RECURSE_SUPPORTED
  {1,"       Recurse into directories supplied on command line [no]."},
@@ -264,12 +296,27 @@ static optionDescription LongOptionDescription [] = {
  {1,"  --regex-<LANG>=/line_pattern/name_pattern/[flags]"},
  {1,"       Define regular expression for locating tags in specific language."},
 #endif
+ {1,"  --shard=i/n"},
+ {1,"       Tag only the files of shard i of n, chosen by a hash of each file name."},
+ {1,"  --skip-binary=[yes|no]"},
+ {1,"       Skip files holding a NUL byte in their first block [no]."},
+ {1,"  --skip-generated=[yes|no]"},
+ {1,"       Skip files naming a generator marker in their first block [no]."},
+ {1,"  --skip-long-lines=length"},
+ {1,"       Skip files with a line longer than 'length' in their first block [0]."},
+ {1,"  --slowest=number"},
+ {1,"       Number of slowest files listed by --totals=extra or json [10]."},
  {0,"  --sort=[yes|no|foldcase]"},
  {0,"       Should tags be sorted (optionally ignoring case) [yes]?."},
+ {1,"  --tag-index=[yes|no]"},
+ {1,"       Write an index of the tag file for use by readtags [no]."},
  {0,"  --tag-relative=[yes|no]"},
  {0,"       Should paths be relative to location of tag file [no; yes when -e]?"},
- {1,"  --totals=[yes|no]"},
+ {1,"  --trace=file"},
+ {1,"       Write a trace of the run to 'file' for the Chrome or Perfetto viewers."},
+ {1,"  --totals=[yes|no|extra|json]"},
  {1,"       Print statistics about source and tag files [no]."},
+ {1,"       'extra' adds time by phase and language; 'json' prints that as JSON."},
  {1,"  --verbose=[yes|no]"},
  {1,"       Enable verbose messages describing actions on each source file."},
  {1,"  --version"},
@@ -425,11 +472,81 @@ extern void checkOptions (void)
 		if (Option.printTotals)
 		{
 			error (WARNING, "%s disables totals", notice);
-			Option.printTotals = FALSE;
+			Option.printTotals = TOTALS_NONE;
 		}
 		if (Option.tagFileName != NULL)
 			error (WARNING, "%s ignores output tag file name", notice);
 	}
+	if (Option.outputFormat == OUTPUT_BINARY)
+	{
+		notice = "binary output is not written for";
+		if (Option.etags  ||  Option.xref)
+		{
+			error (WARNING, "%s %s", notice,
+				Option.etags ? "etags" : "xref output");
+			Option.outputFormat = OUTPUT_CTAGS;
+		}
+		else if (Option.filter  ||  isDestinationStdout ())
+		{
+			error (WARNING, "%s tags to stdout", notice);
+			Option.outputFormat = OUTPUT_CTAGS;
+		}
+		else if (Option.append)
+			error (FATAL, "append mode is not compatible with binary output");
+		else
+		{
+			if (Option.sorted == SO_UNSORTED)
+			{
+				error (WARNING, "binary output requires sorted tags");
+				Option.sorted = SO_SORTED;
+			}
+			if (Option.tagIndex)
+			{
+				error (WARNING, "binary output needs no tag index");
+				Option.tagIndex = FALSE;
+			}
+		}
+	}
+	if (Option.outputFormat == OUTPUT_JSON  &&  (Option.etags  ||  Option.xref))
+	{
+		error (WARNING, "JSON output is not written for %s",
+			Option.etags ? "etags" : "xref output");
+		Option.outputFormat = OUTPUT_CTAGS;
+	}
+	if (Option.merge != NULL)
+	{
+		notice = "merging of tag files is not compatible with";
+		if (Option.etags  ||  Option.xref)
+			error (FATAL, "%s %s", notice, Option.etags ? "etags" : "xref output");
+		else if (Option.outputFormat == OUTPUT_JSON)
+			error (FATAL, "%s JSON output", notice);
+		else if (Option.append)
+			error (FATAL, "%s append mode", notice);
+		else if (Option.filter)
+			error (FATAL, "%s filter mode", notice);
+		else if (Option.sorted == SO_UNSORTED)
+			error (FATAL, "%s unsorted tags", notice);
+	}
+	if (Option.tagIndex)
+	{
+		notice = "tag index requires a ctags format tag file;";
+		if (Option.outputFormat == OUTPUT_JSON)
+		{
+			error (WARNING, "%s not written for JSON output", notice);
+			Option.tagIndex = FALSE;
+		}
+		else if (Option.etags  ||  Option.xref)
+		{
+			error (WARNING, "%s not written for %s", notice,
+				Option.etags ? "etags" : "xref output");
+			Option.tagIndex = FALSE;
+		}
+		else if (Option.filter  ||  isDestinationStdout ())
+		{
+			error (WARNING, "%s not written for tags to stdout", notice);
+			Option.tagIndex = FALSE;
+		}
+	}
 }
 
 static void setEtagsMode (void)
@@ -697,6 +814,28 @@ static boolean isTrue (const char *parameter)
 		strcasecmp (parameter, "on" ) == 0);
 }
 
+/*  Reads the unsigned decimal number starting `parameter' into `value',
+ *  returning the text following it, or NULL if there is no number or it is
+ *  out of range. Unlike sscanf () and strtoul (), no sign is accepted, so
+ *  that "-1" is not taken for a very large number.
+ */
+static const char *readUnsigned (
+		const char *const parameter, unsigned long *const value)
+{
+	const char *rest = NULL;
+
+	if (isdigit ((int) parameter [0]))
+	{
+		char *end;
+
+		errno = 0;
+		*value = strtoul (parameter, &end, 10);
+		if (errno == 0)
+			rest = end;
+	}
+	return rest;
+}
+
 /*  Determines whether the specified file name is considered to be a header
  *  file for the purposes of determining whether enclosed tags are global or
  *  static.
@@ -729,6 +868,38 @@ static void processEtagsInclude (
 	}
 }
 
+static void processMergeOption (
+		const char *const option __unused__, const char *const parameter)
+{
+	const char *start = parameter;
+	const char *end;
+
+	if (Option.merge == NULL)
+		Option.merge = stringListNew ();
+	do
+	{
+		end = strchr (start, ',');
+		if (end == NULL)
+			end = start + strlen (start);
+		if (end > start)
+		{
+			vString *const file = vStringNew ();
+			vStringNCopyS (file, start, (size_t) (end - start));
+			stringListAdd (Option.merge, file);
+		}
+		start = end + 1;
+	} while (*end != '\0');
+	FilesRequired = FALSE;
+}
+
+static void processCacheOption (
+		const char *const option __unused__, const char *const parameter)
+{
+	freeString (&Option.cacheDirectory);
+	if (parameter [0] != '\0')
+		Option.cacheDirectory = stringCopy (parameter);
+}
+
 static void processExcludeOption (
 		const char *const option __unused__, const char *const parameter)
 {
@@ -756,6 +927,44 @@ static void processExcludeOption (
 	}
 }
 
+static void processGeneratedMarkerOption (
+		const char *const option __unused__, const char *const parameter)
+{
+	if (parameter [0] == '\0')
+		freeList (&GeneratedMarkers);
+	else
+	{
+		vString *const item = vStringNewInit (parameter);
+		if (GeneratedMarkers == NULL)
+			GeneratedMarkers = stringListNew ();
+		stringListAdd (GeneratedMarkers, item);
+		verbose ("    adding generated file marker: %s\n", parameter);
+	}
+}
+
+/*  Does the text, taken from the start of a file, hold any of the markers
+ *  left by generators of source files?
+ */
+extern boolean isGeneratedText (const char *const text)
+{
+	boolean result = FALSE;
+	unsigned int i;
+
+	if (GeneratedMarkers != NULL)
+	{
+		for (i = 0  ;  ! result  &&  i < stringListCount (GeneratedMarkers)  ;  ++i)
+		{
+			const vString *const marker = stringListItem (GeneratedMarkers, i);
+			if (vStringLength (marker) > 0  &&
+				strstr (text, vStringValue (marker)) != NULL)
+			{
+				result = TRUE;
+			}
+		}
+	}
+	return result;
+}
+
 extern boolean isExcludedFile (const char* const name)
 {
 	const char* base = baseFilename (name);
@@ -886,6 +1095,25 @@ static void processFormatOption (
 		error (FATAL, "Unsupported value for \"%s\" option", option);
 }
 
+static void processShardOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long shard, count = 0;
+	const char *rest = readUnsigned (parameter, &shard);
+
+	if (rest != NULL  &&  *rest == '/')
+		rest = readUnsigned (rest + 1, &count);
+	else
+		rest = NULL;
+	if (rest == NULL  ||  *rest != '\0'  ||
+		shard < 1  ||  shard > count  ||  count > UINT_MAX)
+	{
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	}
+	Option.shard = (unsigned int) shard;
+	Option.shardCount = (unsigned int) count;
+}
+
 static void printInvocationDescription (void)
 {
 	printf (INVOCATION, getExecutableName ());
@@ -1199,6 +1427,17 @@ static void processOptionFile (
 		error (FATAL | PERROR, "cannot open option file \"%s\"", parameter);
 }
 
+static void processSlowestOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long count;
+	const char *const rest = readUnsigned (parameter, &count);
+
+	if (rest == NULL  ||  *rest != '\0'  ||  count > UINT_MAX)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.slowest = (unsigned int) count;
+}
+
 static void processSortOption (
 		const char *const option, const char *const parameter)
 {
@@ -1214,6 +1453,92 @@ static void processSortOption (
 		error (FATAL, "Invalid value for \"%s\" option", option);
 }
 
+static void processTraceOption (
+		const char *const option __unused__, const char *const parameter)
+{
+	freeString (&Option.traceFile);
+	if (parameter [0] != '\0')
+		Option.traceFile = stringCopy (parameter);
+}
+
+static void processTotalsOption (
+		const char *const option, const char *const parameter)
+{
+	if (isFalse (parameter))
+		Option.printTotals = TOTALS_NONE;
+	else if (parameter [0] == '\0'  ||  isTrue (parameter))
+		Option.printTotals = TOTALS_BRIEF;
+	else if (strcasecmp (parameter, "extra") == 0)
+		Option.printTotals = TOTALS_EXTRA;
+	else if (strcasecmp (parameter, "json") == 0)
+		Option.printTotals = TOTALS_JSON;
+	else
+		error (FATAL, "Invalid value for \"%s\" option", option);
+}
+
+static void processOutputFormatOption (
+		const char *const option, const char *const parameter)
+{
+	if (strcasecmp (parameter, "ctags") == 0)
+		Option.outputFormat = OUTPUT_CTAGS;
+	else if (strcasecmp (parameter, "binary") == 0)
+		Option.outputFormat = OUTPUT_BINARY;
+	else if (strcasecmp (parameter, "json") == 0)
+		Option.outputFormat = OUTPUT_JSON;
+	else
+		error (FATAL, "Invalid value for \"%s\" option", option);
+}
+
+static void processMaxFileSizeOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long size;
+	const char *const rest = readUnsigned (parameter, &size);
+	boolean valid = (boolean) (rest != NULL);
+
+	if (valid  &&  *rest != '\0')
+	{
+		unsigned long scale = 1;
+
+		switch (tolower ((int) *rest))
+		{
+			case 'g': scale = 1024UL * 1024UL * 1024UL; break;
+			case 'm': scale = 1024UL * 1024UL;          break;
+			case 'k': scale = 1024UL;                   break;
+			default:  valid = FALSE;                    break;
+		}
+		if (rest [1] != '\0'  ||  size > ULONG_MAX / scale)
+			valid = FALSE;
+		else
+			size *= scale;
+	}
+	if (! valid)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.maxFileSize = size;
+}
+
+static void processSkipLongLinesOption (
+		const char *const option, const char *const parameter)
+{
+	unsigned long length;
+	const char *const rest = readUnsigned (parameter, &length);
+
+	if (rest == NULL  ||  *rest != '\0')
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.skipLineLength = length;
+}
+
+static void processParseTimeoutOption (
+		const char *const option, const char *const parameter)
+{
+	double seconds;
+	char extra;
+
+	if (sscanf (parameter, "%lf%c", &seconds, &extra) != 1  ||  seconds < 0.0)
+		error (FATAL, "Invalid value for \"%s\" option", option);
+	Option.parseTimeout = seconds;
+}
+
 static void installHeaderListDefaults (void)
 {
 	Option.headerExt = stringListNewFromArgv (HeaderExtensions);
@@ -1370,6 +1695,7 @@ static void processVersionOption (
  */
 
 static parametricOption ParametricOptions [] = {
+	{ "cache",                  processCacheOption,             TRUE    },
 	{ "etags-include",          processEtagsInclude,            FALSE   },
 	{ "exclude",                processExcludeOption,           FALSE   },
 	{ "excmd",                  processExcmdOption,             FALSE   },
@@ -1377,6 +1703,7 @@ static parametricOption ParametricOptions [] = {
 	{ "fields",                 processFieldsOption,            FALSE   },
 	{ "filter-terminator",      processFilterTerminatorOption,  TRUE    },
 	{ "format",                 processFormatOption,            TRUE    },
+	{ "generated-marker",       processGeneratedMarkerOption,   FALSE   },
 	{ "help",                   processHelpOption,              TRUE    },
 	{ "lang",                   processLanguageForceOption,     FALSE   },
 	{ "language",               processLanguageForceOption,     FALSE   },
@@ -1388,13 +1715,23 @@ static parametricOption ParametricOptions [] = {
 	{ "list-kinds",             processListKindsOption,         TRUE    },
 	{ "list-maps",              processListMapsOption,          TRUE    },
 	{ "list-languages",         processListLanguagesOption,     TRUE    },
+	{ "max-file-size",          processMaxFileSizeOption,       FALSE   },
+	{ "merge",                  processMergeOption,             TRUE    },
 	{ "options",                processOptionFile,              FALSE   },
+	{ "output-format",          processOutputFormatOption,      TRUE    },
+	{ "parse-timeout",          processParseTimeoutOption,      FALSE   },
+	{ "shard",                  processShardOption,             TRUE    },
+	{ "skip-long-lines",        processSkipLongLinesOption,     FALSE   },
+	{ "slowest",                processSlowestOption,           TRUE    },
 	{ "sort",                   processSortOption,              TRUE    },
+	{ "totals",                 processTotalsOption,            TRUE    },
+	{ "trace",                  processTraceOption,             TRUE    },
 	{ "version",                processVersionOption,           TRUE    },
 };
 
 static booleanOption BooleanOptions [] = {
 	{ "append",         &Option.append,                 TRUE    },
+	{ "dedup",          &Option.dedup,                  TRUE    },
 	{ "file-scope",     &Option.include.fileScope,      FALSE   },
 	{ "file-tags",      &Option.include.fileNames,      FALSE   },
 	{ "filter",         &Option.filter,                 TRUE    },
@@ -1405,8 +1742,10 @@ static booleanOption BooleanOptions [] = {
 #ifdef RECURSE_SUPPORTED
 	{ "recurse",        &Option.recurse,                FALSE   },
 #endif
+	{ "skip-binary",    &Option.skipBinary,             FALSE   },
+	{ "skip-generated", &Option.skipGenerated,          FALSE   },
+	{ "tag-index",      &Option.tagIndex,               TRUE    },
 	{ "tag-relative",   &Option.tagRelative,            TRUE    },
-	{ "totals",         &Option.printTotals,            TRUE    },
 	{ "verbose",        &Option.verbose,                FALSE   },
 };
 
@@ -1811,6 +2150,13 @@ extern void initOptions (void)
 	processExcludeOption (NULL, "RESYNC");
 	processExcludeOption (NULL, "SCCS");
 	processExcludeOption (NULL, ".svn");
+
+	verbose ("  Installing default generated file markers:\n");
+	processGeneratedMarkerOption (NULL, "DO NOT EDIT");
+	processGeneratedMarkerOption (NULL, "@generated");
+	processGeneratedMarkerOption (NULL, "A Bison parser, made by");
+	processGeneratedMarkerOption (NULL, "automatically generated");
+	processGeneratedMarkerOption (NULL, "Automatically generated");
 }
 
 extern void freeOptionResources (void)
@@ -1818,11 +2164,15 @@ extern void freeOptionResources (void)
 	freeString (&Option.tagFileName);
 	freeString (&Option.fileList);
 	freeString (&Option.filterTerminator);
+	freeString (&Option.cacheDirectory);
+	freeString (&Option.traceFile);
 
 	freeList (&Excluded);
+	freeList (&GeneratedMarkers);
 	freeList (&Option.ignore);
 	freeList (&Option.headerExt);
 	freeList (&Option.etagsInclude);
+	freeList (&Option.merge);
 	freeList (&OptionFiles);
 }
 
@@ -53,6 +53,19 @@ typedef enum eLocate {
 	EX_PATTERN   /* -N  only patterns in tag file */
 } exCmd;
 
+typedef enum eOutputFormat {
+	OUTPUT_CTAGS,   /* text tag lines */
+	OUTPUT_BINARY,  /* binary tag file (see tagbinary.h) */
+	OUTPUT_JSON     /* JSON Lines: one JSON object per tag */
+} outputFormat;
+
+typedef enum eTotalsType {
+	TOTALS_NONE,
+	TOTALS_BRIEF,   /* source files read and tags written */
+	TOTALS_EXTRA,   /* also time by phase and language, and peak memory */
+	TOTALS_JSON     /* TOTALS_EXTRA as a JSON object */
+} totalsType;
+
 typedef enum sortType {
 	SO_UNSORTED,
 	SO_SORTED,
@@ -106,8 +119,22 @@ typedef struct sOptionValues {
 	boolean filter;         /* --filter  behave as filter: files in, tags out */
 	char* filterTerminator; /* --filter-terminator  string to output */
 	boolean tagRelative;    /* --tag-relative file paths relative to tag file */
-	boolean printTotals;    /* --totals  print cumulative statistics */
+	totalsType printTotals; /* --totals  print cumulative statistics */
 	boolean lineDirectives; /* --linedirectives  process #line directives */
+	boolean tagIndex;       /* --tag-index  write sidecar index of tag file */
+	boolean dedup;          /* --dedup  drop duplicate tags as they are made */
+	stringList* merge;      /* --merge  sorted tag files to merge */
+	unsigned int shard;     /* --shard  shard of files to tag (from 1) */
+	unsigned int shardCount;/* --shard  number of shards; 0 if unsharded */
+	char* cacheDirectory;   /* --cache  directory of tag cache */
+	unsigned int slowest;   /* --slowest  number of slowest files in totals */
+	char* traceFile;        /* --trace  file to write trace of run to */
+	unsigned long maxFileSize;/* --max-file-size  largest file parsed; 0 if any */
+	double parseTimeout;    /* --parse-timeout  seconds allowed each file */
+	boolean skipBinary;     /* --skip-binary  skip files holding NUL bytes */
+	boolean skipGenerated;  /* --skip-generated  skip generated files */
+	unsigned long skipLineLength;/* --skip-long-lines  longest line of file */
+	outputFormat outputFormat;/* --output-format  format of tag file */
 #ifdef DEBUG
 	long debugLevel;        /* -D  debugging output */
 	unsigned long breakLine;/* -b  source line at which to call lineBreak() */
@@ -140,6 +167,7 @@ extern const char* cArgItem (cookedArgs* const current);
 extern void cArgForth (cookedArgs* const current);
 
 extern boolean isExcludedFile (const char* const name);
+extern boolean isGeneratedText (const char *const text);
 extern boolean isIncludeFile (const char *const fileName);
 extern boolean isIgnoreToken (const char *const name, boolean *const pIgnoreParens, const char **const replacement);
 extern void parseOption (cookedArgs* const cargs);
@@ -16,6 +16,7 @@
 #include "general.h"  /* must always come first */
 
 #include <string.h>
+#include <setjmp.h>
 
 #include "debug.h"
 #include "entry.h"
@@ -25,8 +26,16 @@
 #include "parsers.h" 
 #include "read.h"
 #include "routines.h"
+#include "tagcache.h"
+#include "trace.h"
 #include "vstring.h"
 
+/*
+*   MACROS
+*/
+#define PARSE_CHECK_INTERVAL  65536  /* bytes between checks of the clock */
+#define PROBE_SIZE            8192   /* bytes of a file probed before parsing */
+
 /*
 *   DATA DEFINITIONS
 */
@@ -34,6 +43,22 @@ static parserDefinitionFunc* BuiltInParsers[] = { PARSER_LIST };
 static parserDefinition** LanguageTable = NULL;
 static unsigned int LanguageCount = 0;
 
+/*  Limits the time spent parsing a file to that allowed by --parse-timeout.
+ */
+static struct sParseTimer {
+	boolean armed;          /* is the file being parsed timed? */
+	boolean expired;        /* was the parse of the file abandoned? */
+	double deadline;        /* elapsed time by which the parse must end */
+	unsigned long budget;   /* bytes remaining before the next check */
+	jmp_buf *catcher;       /* context of parser catching expiry */
+	int exception;          /* value with which to return to catcher */
+} ParseTimer;
+
+/*  Number of anonymous names (e.g. "__anon3") made so far, which are numbered
+ *  across all of the files tagged.
+ */
+static unsigned int AnonymousCount = 0;
+
 /*
 *   FUNCTION DEFINITIONS
 */
@@ -57,6 +82,28 @@ extern void makeSimpleTag (
 *   parserDescription mapping management
 */
 
+/*  Returns the number of the next anonymous name, which follows
+ *  ANONYMOUS_PREFIX in the name.
+ */
+extern unsigned int nextAnonymousNumber (void)
+{
+	return ++AnonymousCount;
+}
+
+extern unsigned int getAnonymousCount (void)
+{
+	return AnonymousCount;
+}
+
+/*  Sets the number of anonymous names made, for a parser resuming from an
+ *  earlier point and for the tag cache, which makes those of a cached file
+ *  without parsing it.
+ */
+extern void setAnonymousCount (const unsigned int count)
+{
+	AnonymousCount = count;
+}
+
 extern parserDefinition* parserNew (const char* name)
 {
 	parserDefinition* result = xCalloc (1, parserDefinition);
@@ -532,6 +579,27 @@ extern void printLanguageKinds (const langType language)
 		printKinds (language, FALSE);
 }
 
+/*  Appends to `description' the settings of a language which determine the
+ *  tags its parser makes: its name and the kinds it has enabled.
+ */
+extern void describeLanguage (
+		const langType language, vString *const description)
+{
+	const parserDefinition* lang;
+	unsigned int i;
+	Assert (0 <= language  &&  language < (int) LanguageCount);
+	lang = LanguageTable [language];
+	vStringCatS (description, lang->name);
+	vStringPut (description, '\n');
+	for (i = 0  ;  i < lang->kindCount  ;  ++i)
+	{
+		vStringPut (description, lang->kinds [i].letter);
+		vStringPut (description, lang->kinds [i].enabled ? '+' : '-');
+	}
+	vStringPut (description, '\n');
+	describeRegexPatterns (language, description);
+}
+
 static void printMaps (const langType language)
 {
 	const parserDefinition* lang;
@@ -599,13 +667,73 @@ static void makeFileTag (const char *const fileName)
 	}
 }
 
+/*
+ *  Parse time limits
+ */
+
+/*  Starts the time allowed for all passes over a file. The timer is armed
+ *  only once its parser has said how to catch its expiry (see
+ *  catchParseTimeout ()), and disarmed when the parser returns.
+ */
+static void startParseTimer (void)
+{
+	ParseTimer.armed = FALSE;
+	ParseTimer.expired = FALSE;
+	ParseTimer.deadline = wallClock () + Option.parseTimeout;
+	ParseTimer.budget = PARSE_CHECK_INTERVAL;
+}
+
+/*  Lets a parser which raises exceptions of its own by longjmp () catch the
+ *  expiry of its time as one, which it must handle as it does the end of
+ *  the file, freeing what it has allocated and resetting its state before
+ *  returning. Only the parse of such a parser is timed, since no other may
+ *  safely be interrupted. Lasts until the parser returns.
+ */
+extern void catchParseTimeout (jmp_buf *const context, const int exception)
+{
+	ParseTimer.catcher = context;
+	ParseTimer.exception = exception;
+	ParseTimer.armed = (boolean) (Option.parseTimeout > 0.0  &&
+			! ParseTimer.expired);
+}
+
+/*  Called as a file is read and its tags are written, with the number of
+ *  bytes read or written since the last call. Once the time allowed by
+ *  --parse-timeout has passed, the parse of the file is abandoned by a jump
+ *  to its parser's catcher. The clock is
+ *  consulted only once every PARSE_CHECK_INTERVAL bytes, so that checking
+ *  costs almost nothing.
+ */
+extern void checkParseTimeout (const unsigned long bytes)
+{
+	if (ParseTimer.armed)
+	{
+		if (bytes < ParseTimer.budget)
+			ParseTimer.budget -= bytes;
+		else
+		{
+			ParseTimer.budget = PARSE_CHECK_INTERVAL;
+			if (wallClock () > ParseTimer.deadline)
+			{
+				ParseTimer.armed = FALSE;
+				ParseTimer.expired = TRUE;
+				longjmp (*ParseTimer.catcher, ParseTimer.exception);
+			}
+		}
+	}
+}
+
 static boolean createTagsForFile (
 		const char *const fileName, const langType language,
 		const unsigned int passCount)
 {
 	boolean retried = FALSE;
+	boolean opened;
 	Assert (0 <= language  &&  language < (int) LanguageCount);
-	if (fileOpen (fileName, language))
+	traceBegin ("io", "open", fileName);
+	opened = fileOpen (fileName, language);
+	traceEnd ();
+	if (opened)
 	{
 		const parserDefinition* const lang = LanguageTable [language];
 		if (Option.etags)
@@ -613,61 +741,209 @@ static boolean createTagsForFile (
 
 		makeFileTag (fileName);
 
-		if (lang->parser != NULL)
-			lang->parser ();
-		else if (lang->parser2 != NULL)
-			retried = lang->parser2 (passCount);
+		if (! readTagCache (language))
+		{
+			traceBegin (lang->regex ? "regex" : "parse", lang->name, fileName);
+			if (lang->parser != NULL)
+				lang->parser ();
+			else if (lang->parser2 != NULL)
+				retried = lang->parser2 (passCount);
+			ParseTimer.armed = FALSE;
+			ParseTimer.catcher = NULL;
+			traceEnd ();
+			if (! retried  &&  ! ParseTimer.expired)
+				writeTagCache ();
+		}
 
 		if (Option.etags)
 			endEtagsFile (getSourceFileTagPath ());
 
+		traceBegin ("io", "close", fileName);
 		fileClose ();
+		traceEnd ();
 	}
 
 	return retried;
 }
 
-static boolean createTagsWithFallback (
+/*  Returns the number of passes made over the file, counting as one each
+ *  resumption of a parse from a checkpoint (see rewindTagEntries ()). The
+ *  tags of a file whose parse was abandoned by --parse-timeout are
+ *  discarded, as are those of each pass which is retried.
+ */
+static unsigned int createTagsWithFallback (
 		const char *const fileName, const langType language)
 {
-	const unsigned long numTags	= TagFile.numTags.added;
+	const struct sNumTags numTags = TagFile.numTags;
+	const unsigned int rewinds = TagFile.rewinds;
 	fpos_t tagFilePosition;
 	unsigned int passCount = 0;
-	boolean tagFileResized = FALSE;
 
 	fgetpos (TagFile.fp, &tagFilePosition);
-	while (createTagsForFile (fileName, language, ++passCount))
+	markTagEntries ();
+	startParseTimer ();
+	while (createTagsForFile (fileName, language, ++passCount)  ||
+		   ParseTimer.expired)
 	{
 		/*  Restore prior state of tag file.
 		 */
 		fsetpos (TagFile.fp, &tagFilePosition);
-		TagFile.numTags.added = numTags;
-		tagFileResized = TRUE;
+		TagFile.numTags = numTags;
+		discardTagEntries ();
+		if (ParseTimer.expired)
+		{
+			error (WARNING, "%s: not parsed within %g seconds; tags discarded",
+					fileName, Option.parseTimeout);
+			break;
+		}
 	}
-	return tagFileResized;
+	return passCount + (TagFile.rewinds - rewinds);
+}
+
+/*  Is the file too large to parse under --max-file-size? If so, says so.
+ */
+static boolean isFileTooLarge (const char *const fileName)
+{
+	boolean result = FALSE;
+
+	if (Option.maxFileSize > 0)
+	{
+		const fileStatus *const status = eStat (fileName);
+		if (status->exists  &&  status->size > Option.maxFileSize)
+		{
+			error (WARNING, "%s: larger than %lu bytes; not parsed",
+					fileName, Option.maxFileSize);
+			result = TRUE;
+		}
+	}
+	return result;
+}
+
+/*  Does the text hold a line longer than `limit'? The length of the line
+ *  under way is carried in `lineLength' from one block of text to the next.
+ */
+static boolean hasLongLine (
+		const char *const text, const size_t length, const unsigned long limit,
+		unsigned long *const lineLength)
+{
+	boolean result = FALSE;
+	size_t i;
+
+	for (i = 0  ;  ! result  &&  i < length  ;  ++i)
+	{
+		if (text [i] == '\n'  ||  text [i] == '\r')
+			*lineLength = 0;
+		else
+			result = (boolean) (++*lineLength > limit);
+	}
+	return result;
+}
+
+/*  Does the file hold a line longer than --skip-long-lines within its first
+ *  block (of PROBE_SIZE bytes, or the limit plus one if more)? The first
+ *  block has already been read into `block'; the rest is read into it in
+ *  turn, so that a large limit costs no more memory than a small one.
+ */
+static boolean hasLongLines (FILE *const fp, char *const block, size_t length)
+{
+	const unsigned long limit = Option.skipLineLength;
+	unsigned long lineLength = 0;
+	unsigned long total = length;
+	boolean result = hasLongLine (block, length, limit, &lineLength);
+
+	while (! result  &&  length == PROBE_SIZE  &&  total <= limit)
+	{
+		const unsigned long wanted = limit + 1 - total;
+
+		length = fread (block, (size_t) 1,
+				wanted < PROBE_SIZE ? (size_t) wanted : PROBE_SIZE, fp);
+		total += length;
+		result = hasLongLine (block, length, limit, &lineLength);
+	}
+	return result;
+}
+
+/*  Reads the first block of a file to find whether it is to be skipped under
+ *  --skip-binary, --skip-long-lines or --skip-generated, before any parser
+ *  runs.
+ */
+static boolean isSkippedByProbe (const char *const fileName)
+{
+	const char *reason = NULL;
+
+	if (Option.skipBinary  ||  Option.skipGenerated  ||
+		Option.skipLineLength > 0)
+	{
+		const phase previous = switchPhase (PHASE_DETECT);
+		FILE *const fp = fopen (fileName, "rb");
+
+		traceBegin ("detect", "probe", fileName);
+		if (fp != NULL)
+		{
+			char *const block = xMalloc (PROBE_SIZE + 1, char);
+			const size_t length = fread (block, (size_t) 1, PROBE_SIZE, fp);
+
+			block [length] = '\0';
+			if (Option.skipBinary  &&  memchr (block, '\0', length) != NULL)
+				reason = "binary";
+			else if (Option.skipGenerated  &&  isGeneratedText (block))
+				reason = "generated";
+			else if (Option.skipLineLength > 0  &&
+					 hasLongLines (fp, block, length))
+				reason = "long lines";
+			fclose (fp);
+			eFree (block);
+		}
+		traceEnd ();
+		switchPhase (previous);
+		if (reason != NULL)
+			verbose ("ignoring %s (%s)\n", fileName, reason);
+	}
+	return (boolean) (reason != NULL);
 }
 
 extern boolean parseFile (const char *const fileName)
 {
 	boolean tagFileResized = FALSE;
 	langType language = Option.language;
+	phase previous;
 	if (Option.language == LANG_AUTO)
+	{
+		previous = switchPhase (PHASE_DETECT);
+		traceBegin ("detect", "detect language", fileName);
 		language = getFileLanguage (fileName);
+		traceEnd ();
+		switchPhase (previous);
+	}
 	Assert (language != LANG_AUTO);
 	if (language == LANG_IGNORE)
 		verbose ("ignoring %s (unknown language)\n", fileName);
 	else if (! LanguageTable [language]->enabled)
 		verbose ("ignoring %s (language disabled)\n", fileName);
-	else
+	else if (! isFileTooLarge (fileName)  &&  ! isSkippedByProbe (fileName))
 	{
+		const unsigned long tags = TagFile.numTags.added;
+		unsigned int passCount;
+
 		if (Option.filter)
 			openTagFile ();
 
-		tagFileResized = createTagsWithFallback (fileName, language);
+		previous = switchPhase (PHASE_PARSE);
+		traceBegin ("file", "file", fileName);
+		passCount = createTagsWithFallback (fileName, language);
+		tagFileResized = (boolean) (passCount > 1  ||  ParseTimer.expired);
+		traceEnd ();
+		switchPhase (previous);
 
 		if (Option.filter)
 			closeTagFile (tagFileResized);
 		addTotals (1, 0L, 0L);
+		if (Option.printTotals > TOTALS_BRIEF)
+			addFileTotals (fileName, language,
+					(unsigned long) eStat (fileName)->size,
+					TagFile.numTags.added - tags, passCount);
+		if (isTracing ())
+			traceProgress ((unsigned long) eStat (fileName)->size);
 
 		return tagFileResized;
 	}
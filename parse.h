@@ -15,6 +15,9 @@
 *   INCLUDE FILES
 */
 #include "general.h"  /* must always come first */
+
+#include <setjmp.h>
+
 #include "parsers.h"  /* contains list of parsers */
 #include "strlist.h"
 
@@ -26,6 +29,8 @@
 #define LANG_AUTO   (-1)
 #define LANG_IGNORE (-2)
 
+#define ANONYMOUS_PREFIX  "__anon"  /* followed by nextAnonymousNumber () */
+
 /*
 *   DATA DECLARATIONS
 */
@@ -86,6 +91,9 @@ extern boolean includingDefineTags (void);
 
 /* Language processing and parsing */
 extern void makeSimpleTag (const vString* const name, kindOption* const kinds, const int kind);
+extern unsigned int nextAnonymousNumber (void);
+extern unsigned int getAnonymousCount (void);
+extern void setAnonymousCount (const unsigned int count);
 extern parserDefinition* parserNew (const char* name);
 extern const char *getLanguageName (const langType language);
 extern langType getNamedLanguage (const char *const name);
@@ -106,8 +114,11 @@ extern void processLanguageDefineOption (const char *const option, const char *c
 extern boolean processKindOption (const char *const option, const char *const parameter);
 extern void printKindOptions (void);
 extern void printLanguageKinds (const langType language);
+extern void describeLanguage (const langType language, vString *const description);
 extern void printLanguageList (void);
 extern boolean parseFile (const char *const fileName);
+extern void catchParseTimeout (jmp_buf *const context, const int exception);
+extern void checkParseTimeout (const unsigned long bytes);
 
 /* Regex interface */
 #ifdef HAVE_REGEX
@@ -121,6 +132,7 @@ extern void addCallbackRegex (const langType language, const char *const regex,
 extern void disableRegexKinds (const langType language);
 extern boolean enableRegexKind (const langType language, const int kind, const boolean mode);
 extern void printRegexKinds (const langType language, boolean indent);
+extern void describeRegexPatterns (const langType language, vString *const description);
 extern void freeRegexResources (void);
 extern void checkRegex (void);
 
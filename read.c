@@ -26,11 +26,45 @@
 #include "routines.h"
 #include "options.h"
 
+/*
+*   MACROS
+*/
+#define OFFSET_HISTORY  64  /* number of line offsets remembered */
+
 /*
 *   DATA DEFINITIONS
 */
 inputFile File;  /* globally read through macros */
 static fpos_t StartOfLine;  /* holds deferred position of start of line */
+static unsigned long Offset;  /* byte offset of next byte to be read */
+static unsigned long StartOfLineOffset;  /* byte offset of StartOfLine */
+
+/*  The positions and byte offsets of the most recent lines, from which
+ *  getInputFileOffset () finds offsets without seeking.
+ */
+static struct sLineOffset {
+	fpos_t position;
+	unsigned long offset;
+} LineOffsets [OFFSET_HISTORY];
+static unsigned int LineOffsetCount;  /* number of lines recorded */
+
+/*  The point in the file to which fileResume () returns reading.
+ */
+static struct sInputCheckpoint {
+	fpos_t position;          /* position of stream */
+	fpos_t startOfLine;       /* value of StartOfLine */
+	fpos_t filePosition;      /* position of current line */
+	unsigned long offset;     /* value of Offset */
+	unsigned long startOfLineOffset;  /* value of StartOfLineOffset */
+	unsigned long lineNumber;
+	unsigned long sourceLineNumber;
+	int ungetch;
+	boolean eof;
+	boolean newLine;
+	boolean inLine;           /* was the current line partly read? */
+	vString *rest;            /* unread rest of current line */
+	vString *sourceName;      /* name of source file */
+} Checkpoint;
 
 /*
 *   FUNCTION DEFINITIONS
@@ -48,6 +82,10 @@ extern void freeSourceFileResources (void)
 		eFree (File.source.tagPath);
 	if (File.line != NULL)
 		vStringDelete (File.line);
+	if (Checkpoint.rest != NULL)
+		vStringDelete (Checkpoint.rest);
+	if (Checkpoint.sourceName != NULL)
+		vStringDelete (Checkpoint.sourceName);
 }
 
 /*
@@ -117,11 +155,38 @@ static boolean setSourceFileName (vString *const fileName)
  *   Line directive parsing
  */
 
+/*  Reads a byte of the file, counting it in Offset.
+ */
+static int readByte (void)
+{
+	const int c = getc (File.fp);
+	if (c != EOF)
+		++Offset;
+	return c;
+}
+
+static void unreadByte (const int c)
+{
+	if (c != EOF)
+	{
+		ungetc (c, File.fp);
+		--Offset;
+	}
+}
+
+/*  Records the position of the start of the next line.
+ */
+static void markStartOfLine (void)
+{
+	fgetpos (File.fp, &StartOfLine);
+	StartOfLineOffset = Offset;
+}
+
 static int skipWhite (void)
 {
 	int c;
 	do
-		c = getc (File.fp);
+		c = readByte ();
 	while (c == ' '  ||  c == '\t');
 	return c;
 }
@@ -133,9 +198,9 @@ static unsigned long readLineNumber (void)
 	while (c != EOF  &&  isdigit (c))
 	{
 		lNum = (lNum * 10) + (c - '0');
-		c = getc (File.fp);
+		c = readByte ();
 	}
-	ungetc (c, File.fp);
+	unreadByte (c);
 	if (c != ' '  &&  c != '\t')
 		lNum = 0;
 
@@ -158,17 +223,17 @@ static vString *readFileName (void)
 
 	if (c == '"')
 	{
-		c = getc (File.fp);  /* skip double-quote */
+		c = readByte ();  /* skip double-quote */
 		quoteDelimited = TRUE;
 	}
 	while (c != EOF  &&  c != '\n'  &&
 			(quoteDelimited ? (c != '"') : (c != ' '  &&  c != '\t')))
 	{
 		vStringPut (fileName, c);
-		c = getc (File.fp);
+		c = readByte ();
 	}
 	if (c == '\n')
-		ungetc (c, File.fp);
+		unreadByte (c);
 	vStringPut (fileName, '\0');
 
 	return fileName;
@@ -182,13 +247,13 @@ static boolean parseLineDirective (void)
 
 	if (isdigit (c))
 	{
-		ungetc (c, File.fp);
+		unreadByte (c);
 		result = TRUE;
 	}
-	else if (c == 'l'  &&  getc (File.fp) == 'i'  &&
-			 getc (File.fp) == 'n'  &&  getc (File.fp) == 'e')
+	else if (c == 'l'  &&  readByte () == 'i'  &&
+			 readByte () == 'n'  &&  readByte () == 'e')
 	{
-		c = getc (File.fp);
+		c = readByte ();
 		if (c == ' '  ||  c == '\t')
 		{
 			DebugStatement ( lineStr = "line"; )
@@ -268,7 +333,9 @@ extern boolean fileOpen (const char *const fileName, const langType language)
 		opened = TRUE;
 
 		setInputFileName (fileName);
-		fgetpos (File.fp, &StartOfLine);
+		Offset = 0;
+		LineOffsetCount = 0;
+		markStartOfLine ();
 		fgetpos (File.fp, &File.filePosition);
 		File.currentLine  = NULL;
 		File.lineNumber   = 0L;
@@ -293,12 +360,14 @@ extern void fileClose (void)
 	if (File.fp != NULL)
 	{
 		/*  The line count of the file is 1 too big, since it is one-based
-		 *  and is incremented upon each newline.
+		 *  and is incremented upon each newline. It is 0 if the file was
+		 *  not read, because its tags came from the tag cache.
 		 */
 		if (Option.printTotals)
 		{
 			fileStatus *status = eStat (vStringValue (File.name));
-			addTotals (0, File.lineNumber - 1L, status->size);
+			addTotals (0, File.lineNumber > 0 ? File.lineNumber - 1L : 0L,
+					status->size);
 		}
 		fclose (File.fp);
 		File.fp = NULL;
@@ -314,7 +383,12 @@ extern boolean fileEOF (void)
  */
 static void fileNewline (void)
 {
+	struct sLineOffset *const line =
+			&LineOffsets [LineOffsetCount++ % OFFSET_HISTORY];
+
 	File.filePosition = StartOfLine;
+	line->position = StartOfLine;
+	line->offset = StartOfLineOffset;
 	File.newLine = FALSE;
 	File.lineNumber++;
 	File.source.lineNumber++;
@@ -329,7 +403,7 @@ static int iFileGetc (void)
 {
 	int	c;
 readnext:
-	c = getc (File.fp);
+	c = readByte ();
 
 	/*	If previous character was a newline, then we're starting a line.
 	 */
@@ -343,7 +417,8 @@ readnext:
 			else
 			{
 				fsetpos (File.fp, &StartOfLine);
-				c = getc (File.fp);
+				Offset = StartOfLineOffset;
+				c = readByte ();
 			}
 		}
 	}
@@ -353,7 +428,7 @@ readnext:
 	else if (c == NEWLINE)
 	{
 		File.newLine = TRUE;
-		fgetpos (File.fp, &StartOfLine);
+		markStartOfLine ();
 	}
 	else if (c == CRETURN)
 	{
@@ -362,15 +437,15 @@ readnext:
 		 * and CR-LF (MS-DOS) are converted into a generic newline.
 		 */
 #ifndef macintosh
-		const int next = getc (File.fp);  /* is CR followed by LF? */
+		const int next = readByte ();  /* is CR followed by LF? */
 		if (next != NEWLINE)
-			ungetc (next, File.fp);
+			unreadByte (next);
 		else
 #endif
 		{
 			c = NEWLINE;  /* convert CR into newline */
 			File.newLine = TRUE;
-			fgetpos (File.fp, &StartOfLine);
+			markStartOfLine ();
 		}
 	}
 	DebugStatement ( debugPutc (DEBUG_RAW, c); )
@@ -397,6 +472,7 @@ static vString *iFileGetLine (void)
 		if (c == '\n'  ||  (c == EOF  &&  vStringLength (File.line) > 0))
 		{
 			vStringTerminate (File.line);
+			checkParseTimeout ((unsigned long) vStringLength (File.line));
 #ifdef HAVE_REGEX
 			if (vStringLength (File.line) > 0)
 				matchRegex (File.line, File.source.language);
@@ -458,6 +534,61 @@ extern int fileSkipToCharacter (int c)
 	return d;
 }
 
+/*  Records the point reached by fileGetc (), to which fileResume () may
+ *  later return. Only the last point recorded is kept.
+ */
+extern void fileCheckpoint (void)
+{
+	fgetpos (File.fp, &Checkpoint.position);
+	Checkpoint.startOfLine      = StartOfLine;
+	Checkpoint.filePosition     = File.filePosition;
+	Checkpoint.offset           = Offset;
+	Checkpoint.startOfLineOffset = StartOfLineOffset;
+	Checkpoint.lineNumber       = File.lineNumber;
+	Checkpoint.sourceLineNumber = File.source.lineNumber;
+	Checkpoint.ungetch          = File.ungetch;
+	Checkpoint.eof              = File.eof;
+	Checkpoint.newLine          = File.newLine;
+	Checkpoint.inLine           = (boolean) (File.currentLine != NULL);
+
+	if (Checkpoint.rest == NULL)
+		Checkpoint.rest = vStringNew ();
+	if (Checkpoint.inLine)
+		vStringCopyS (Checkpoint.rest, (const char *) File.currentLine);
+	if (Checkpoint.sourceName == NULL)
+		Checkpoint.sourceName = vStringNew ();
+	vStringCopy (Checkpoint.sourceName, File.source.name);
+}
+
+/*  Returns reading by fileGetc () to the point recorded by fileCheckpoint ().
+ *  The rest of the line then being read is read from the copy made of it,
+ *  so that any regular expressions are not matched against it again.
+ */
+extern void fileResume (void)
+{
+	fsetpos (File.fp, &Checkpoint.position);
+	StartOfLine           = Checkpoint.startOfLine;
+	File.filePosition     = Checkpoint.filePosition;
+	Offset                = Checkpoint.offset;
+	StartOfLineOffset     = Checkpoint.startOfLineOffset;
+	File.lineNumber       = Checkpoint.lineNumber;
+	File.source.lineNumber = Checkpoint.sourceLineNumber;
+	File.ungetch          = Checkpoint.ungetch;
+	File.eof              = Checkpoint.eof;
+	File.newLine          = Checkpoint.newLine;
+	File.currentLine      = NULL;
+	if (Checkpoint.inLine)
+	{
+		vStringCopy (File.line, Checkpoint.rest);
+		File.currentLine = (unsigned char*) vStringValue (File.line);
+	}
+	if (strcmp (vStringValue (File.source.name),
+				vStringValue (Checkpoint.sourceName)) != 0)
+	{
+		setSourceFileParameters (vStringNewCopy (Checkpoint.sourceName));
+	}
+}
+
 /*  An alternative interface to fileGetc (). Do not mix use of fileReadLine()
  *  and fileGetc() for the same file. The returned string does not contain
  *  the terminating newline. A NULL return value means that all lines in the
@@ -539,6 +670,40 @@ extern char *readLine (vString *const vLine, FILE *const fp)
 	return result;
 }
 
+/*  Returns the byte offset of a position within the file being read. The
+ *  positions of the most recent lines are known, so that the file is only
+ *  repositioned to find the offsets of older ones.
+ */
+extern unsigned long getInputFileOffset (const fpos_t *const position)
+{
+	const unsigned int count = LineOffsetCount < OFFSET_HISTORY ?
+			LineOffsetCount : OFFSET_HISTORY;
+	unsigned long result = 0;
+	boolean found = FALSE;
+	unsigned int i;
+
+	for (i = 1  ;  ! found  &&  i <= count  ;  ++i)
+	{
+		const struct sLineOffset *const line =
+				&LineOffsets [(LineOffsetCount - i) % OFFSET_HISTORY];
+		if (memcmp (&line->position, position, sizeof (fpos_t)) == 0)
+		{
+			result = line->offset;
+			found = TRUE;
+		}
+	}
+	if (! found)
+	{
+		fpos_t original;
+
+		fgetpos (File.fp, &original);
+		fsetpos (File.fp, position);
+		result = (unsigned long) ftell (File.fp);
+		fsetpos (File.fp, &original);
+	}
+	return result;
+}
+
 /*  Places into the line buffer the contents of the line referenced by
  *  "location".
  */
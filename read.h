@@ -105,9 +105,12 @@ extern boolean fileEOF (void);
 extern void fileClose (void);
 extern int fileGetc (void);
 extern int fileSkipToCharacter (int c);
+extern void fileCheckpoint (void);
+extern void fileResume (void);
 extern void fileUngetc (int c);
 extern const unsigned char *fileReadLine (void);
 extern char *readLine (vString *const vLine, FILE *const fp);
+extern unsigned long getInputFileOffset (const fpos_t *const position);
 extern char *readSourceLine (vString *const vLine, fpos_t location, long *const pSeekValue);
 
 #endif  /* _READ_H */
@@ -11,12 +11,42 @@
 /*
 *   INCLUDE FILES
 */
+#if defined (HAVE_CONFIG_H)
+# include <config.h>
+#endif
+
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <stdio.h>
 #include <errno.h>
+#include <stdarg.h>
 #include <sys/types.h>  /* to declare off_t */
+#include <sys/stat.h>   /* to declare fstat () */
+
+#if defined (HAVE_MMAP) && defined (HAVE_SYS_MMAN_H)
+# define USE_MMAP
+# include <sys/mman.h>  /* to declare mmap () */
+#endif
+
+#ifdef HAVE_GLOB_H
+# include <glob.h>      /* to declare glob () */
+#endif
+
+#ifdef HAVE_PTHREAD_H
+# define USE_THREADS
+# include <pthread.h>
+#endif
+
+#if defined (READTAGS_MAIN) && defined (HAVE_SYS_SELECT_H) && \
+	defined (HAVE_SYS_SOCKET_H) && defined (HAVE_SYS_UN_H)
+# define USE_SOCKETS
+# include <signal.h>
+# include <unistd.h>
+# include <sys/select.h>
+# include <sys/socket.h>
+# include <sys/un.h>
+#endif
 
 #include "readtags.h"
 
@@ -25,6 +55,42 @@
 */
 #define TAB '\t'
 
+#if defined (HAVE_STAT_ST_MTIM)
+# define mtimeNanoseconds(status)  ((unsigned long) (status)->st_mtim.tv_nsec)
+#elif defined (HAVE_STAT_ST_MTIMESPEC)
+# define mtimeNanoseconds(status)  ((unsigned long) (status)->st_mtimespec.tv_nsec)
+#else
+# define mtimeNanoseconds(status)  0UL
+#endif
+
+/*  Format of the sidecar index written by "ctags --tag-index" (see tagindex.h
+ *  in the ctags sources, which must agree with these values).
+ */
+#define INDEX_MAGIC         "CTAGSIDX"
+#define INDEX_VERSION       2
+#define INDEX_HEADER_SIZE   48
+#define INDEX_SECTION_SIZE  16
+#define INDEX_CHECK_SIZE    4096
+#define INDEX_NAME          1
+#define INDEX_FOLDED        2
+#define INDEX_COMPLETION    3
+#define INDEX_STRINGS       4
+#define INDEX_FILE          5
+#define INDEX_SCOPE         6
+#define INDEX_MASK_SIZE     8
+#define INDEX_COMPLETION_SIZE  (INDEX_MASK_SIZE + 4)
+
+/*  Format of the binary tag file written by "ctags --output-format=binary"
+ *  (see tagbinary.h in the ctags sources, which must agree with these values).
+ */
+#define BINARY_MAGIC        "CTAGSBIN"
+#define BINARY_VERSION      1
+#define BINARY_HEADER_SIZE  72
+
+/*  Most threads started by tagsSetFind () to begin searching the tag files
+ *  of a tag set.
+ */
+#define SET_THREADS         8
 
 /*
 *   DATA DECLARATIONS
@@ -34,24 +100,49 @@ typedef struct {
 	char *buffer;
 } vstring;
 
-/* Information about current tag file */
-struct sTagFile {
-		/* has the file been opened and this structure initialized? */
-	short initialized;
-		/* format of tag file */
-	short format;
-		/* how is the tag file sorted? */
-	sortType sortMethod;
-		/* pointer to file structure */
+/* Section of the sidecar index */
+typedef struct {
+		/* start of section within index */
+	const unsigned char *data;
+		/* number of entries in section */
+	unsigned long count;
+} indexSection;
+
+/* String table of a binary tag file */
+typedef struct {
+		/* offset of each string within `strings' (4 bytes each) */
+	const unsigned char *offsets;
+		/* null terminated strings */
+	const char *strings;
+		/* number of strings */
+	unsigned long count;
+		/* size of `strings' */
+	unsigned long size;
+} binaryTable;
+
+/* Position and search state for reading a tag file; each tag file has one
+ * of its own, and tagsCursorNew () creates others sharing the tag file */
+struct sTagCursor {
+		/* tag file read by this cursor */
+	tagFile *file;
+		/* pointer to file structure (NULL if the tag file is mapped) */
 	FILE* fp;
+		/* file position following `line' when reading from `map' */
+	off_t next;
+		/* has the line most recently found in `map' been copied to `line'? */
+	short lineLoaded;
 		/* file position of first character of `line' */
 	off_t pos;
-		/* size of tag file in seekable positions */
-	off_t size;
 		/* last line read */
 	vstring line;
-		/* name of tag in last line read */
+		/* name of tag in last line read (for unmapped files only) */
 	vstring name;
+		/* name of tag in last line read, within `name' or `map'; this is
+		 * not null terminated when it points into `map' */
+	struct {
+			const char *buffer;
+			size_t length;
+	} tag;
 		/* defines tag search state */
 	struct {
 				/* file position of last match for tag */
@@ -64,7 +155,25 @@ struct sTagFile {
 			short partial;
 				/* ignoring case */
 			short ignorecase;
+				/* index section searched (NULL if not searching by index) */
+			const indexSection *section;
+				/* position of last match within `section' */
+			unsigned long indexPos;
 	} search;
+		/* names returned by tagsComplete () without use of the index */
+	struct {
+			char **list;
+			int count;
+	} completion;
+		/* state of reading the records of a binary tag file */
+	struct {
+				/* name of the last record read, on which the next is coded */
+			vstring previous;
+				/* length of `previous' */
+			size_t length;
+				/* records remaining in the block being read */
+			unsigned long remaining;
+	} binary;
 		/* miscellaneous extension fields */
 	struct {
 				/* number of entries in `list' */
@@ -72,6 +181,74 @@ struct sTagFile {
 				/* list of key value pairs */
 			tagExtensionField *list;
 	} fields;
+};
+
+/* Information about current tag file. Once a cursor has been created for it,
+ * it is no longer changed, so may be read by several threads at once */
+struct sTagFile {
+		/* has the file been opened and this structure initialized? */
+	short initialized;
+		/* have cursors been created for this file? */
+	short shared;
+		/* format of tag file */
+	short format;
+		/* how is the tag file sorted? */
+	sortType sortMethod;
+		/* path of tag file, for cursors opening their own file */
+	char *path;
+		/* pointer to file structure */
+	FILE* fp;
+		/* read-only mapping of the whole tag file (NULL if not mapped) */
+	const char *map;
+		/* was `map' read into allocated memory rather than mapped? */
+	short allocated;
+		/* size of tag file in seekable positions */
+	off_t size;
+		/* cursor used by tagsFind () and the other functions taking a file */
+	tagCursor cursor;
+		/* sidecar index of tag lines in name order, if present and current */
+	struct {
+				/* contents of index file (NULL if none) */
+			const unsigned char *data;
+				/* size of index file */
+			size_t size;
+				/* was `data' mapped rather than allocated? */
+			short mapped;
+				/* have the contents of the tag file been checked? */
+			short checked;
+				/* size in bytes of each line offset */
+			unsigned int width;
+				/* line offsets in name and in case-folded name order */
+			indexSection name;
+			indexSection folded;
+				/* distinct names and their character masks */
+			indexSection completion;
+				/* strings referenced by other sections */
+			indexSection strings;
+				/* line offsets in source file order */
+			indexSection file;
+				/* offsets of lines having a scope, in scope order */
+			indexSection scope;
+	} index;
+		/* layout of a binary tag file (all zero for a text tag file) */
+	struct {
+				/* is the tag file in binary format? */
+			short present;
+				/* position of the first pseudo-tag line */
+			off_t start;
+				/* position of the first block, ending the pseudo-tag lines */
+			off_t blocks;
+				/* position of the end of the last block */
+			off_t end;
+				/* position of each block (8 bytes each) */
+			const unsigned char *index;
+				/* number of blocks */
+			unsigned long count;
+				/* strings referenced by records */
+			binaryTable files;
+			binaryTable keys;
+			binaryTable values;
+	} binary;
 		/* buffers to be freed at close */
 	struct {
 			/* name of program author */
@@ -85,43 +262,57 @@ struct sTagFile {
 	} program;
 };
 
+/* A tag file of a tag set, opened when first searched */
+typedef struct {
+		/* path of tag file */
+	char *path;
+		/* tag file (NULL until opened, or if it could not be opened) */
+	tagFile *file;
+		/* identity of the tag file when opened, to detect its replacement */
+	dev_t device;
+	ino_t inode;
+	off_t size;
+	time_t mtime;
+	unsigned long mtimeNanoseconds;
+		/* result of the search of the tag file begun by tagsSetFind () */
+	tagResult found;
+		/* tag most recently found by the search */
+	tagEntry entry;
+} tagSetMember;
+
+/* A set of tag files searched together by tagsSetFind () */
+struct sTagSet {
+		/* tag files, in the order added */
+	tagSetMember *members;
+		/* number of entries in `members' */
+	int count;
+		/* number of entries allocated for `members' */
+	int max;
+		/* name and options of the search in progress */
+	const char *name;
+	int options;
+};
+
 /*
 *   DATA DEFINITIONS
 */
 const char *const EmptyString = "";
 const char *const PseudoTagPrefix = "!_";
+const char *const IndexSuffix = ".idx";
+
+/*  Keys of the extension fields written by ctags other than the scope of a
+ *  tag, whose key is the kind of the enclosing tag (see NonScopeKeys in
+ *  tagindex.c in the ctags sources, which must agree with this list). Of
+ *  these, "kind", "file" and "line" do not appear in the fields of an entry.
+ */
+static const char *const NonScopeKeys [] = {
+	"language", "typeref", "inherits", "access", "implementation", "signature"
+};
 
 /*
 *   FUNCTION DEFINITIONS
 */
 
-/*
- * Compare two strings, ignoring case.
- * Return 0 for match, < 0 for smaller, > 0 for bigger
- * Make sure case is folded to uppercase in comparison (like for 'sort -f')
- * This makes a difference when one of the chars lies between upper and lower
- * ie. one of the chars [ \ ] ^ _ ` for ascii. (The '_' in particular !)
- */
-static int struppercmp (const char *s1, const char *s2)
-{
-	int result;
-	do
-	{
-		result = toupper ((int) *s1) - toupper ((int) *s2);
-	} while (result == 0  &&  *s1++ != '\0'  &&  *s2++ != '\0');
-	return result;
-}
-
-static int strnuppercmp (const char *s1, const char *s2, size_t n)
-{
-	int result;
-	do
-	{
-		result = toupper ((int) *s1) - toupper ((int) *s2);
-	} while (result == 0  &&  --n > 0  &&  *s1++ != '\0'  &&  *s2++ != '\0');
-	return result;
-}
-
 static int growString (vstring *s)
 {
 	int result = 0;
@@ -149,32 +340,357 @@ static int growString (vstring *s)
 	return result;
 }
 
+/*  Returns the little-endian value of `width' bytes at `p', or -1 if it is
+ *  too large for an off_t.
+ */
+static off_t indexValue (const unsigned char *const p, const unsigned int width)
+{
+	off_t result = 0;
+	unsigned int i = width;
+	while (i > 0)
+	{
+		--i;
+		if (i + 1 >= sizeof (off_t)  &&
+			p [i] > (i + 1 == sizeof (off_t) ? 0x7f : 0))
+		{
+			return -1;
+		}
+		result = (result << 8) | p [i];
+	}
+	return result;
+}
+
 /* Copy name of tag out of tag line */
-static void copyName (tagFile *const file)
+static void copyName (tagCursor *const cursor)
 {
 	size_t length;
-	const char *end = strchr (file->line.buffer, '\t');
+	const char *end = strchr (cursor->line.buffer, '\t');
 	if (end == NULL)
 	{
-		end = strchr (file->line.buffer, '\n');
+		end = strchr (cursor->line.buffer, '\n');
 		if (end == NULL)
-			end = strchr (file->line.buffer, '\r');
+			end = strchr (cursor->line.buffer, '\r');
 	}
 	if (end != NULL)
-		length = end - file->line.buffer;
+		length = end - cursor->line.buffer;
+	else
+		length = strlen (cursor->line.buffer);
+	while (length >= cursor->name.size)
+		growString (&cursor->name);
+	strncpy (cursor->name.buffer, cursor->line.buffer, length);
+	cursor->name.buffer [length] = '\0';
+	cursor->tag.buffer = cursor->name.buffer;
+	cursor->tag.length = length;
+}
+
+/*  Locates the next line in the mapped tag file without copying it. Only the
+ *  bounds of the tag name are recorded; the line itself is copied into
+ *  `line' by loadLine () if an entry is actually requested for it. The lines
+ *  of a binary tag file are its pseudo-tag lines.
+ */
+static int readMappedLine (tagCursor *const cursor)
+{
+	const off_t limit = cursor->file->binary.present ?
+			cursor->file->binary.blocks : cursor->file->size;
+	int result = 0;
+	if (cursor->next < limit)
+	{
+		const char *const line = cursor->file->map + cursor->next;
+		const size_t available = (size_t) (limit - cursor->next);
+		const char *const newline = (const char*) memchr (line, '\n', available);
+		const char *tab;
+		size_t length;
+
+		cursor->pos = cursor->next;
+		if (newline == NULL)
+			length = available;
+		else
+			length = newline - line;
+		cursor->next += length + (newline == NULL ? 0 : 1);
+		while (length > 0  &&  (line [length - 1] == '\n' || line [length - 1] == '\r'))
+			--length;
+		tab = (const char*) memchr (line, TAB, length);
+		cursor->tag.buffer = line;
+		cursor->tag.length = (tab == NULL) ? length : (size_t) (tab - line);
+		cursor->lineLoaded = 0;
+		result = 1;
+	}
+	return result;
+}
+
+/*  Ensures that `line' holds the text of the line most recently read.
+ */
+static void loadLine (tagCursor *const cursor)
+{
+	if (cursor->file->map != NULL  &&  ! cursor->lineLoaded)
+	{
+		const char *const line = cursor->file->map + cursor->pos;
+		size_t length = (size_t) (cursor->next - cursor->pos);
+		while (length > 0  &&  (line [length - 1] == '\n' || line [length - 1] == '\r'))
+			--length;
+		while (length >= cursor->line.size)
+			growString (&cursor->line);
+		memcpy (cursor->line.buffer, line, length);
+		cursor->line.buffer [length] = '\0';
+		cursor->lineLoaded = 1;
+	}
+}
+
+/*  Reads a varint from `*p', which must lie before `end'.
+ */
+static int readVarint (const unsigned char **const p,
+					   const unsigned char *const end, unsigned long *const value)
+{
+	unsigned int shift = 0;
+	int result = 0;
+	*value = 0;
+	while (*p < end  &&  shift < 8 * sizeof (unsigned long))
+	{
+		const unsigned char byte = *(*p)++;
+		*value |= (unsigned long) (byte & 0x7f) << shift;
+		shift += 7;
+		if ((byte & 0x80) == 0)
+		{
+			result = 1;
+			break;
+		}
+	}
+	return result;
+}
+
+/*  Reads a null terminated string from `*p', which must end before `end'.
+ */
+static const char *readBinaryString (const unsigned char **const p,
+									 const unsigned char *const end,
+									 size_t *const length)
+{
+	const char *result = NULL;
+	const unsigned char *const nul = (const unsigned char *)
+			memchr (*p, '\0', (size_t) (end - *p));
+	if (nul != NULL)
+	{
+		result = (const char *) *p;
+		*length = (size_t) (nul - *p);
+		*p = nul + 1;
+	}
+	return result;
+}
+
+/*  Returns string `i' of a table of a binary tag file, or NULL if the table
+ *  has no such string.
+ */
+static const char *tableString (const binaryTable *const table,
+								const unsigned long i, size_t *const length)
+{
+	const char *result = NULL;
+	if (i < table->count)
+	{
+		const unsigned long offset =
+				(unsigned long) indexValue (table->offsets + 4 * i, 4);
+		if (offset < table->size)
+		{
+			result = table->strings + offset;
+			*length = strlen (result);
+		}
+	}
+	return result;
+}
+
+static int appendString (vstring *const s, size_t *const length,
+						 const char *const string, const size_t stringLength)
+{
+	int result = 1;
+	while (result  &&  *length + stringLength >= s->size)
+		result = growString (s);
+	if (result)
+	{
+		memcpy (s->buffer + *length, string, stringLength);
+		*length += stringLength;
+		s->buffer [*length] = '\0';
+	}
+	return result;
+}
+
+/*  Appends a value of a binary tag record to `line': a string, a number or
+ *  an entry of `table', according to `code'.
+ */
+static int appendValue (tagCursor *const cursor, size_t *const length,
+						const unsigned long code, const binaryTable *const table,
+						const unsigned char **const p,
+						const unsigned char *const end)
+{
+	const char *string = NULL;
+	size_t stringLength = 0;
+	char number [24];
+	unsigned long value;
+	if (code == 0)
+		string = readBinaryString (p, end, &stringLength);
+	else if (code == 1  &&  readVarint (p, end, &value))
+	{
+		sprintf (number, "%lu", value);
+		string = number;
+		stringLength = strlen (number);
+	}
+	else if (code > 1)
+		string = tableString (table, code - 2, &stringLength);
+	return (string != NULL  &&
+			appendString (&cursor->line, length, string, stringLength));
+}
+
+/*  Decodes the record at `next' into the tag line it was written from. The
+ *  line is complete in `line' at once, so is never loaded by loadLine ().
+ */
+static int readBinaryRecord (tagCursor *const cursor)
+{
+	const tagFile *const file = cursor->file;
+	const unsigned char *const map = (const unsigned char *) file->map;
+	const unsigned char *const end = map + file->binary.end;
+	const unsigned char *p = map + cursor->next;
+	unsigned long prefix, suffix, fileRef, address, fields, i;
+	size_t stringLength;
+	size_t length = 0;
+	int ok = 0;
+
+	cursor->pos = cursor->next;
+	if (p < end  &&  cursor->binary.remaining == 0)
+	{
+		if (readVarint (&p, end, &cursor->binary.remaining))
+			cursor->binary.length = 0;
+	}
+	if (p < end  &&  cursor->binary.remaining > 0  &&
+		readVarint (&p, end, &prefix)  &&
+		prefix <= cursor->binary.length  &&
+		readVarint (&p, end, &suffix)  &&
+		suffix <= (unsigned long) (end - p))
+	{
+		cursor->binary.length = (size_t) prefix;
+		ok = appendString (&cursor->binary.previous, &cursor->binary.length,
+						   (const char *) p, (size_t) suffix);
+		p += suffix;
+		if (ok)
+			ok = appendString (&cursor->line, &length,
+							   cursor->binary.previous.buffer,
+							   cursor->binary.length);
+		if (ok)
+			ok = readVarint (&p, end, &fileRef);
+		if (ok  &&  fileRef > 0)
+		{
+			const char *const fileName =
+					tableString (&file->binary.files, fileRef - 1, &stringLength);
+			ok = (fileName != NULL  &&
+				  appendString (&cursor->line, &length, "\t", 1)  &&
+				  appendString (&cursor->line, &length, fileName, stringLength)  &&
+				  appendString (&cursor->line, &length, "\t", 1)  &&
+				  readVarint (&p, end, &address));
+			if (ok  &&  address > 0)
+			{
+				char number [24];
+				sprintf (number, "%lu", address - 1);
+				ok = appendString (&cursor->line, &length, number, strlen (number));
+			}
+			else if (ok)
+			{
+				const char *const string = readBinaryString (&p, end, &stringLength);
+				ok = (string != NULL  &&
+					  appendString (&cursor->line, &length, string, stringLength));
+			}
+			if (ok)
+				ok = readVarint (&p, end, &fields);
+			if (ok  &&  (fields & 1) != 0)
+				ok = appendString (&cursor->line, &length, ";\"", 2);
+			for (i = 0  ;  ok  &&  i < fields / 2  ;  ++i)
+			{
+				unsigned long key, value;
+				ok = (appendString (&cursor->line, &length, "\t", 1)  &&
+					  readVarint (&p, end, &key));
+				if (ok  &&  key > 0)
+				{
+					const char *const keyName =
+							tableString (&file->binary.keys, key - 1, &stringLength);
+					ok = (keyName != NULL  &&
+						  appendString (&cursor->line, &length, keyName, stringLength)  &&
+						  appendString (&cursor->line, &length, ":", 1));
+				}
+				if (ok)
+					ok = (readVarint (&p, end, &value)  &&
+						  appendValue (cursor, &length, value,
+									   &file->binary.values, &p, end));
+			}
+		}
+	}
+	if (ok)
+	{
+		const char *const tab = (const char *) memchr (
+				cursor->line.buffer, TAB, length);
+		cursor->next = (off_t) (p - map);
+		--cursor->binary.remaining;
+		cursor->tag.buffer = cursor->line.buffer;
+		cursor->tag.length = (tab == NULL) ?
+				length : (size_t) (tab - cursor->line.buffer);
+		cursor->lineLoaded = 1;
+	}
+	else
+	{
+		/* end of the records, or a damaged record */
+		cursor->next = file->binary.end;
+		cursor->binary.remaining = 0;
+	}
+	return ok;
+}
+
+/*  Returns the position of block `i' of a binary tag file.
+ */
+static off_t blockPosition (const tagFile *const file, const unsigned long i)
+{
+	return indexValue (file->binary.index + 8 * i, 8);
+}
+
+/*  Moves to a position of a binary tag file. Only the positions of records
+ *  can be reached directly; the records of a block depend upon those before
+ *  them, so a position within a block is reached by reading the records
+ *  before it.
+ */
+static int seekBinary (tagCursor *const cursor, const off_t pos)
+{
+	const tagFile *const file = cursor->file;
+	int result = 0;
+	cursor->binary.remaining = 0;
+	if (pos < 0  ||  pos > file->size)
+		result = -1;
+	else if (pos < file->binary.blocks)
+		cursor->next = (pos < file->binary.start) ? file->binary.start : pos;
+	else if (pos >= file->binary.end)
+		cursor->next = file->binary.end;
 	else
-		length = strlen (file->line.buffer);
-	while (length >= file->name.size)
-		growString (&file->name);
-	strncpy (file->name.buffer, file->line.buffer, length);
-	file->name.buffer [length] = '\0';
+	{
+		unsigned long lower = 0;
+		unsigned long upper = file->binary.count;
+		while (upper - lower > 1)
+		{
+			const unsigned long middle = lower + (upper - lower) / 2;
+			if (blockPosition (file, middle) <= pos)
+				lower = middle;
+			else
+				upper = middle;
+		}
+		cursor->next = blockPosition (file, lower);
+		while (cursor->next < pos  &&  readBinaryRecord (cursor))
+			;
+	}
+	return result;
 }
 
-static int readTagLineRaw (tagFile *const file)
+static int readTagLineRaw (tagCursor *const cursor)
 {
 	int result = 1;
 	int reReadLine;
 
+	if (cursor->file->binary.present  &&
+		cursor->next >= cursor->file->binary.blocks)
+		return readBinaryRecord (cursor);
+	if (cursor->file->map != NULL)
+		return readMappedLine (cursor);
+
 	/*  If reading the line places any character other than a null or a
 	 *  newline at the last character position in the buffer (one less than
 	 *  the buffer size), then we must resize the buffer and reattempt to read
@@ -182,17 +698,17 @@ static int readTagLineRaw (tagFile *const file)
 	 */
 	do
 	{
-		char *const pLastChar = file->line.buffer + file->line.size - 2;
+		char *const pLastChar = cursor->line.buffer + cursor->line.size - 2;
 		char *line;
 
-		file->pos = ftell (file->fp);
+		cursor->pos = ftell (cursor->fp);
 		reReadLine = 0;
 		*pLastChar = '\0';
-		line = fgets (file->line.buffer, (int) file->line.size, file->fp);
+		line = fgets (cursor->line.buffer, (int) cursor->line.size, cursor->fp);
 		if (line == NULL)
 		{
 			/* read error */
-			if (! feof (file->fp))
+			if (! feof (cursor->fp))
 				perror ("readTagLine");
 			result = 0;
 		}
@@ -200,111 +716,488 @@ static int readTagLineRaw (tagFile *const file)
 					*pLastChar != '\n'  &&  *pLastChar != '\r')
 		{
 			/*  buffer overflow */
-			growString (&file->line);
-			fseek (file->fp, file->pos, SEEK_SET);
+			growString (&cursor->line);
+			fseek (cursor->fp, cursor->pos, SEEK_SET);
 			reReadLine = 1;
 		}
 		else
 		{
-			size_t i = strlen (file->line.buffer);
+			size_t i = strlen (cursor->line.buffer);
 			while (i > 0  &&
-				   (file->line.buffer [i - 1] == '\n' || file->line.buffer [i - 1] == '\r'))
+				   (cursor->line.buffer [i - 1] == '\n' || cursor->line.buffer [i - 1] == '\r'))
 			{
-				file->line.buffer [i - 1] = '\0';
+				cursor->line.buffer [i - 1] = '\0';
 				--i;
 			}
 		}
 	} while (reReadLine  &&  result);
 	if (result)
-		copyName (file);
+		copyName (cursor);
 	return result;
 }
 
-static int readTagLine (tagFile *const file)
+static int readTagLine (tagCursor *const cursor)
 {
 	int result;
 	do
 	{
-		result = readTagLineRaw (file);
-	} while (result && *file->name.buffer == '\0');
+		result = readTagLineRaw (cursor);
+	} while (result && cursor->tag.length == 0);
 	return result;
 }
 
-static tagResult growFields (tagFile *const file)
+static int isPseudoTagLine (const tagCursor *const cursor)
 {
-	tagResult result = TagFailure;
-	unsigned short newCount = (unsigned short) 2 * file->fields.max;
-	tagExtensionField *newFields = (tagExtensionField*)
-			realloc (file->fields.list, newCount * sizeof (tagExtensionField));
-	if (newFields == NULL)
-		perror ("too many extension fields");
-	else
+	const size_t prefixLength = strlen (PseudoTagPrefix);
+	return (cursor->tag.length >= prefixLength  &&
+			strncmp (cursor->tag.buffer, PseudoTagPrefix, prefixLength) == 0);
+}
+
+static off_t tellTagFile (tagCursor *const cursor)
+{
+	if (cursor->file->map != NULL)
+		return cursor->next;
+	return ftell (cursor->fp);
+}
+
+static int seekTagFile (tagCursor *const cursor, const off_t pos)
+{
+	int result;
+	if (cursor->file->binary.present)
+		result = seekBinary (cursor, pos);
+	else if (cursor->file->map != NULL)
 	{
-		file->fields.list = newFields;
-		file->fields.max = newCount;
-		result = TagSuccess;
+		result = (pos >= 0  &&  pos <= cursor->file->size) ? 0 : -1;
+		if (result == 0)
+			cursor->next = pos;
 	}
+	else
+		result = fseek (cursor->fp, pos, SEEK_SET);
 	return result;
 }
 
-static void parseExtensionFields (tagFile *const file, tagEntry *const entry,
-								  char *const string)
+static void closeIndex (tagFile *const file)
 {
-	char *p = string;
-	while (p != NULL  &&  *p != '\0')
+	if (file->index.data != NULL)
 	{
-		while (*p == TAB)
-			*p++ = '\0';
-		if (*p != '\0')
-		{
-			char *colon;
-			char *field = p;
-			p = strchr (p, TAB);
-			if (p != NULL)
-				*p++ = '\0';
-			colon = strchr (field, ':');
-			if (colon == NULL)
-				entry->kind = field;
-			else
-			{
-				const char *key = field;
-				const char *value = colon + 1;
-				*colon = '\0';
-				if (strcmp (key, "kind") == 0)
-					entry->kind = value;
-				else if (strcmp (key, "file") == 0)
-					entry->fileScope = 1;
-				else if (strcmp (key, "line") == 0)
-					entry->address.lineNumber = atol (value);
-				else
-				{
-					if (entry->fields.count == file->fields.max)
-						growFields (file);
-					file->fields.list [entry->fields.count].key = key;
-					file->fields.list [entry->fields.count].value = value;
-					++entry->fields.count;
-				}
-			}
-		}
+#ifdef USE_MMAP
+		if (file->index.mapped)
+			munmap ((void*) file->index.data, file->index.size);
+		else
+#endif
+		free ((void*) file->index.data);
 	}
+	memset (&file->index, 0, sizeof (file->index));
+	file->cursor.search.section = NULL;
 }
 
-static void parseTagLine (tagFile *file, tagEntry *const entry)
+/*  Computes the check of the contents of the tag file recorded in its index,
+ *  as contentCheck () in tagindex.c does, leaving the file where it was.
+ */
+static unsigned long contentCheck (tagFile *const file, const off_t size)
 {
-	int i;
-	char *p = file->line.buffer;
-	char *tab = strchr (p, TAB);
+	unsigned char buffer [INDEX_CHECK_SIZE];
+	const off_t last = size > 2 * INDEX_CHECK_SIZE ?
+			size - INDEX_CHECK_SIZE : INDEX_CHECK_SIZE;
+	const long current = ftell (file->fp);
+	unsigned long result = 2166136261UL;
+	off_t position;
+	for (position = 0  ;  position < size  ;  position = last)
+	{
+		size_t length;
+		size_t i;
+		fseek (file->fp, position, SEEK_SET);
+		length = fread (buffer, 1, sizeof (buffer), file->fp);
+		for (i = 0  ;  i < length  ;  ++i)
+			result = ((result ^ buffer [i]) * 16777619UL) & 0xffffffffUL;
+		if (position == last)
+			break;
+	}
+	fseek (file->fp, current, SEEK_SET);
+	return result;
+}
 
-	entry->fields.list = NULL;
-	entry->fields.count = 0;
-	entry->kind = NULL;
-	entry->fileScope = 0;
+/*  The index is only valid for the tag file from which it was written. Its
+ *  contents are checked once, when its size and modification time are first
+ *  found to match, since they may match a tag file rewritten within the
+ *  resolution of its timestamp.
+ */
+static int isIndexCurrent (tagFile *const file,
+						   const struct stat *const status)
+{
+	const unsigned char *const header = file->index.data;
+	int result = (indexValue (header + 24, 8) == (off_t) status->st_size  &&
+			indexValue (header + 32, 8) == (off_t) status->st_mtime  &&
+			indexValue (header + 40, 4) == (off_t) mtimeNanoseconds (status));
+	if (result  &&  ! file->index.checked)
+	{
+		result = (indexValue (header + 44, 4) ==
+				(off_t) contentCheck (file, status->st_size));
+		file->index.checked = (short) result;
+	}
+	return result;
+}
 
-	entry->name = p;
-	if (tab != NULL)
+static int readIndexSections (tagFile *const file)
+{
+	const unsigned char *const data = file->index.data;
+	const size_t size = file->index.size;
+	const unsigned int width = (unsigned int) indexValue (data + 12, 4);
+	const unsigned long count = (unsigned long) indexValue (data + 16, 4);
+	int result = 0;
+	if (memcmp (data, INDEX_MAGIC, strlen (INDEX_MAGIC)) == 0  &&
+		indexValue (data + 8, 4) == INDEX_VERSION  &&
+		(width == 4  ||  (width == 8  &&  sizeof (off_t) >= 8))  &&
+		count <= (size - INDEX_HEADER_SIZE) / INDEX_SECTION_SIZE)
 	{
-		*tab = '\0';
-		p = tab + 1;
+		unsigned long i;
+		result = 1;
+		file->index.width = width;
+		for (i = 0  ;  result  &&  i < count  ;  ++i)
+		{
+			const unsigned char *const entry =
+					data + INDEX_HEADER_SIZE + i * INDEX_SECTION_SIZE;
+			const unsigned long id = (unsigned long) indexValue (entry, 4);
+			const unsigned long n = (unsigned long) indexValue (entry + 4, 4);
+			const off_t offset = indexValue (entry + 8, 8);
+			indexSection *section = NULL;
+			size_t entrySize = width;
+			if (id == INDEX_NAME)
+				section = &file->index.name;
+			else if (id == INDEX_FOLDED)
+				section = &file->index.folded;
+			else if (id == INDEX_COMPLETION)
+			{
+				section = &file->index.completion;
+				entrySize = INDEX_COMPLETION_SIZE;
+			}
+			else if (id == INDEX_STRINGS)
+			{
+				section = &file->index.strings;
+				entrySize = 1;
+			}
+			else if (id == INDEX_FILE)
+				section = &file->index.file;
+			else if (id == INDEX_SCOPE)
+				section = &file->index.scope;
+			if (section == NULL)
+				;  /* ignore unknown sections */
+			else if (offset < 0  ||  (size_t) offset > size  ||
+					 n > (size - (size_t) offset) / entrySize)
+				result = 0;
+			else
+			{
+				section->data = data + offset;
+				section->count = n;
+			}
+		}
+		if (file->index.name.data == NULL  ||  file->index.folded.data == NULL)
+			result = 0;
+		if (file->index.strings.count > 0  &&
+			file->index.strings.data [file->index.strings.count - 1] != '\0')
+		{
+			result = 0;
+		}
+	}
+	return result;
+}
+
+/*  Loads the sidecar index of the tag file, if one exists and is current.
+ */
+static void openIndex (tagFile *const file, const char *const filePath)
+{
+	char *const indexPath = (char*) malloc (
+			strlen (filePath) + strlen (IndexSuffix) + 1);
+	FILE *fp = NULL;
+	struct stat status;
+	if (indexPath != NULL)
+	{
+		strcpy (indexPath, filePath);
+		strcat (indexPath, IndexSuffix);
+		fp = fopen (indexPath, "rb");
+		free (indexPath);
+	}
+	if (fp != NULL)
+	{
+		if (fstat (fileno (fp), &status) == 0  &&
+			status.st_size >= INDEX_HEADER_SIZE  &&
+			(off_t) (size_t) status.st_size == status.st_size)
+		{
+			const size_t size = (size_t) status.st_size;
+#ifdef USE_MMAP
+			void *const map = mmap (NULL, size, PROT_READ, MAP_SHARED,
+									fileno (fp), 0);
+			if (map != MAP_FAILED)
+			{
+				file->index.data = (const unsigned char*) map;
+				file->index.mapped = 1;
+			}
+			else
+#endif
+			{
+				unsigned char *const buffer = (unsigned char*) malloc (size);
+				if (buffer != NULL  &&  fread (buffer, 1, size, fp) == size)
+					file->index.data = buffer;
+				else
+					free (buffer);
+			}
+			file->index.size = size;
+		}
+		fclose (fp);
+		if (file->index.data != NULL  &&  ! (readIndexSections (file)  &&
+				fstat (fileno (file->fp), &status) == 0  &&
+				isIndexCurrent (file, &status)))
+		{
+			closeIndex (file);
+		}
+	}
+}
+
+/*  Reads a string table of a binary tag file from position `pos'.
+ */
+static int readBinaryTable (tagFile *const file, const off_t pos,
+							const off_t limit, binaryTable *const table)
+{
+	const unsigned char *const data = (const unsigned char *) file->map + pos;
+	int result = 0;
+	if (pos >= 0  &&  limit - pos >= 8)
+	{
+		table->count = (unsigned long) indexValue (data, 4);
+		table->size = (unsigned long) indexValue (data + 4, 4);
+		table->offsets = data + 8;
+		table->strings = (const char *) table->offsets + 4 * table->count;
+		result = (table->count <= (unsigned long) (limit - pos - 8) / 4  &&
+				  table->size <= (unsigned long) (limit - pos - 8) - 4 * table->count  &&
+				  (table->size == 0  ||  table->strings [table->size - 1] == '\0'));
+	}
+	return result;
+}
+
+/*  Reads the header of a binary tag file. A damaged file is read as though
+ *  it held no tags.
+ */
+static void readBinaryHeader (tagFile *const file)
+{
+	const unsigned char *const header = (const unsigned char *) file->map;
+	memset (&file->binary, 0, sizeof (file->binary));
+	if (file->size >= BINARY_HEADER_SIZE  &&
+		memcmp (header, BINARY_MAGIC, strlen (BINARY_MAGIC)) == 0)
+	{
+		const off_t blocks = indexValue (header + 16, 8);
+		const off_t index = indexValue (header + 24, 8);
+		const off_t files = indexValue (header + 32, 8);
+		const off_t keys = indexValue (header + 40, 8);
+		const off_t values = indexValue (header + 48, 8);
+		const off_t count = indexValue (header + 56, 8);
+		const off_t end = indexValue (header + 64, 8);
+		int valid = (indexValue (header + 8, 4) == BINARY_VERSION  &&
+					 BINARY_HEADER_SIZE <= blocks  &&  blocks <= index  &&
+					 index <= files  &&  files <= keys  &&  keys <= values  &&
+					 values <= end  &&  end <= file->size  &&
+					 count >= 0  &&  count <= (files - index) / 8  &&
+					 (count > 0  ||  blocks == index));
+		file->binary.present = 1;
+		file->binary.index = header + index;
+		file->binary.count = (unsigned long) count;
+		if (valid)
+			valid = (readBinaryTable (file, files, keys, &file->binary.files)  &&
+					 readBinaryTable (file, keys, values, &file->binary.keys)  &&
+					 readBinaryTable (file, values, end, &file->binary.values));
+		if (valid  &&  count > 0)
+		{
+			unsigned long i;
+			valid = (blockPosition (file, 0) == blocks);
+			for (i = 1  ;  valid  &&  i < file->binary.count  ;  ++i)
+				valid = (blockPosition (file, i - 1) < blockPosition (file, i));
+			if (valid)
+				valid = (blockPosition (file, file->binary.count - 1) < index);
+		}
+		if (valid)
+		{
+			file->binary.start = BINARY_HEADER_SIZE;
+			file->binary.blocks = blocks;
+			file->binary.end = index;
+		}
+		else
+		{
+			file->binary.start = file->size;
+			file->binary.blocks = file->size;
+			file->binary.end = file->size;
+			file->binary.count = 0;
+		}
+	}
+}
+
+static int isBinaryFile (FILE *const fp)
+{
+	char magic [sizeof (BINARY_MAGIC)];
+	const size_t length = strlen (BINARY_MAGIC);
+	int result = 0;
+	rewind (fp);
+	if (fread (magic, 1, length, fp) == length)
+		result = (memcmp (magic, BINARY_MAGIC, length) == 0);
+	rewind (fp);
+	return result;
+}
+
+static void unmapFile (tagFile *const file)
+{
+	if (file->map != NULL)
+	{
+#ifdef USE_MMAP
+		if (! file->allocated)
+			munmap ((void*) file->map, (size_t) file->size);
+		else
+#endif
+		free ((void*) file->map);
+	}
+	file->map = NULL;
+	file->allocated = 0;
+	memset (&file->binary, 0, sizeof (file->binary));
+}
+
+/*  Determines the current size of the tag file. A mapped file is remapped if
+ *  its size has changed since it was mapped (e.g. it was regenerated). A
+ *  binary tag file is always held in memory, being read into an allocated
+ *  buffer if it cannot be mapped.
+ */
+static void updateFileSize (tagFile *const file)
+{
+	struct stat status;
+	const int known = (fstat (fileno (file->fp), &status) == 0);
+	if (file->index.data != NULL  &&  ! (known  &&  isIndexCurrent (file, &status)))
+		closeIndex (file);
+	if (known)
+	{
+		if (file->map != NULL  &&  status.st_size == file->size)
+			return;
+		unmapFile (file);
+		if (status.st_size > 0  &&
+			(off_t) (size_t) status.st_size == status.st_size)
+		{
+			const size_t size = (size_t) status.st_size;
+#ifdef USE_MMAP
+			void *const map = mmap (NULL, size, PROT_READ, MAP_SHARED,
+									fileno (file->fp), 0);
+			if (map != MAP_FAILED)
+				file->map = (const char*) map;
+			else
+#endif
+			if (isBinaryFile (file->fp))
+			{
+				char *const buffer = (char*) malloc (size);
+				if (buffer != NULL  &&  fread (buffer, 1, size, file->fp) == size)
+				{
+					file->map = buffer;
+					file->allocated = 1;
+				}
+				else
+					free (buffer);
+				rewind (file->fp);
+			}
+			if (file->map != NULL)
+			{
+				file->size = status.st_size;
+				readBinaryHeader (file);
+				return;
+			}
+		}
+	}
+	fseek (file->fp, 0, SEEK_END);
+	file->size = ftell (file->fp);
+	rewind (file->fp);
+}
+
+/*  Follows changes to the tag file before a search, unless cursors share the
+ *  tag file, which must then remain unchanged.
+ */
+static void refresh (tagCursor *const cursor)
+{
+	if (! cursor->file->shared)
+		updateFileSize (cursor->file);
+}
+
+static tagResult growFields (tagCursor *const cursor)
+{
+	tagResult result = TagFailure;
+	unsigned short newCount = (unsigned short) 2 * cursor->fields.max;
+	tagExtensionField *newFields = (tagExtensionField*)
+			realloc (cursor->fields.list, newCount * sizeof (tagExtensionField));
+	if (newFields == NULL)
+		perror ("too many extension fields");
+	else
+	{
+		cursor->fields.list = newFields;
+		cursor->fields.max = newCount;
+		result = TagSuccess;
+	}
+	return result;
+}
+
+static void parseExtensionFields (tagCursor *const cursor, tagEntry *const entry,
+								  char *const string)
+{
+	char *p = string;
+	while (p != NULL  &&  *p != '\0')
+	{
+		while (*p == TAB)
+			*p++ = '\0';
+		if (*p != '\0')
+		{
+			char *colon;
+			char *field = p;
+			p = strchr (p, TAB);
+			if (p != NULL)
+				*p++ = '\0';
+			colon = strchr (field, ':');
+			if (colon == NULL)
+				entry->kind = field;
+			else
+			{
+				const char *key = field;
+				const char *value = colon + 1;
+				*colon = '\0';
+				if (strcmp (key, "kind") == 0)
+					entry->kind = value;
+				else if (strcmp (key, "file") == 0)
+					entry->fileScope = 1;
+				else if (strcmp (key, "line") == 0)
+					entry->address.lineNumber = atol (value);
+				else
+				{
+					if (entry->fields.count == cursor->fields.max)
+						growFields (cursor);
+					cursor->fields.list [entry->fields.count].key = key;
+					cursor->fields.list [entry->fields.count].value = value;
+					++entry->fields.count;
+				}
+			}
+		}
+	}
+}
+
+static void parseTagLine (tagCursor *const cursor, tagEntry *const entry)
+{
+	int i;
+	char *p;
+	char *tab;
+
+	loadLine (cursor);
+	p = cursor->line.buffer;
+	tab = strchr (p, TAB);
+	entry->fields.list = NULL;
+	entry->fields.count = 0;
+	entry->kind = NULL;
+	entry->fileScope = 0;
+	entry->file = EmptyString;
+	entry->address.pattern = EmptyString;
+	entry->address.lineNumber = 0;
+
+	entry->name = p;
+	if (tab != NULL)
+	{
+		*tab = '\0';
+		p = tab + 1;
 		entry->file = p;
 		tab = strchr (p, TAB);
 		if (tab != NULL)
@@ -324,7 +1217,8 @@ static void parseTagLine (tagFile *file, tagEntry *const entry)
 				} while (p != NULL  &&  *(p - 1) == '\\');
 				if (p == NULL)
 				{
-					/* invalid pattern */
+					/* invalid pattern, taken to extend to the end of the line */
+					p = tab + 1 + strlen (tab + 1);
 				}
 				else
 					++p;
@@ -344,15 +1238,15 @@ static void parseTagLine (tagFile *file, tagEntry *const entry)
 			fieldsPresent = (strncmp (p, ";\"", 2) == 0);
 			*p = '\0';
 			if (fieldsPresent)
-				parseExtensionFields (file, entry, p + 2);
+				parseExtensionFields (cursor, entry, p + 2);
 		}
 	}
 	if (entry->fields.count > 0)
-		entry->fields.list = file->fields.list;
-	for (i = entry->fields.count  ;  i < file->fields.max  ;  ++i)
+		entry->fields.list = cursor->fields.list;
+	for (i = entry->fields.count  ;  i < cursor->fields.max  ;  ++i)
 	{
-		file->fields.list [i].key = NULL;
-		file->fields.list [i].value = NULL;
+		cursor->fields.list [i].key = NULL;
+		cursor->fields.list [i].value = NULL;
 	}
 }
 
@@ -368,9 +1262,9 @@ static char *duplicate (const char *str)
 	return result;
 }
 
-static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
+static void readPseudoTags (tagCursor *const cursor, tagFileInfo *const info)
 {
-	fpos_t startOfLine;
+	off_t startOfLine;
 	const size_t prefixLength = strlen (PseudoTagPrefix);
 	if (info != NULL)
 	{
@@ -381,60 +1275,77 @@ static void readPseudoTags (tagFile *const file, tagFileInfo *const info)
 		info->program.url     = NULL;
 		info->program.version = NULL;
 	}
+	seekTagFile (cursor, 0);
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
-		if (! readTagLine (file))
+		startOfLine = tellTagFile (cursor);
+		if (! readTagLine (cursor))
 			break;
-		if (strncmp (file->line.buffer, PseudoTagPrefix, prefixLength) != 0)
+		if (! isPseudoTagLine (cursor))
 			break;
 		else
 		{
 			tagEntry entry;
 			const char *key, *value;
-			parseTagLine (file, &entry);
+			parseTagLine (cursor, &entry);
 			key = entry.name + prefixLength;
 			value = entry.file;
 			if (strcmp (key, "TAG_FILE_SORTED") == 0)
-				file->sortMethod = (sortType) atoi (value);
+				cursor->file->sortMethod = (sortType) atoi (value);
 			else if (strcmp (key, "TAG_FILE_FORMAT") == 0)
-				file->format = (short) atoi (value);
+				cursor->file->format = (short) atoi (value);
 			else if (strcmp (key, "TAG_PROGRAM_AUTHOR") == 0)
-				file->program.author = duplicate (value);
+				cursor->file->program.author = duplicate (value);
 			else if (strcmp (key, "TAG_PROGRAM_NAME") == 0)
-				file->program.name = duplicate (value);
+				cursor->file->program.name = duplicate (value);
 			else if (strcmp (key, "TAG_PROGRAM_URL") == 0)
-				file->program.url = duplicate (value);
+				cursor->file->program.url = duplicate (value);
 			else if (strcmp (key, "TAG_PROGRAM_VERSION") == 0)
-				file->program.version = duplicate (value);
+				cursor->file->program.version = duplicate (value);
 			if (info != NULL)
 			{
-				info->file.format     = file->format;
-				info->file.sort       = file->sortMethod;
-				info->program.author  = file->program.author;
-				info->program.name    = file->program.name;
-				info->program.url     = file->program.url;
-				info->program.version = file->program.version;
+				info->file.format     = cursor->file->format;
+				info->file.sort       = cursor->file->sortMethod;
+				info->program.author  = cursor->file->program.author;
+				info->program.name    = cursor->file->program.name;
+				info->program.url     = cursor->file->program.url;
+				info->program.version = cursor->file->program.version;
 			}
 		}
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (cursor, startOfLine);
 }
 
-static void gotoFirstLogicalTag (tagFile *const file)
+static void gotoFirstLogicalTag (tagCursor *const cursor)
 {
-	fpos_t startOfLine;
-	const size_t prefixLength = strlen (PseudoTagPrefix);
-	rewind (file->fp);
+	off_t startOfLine;
+	seekTagFile (cursor, 0);
 	while (1)
 	{
-		fgetpos (file->fp, &startOfLine);
-		if (! readTagLine (file))
+		startOfLine = tellTagFile (cursor);
+		if (! readTagLine (cursor))
 			break;
-		if (strncmp (file->line.buffer, PseudoTagPrefix, prefixLength) != 0)
+		if (! isPseudoTagLine (cursor))
 			break;
 	}
-	fsetpos (file->fp, &startOfLine);
+	seekTagFile (cursor, startOfLine);
+}
+
+static int isMapped (const tagFile *const file)
+{
+	return (file->map != NULL);
+}
+
+static void initializeCursor (tagCursor *const cursor, tagFile *const file,
+							  FILE *const fp)
+{
+	cursor->file = file;
+	cursor->fp = fp;
+	growString (&cursor->line);
+	growString (&cursor->name);
+	cursor->fields.max = 20;
+	cursor->fields.list = (tagExtensionField*) calloc (
+		cursor->fields.max, sizeof (tagExtensionField));
 }
 
 static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
@@ -442,11 +1353,6 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 	tagFile *result = (tagFile*) calloc ((size_t) 1, sizeof (tagFile));
 	if (result != NULL)
 	{
-		growString (&result->line);
-		growString (&result->name);
-		result->fields.max = 20;
-		result->fields.list = (tagExtensionField*) calloc (
-			result->fields.max, sizeof (tagExtensionField));
 		result->fp = fopen (filePath, "r");
 		if (result->fp == NULL)
 		{
@@ -456,10 +1362,12 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 		}
 		else
 		{
-			fseek (result->fp, 0, SEEK_END);
-			result->size = ftell (result->fp);
-			rewind (result->fp);
-			readPseudoTags (result, info);
+			initializeCursor (&result->cursor, result, result->fp);
+			result->path = duplicate (filePath);
+			updateFileSize (result);
+			if (! result->binary.present)
+				openIndex (result, filePath);
+			readPseudoTags (&result->cursor, info);
 			info->status.opened = 1;
 			result->initialized = 1;
 		}
@@ -467,13 +1375,59 @@ static tagFile *initialize (const char *const filePath, tagFileInfo *const info)
 	return result;
 }
 
+static tagCursor *newCursor (tagFile *const file)
+{
+	tagCursor *result = (tagCursor*) calloc ((size_t) 1, sizeof (tagCursor));
+	if (result != NULL)
+	{
+		FILE *fp = NULL;
+		if (! isMapped (file))
+			fp = fopen (file->path, "r");
+		if (fp == NULL  &&  ! isMapped (file))
+		{
+			free (result);
+			result = NULL;
+		}
+		else
+		{
+			initializeCursor (result, file, fp);
+			file->shared = 1;
+			gotoFirstLogicalTag (result);
+		}
+	}
+	return result;
+}
+
+static void freeCompletions (tagCursor *const cursor)
+{
+	int i;
+	for (i = 0  ;  i < cursor->completion.count  ;  ++i)
+		free (cursor->completion.list [i]);
+	free (cursor->completion.list);
+	cursor->completion.list = NULL;
+	cursor->completion.count = 0;
+}
+
+static void terminateCursor (tagCursor *const cursor)
+{
+	if (cursor->fp != NULL  &&  cursor->fp != cursor->file->fp)
+		fclose (cursor->fp);
+	freeCompletions (cursor);
+
+	free (cursor->line.buffer);
+	free (cursor->name.buffer);
+	free (cursor->binary.previous.buffer);
+	free (cursor->fields.list);
+	if (cursor->search.name != NULL)
+		free (cursor->search.name);
+}
+
 static void terminate (tagFile *const file)
 {
+	terminateCursor (&file->cursor);
+	unmapFile (file);
 	fclose (file->fp);
-
-	free (file->line.buffer);
-	free (file->name.buffer);
-	free (file->fields.list);
+	closeIndex (file);
 
 	if (file->program.author != NULL)
 		free (file->program.author);
@@ -483,25 +1437,25 @@ static void terminate (tagFile *const file)
 		free (file->program.url);
 	if (file->program.version != NULL)
 		free (file->program.version);
-	if (file->search.name != NULL)
-		free (file->search.name);
+	if (file->path != NULL)
+		free (file->path);
 
 	memset (file, 0, sizeof (tagFile));
 
 	free (file);
 }
 
-static tagResult readNext (tagFile *const file, tagEntry *const entry)
+static tagResult readNext (tagCursor *const cursor, tagEntry *const entry)
 {
 	tagResult result;
-	if (file == NULL  ||  ! file->initialized)
+	if (cursor == NULL  ||  ! cursor->file->initialized)
 		result = TagFailure;
-	else if (! readTagLine (file))
+	else if (! readTagLine (cursor))
 		result = TagFailure;
 	else
 	{
 		if (entry != NULL)
-			parseTagLine (file, entry);
+			parseTagLine (cursor, entry);
 		result = TagSuccess;
 	}
 	return result;
@@ -522,46 +1476,59 @@ static const char *readFieldValue (
 	return result;
 }
 
-static int readTagLineSeek (tagFile *const file, const off_t pos)
+static int readTagLineSeek (tagCursor *const cursor, const off_t pos)
 {
 	int result = 0;
-	if (fseek (file->fp, pos, SEEK_SET) == 0)
+	if (seekTagFile (cursor, pos) == 0)
 	{
-		result = readTagLine (file);  /* read probable partial line */
-		if (pos > 0  &&  result)
-			result = readTagLine (file);  /* read complete line */
+		if (pos == 0)
+			result = readTagLine (cursor);
+		else
+		{
+			/*  read probable partial line (which may be empty if `pos' is at
+			 *  the end of a line), then complete line */
+			result = readTagLineRaw (cursor);
+			if (result)
+				result = readTagLine (cursor);
+		}
 	}
 	return result;
 }
 
-static int nameComparison (tagFile *const file)
+/*  Compares the search name against the name of the tag in the last line
+ *  read. The latter is not null terminated when it lies within the mapping,
+ *  so the comparison observes its length; otherwise the result is the same as
+ *  that of strcmp (), strncmp (), struppercmp () or strnuppercmp ().
+ */
+static int nameComparison (tagCursor *const cursor)
 {
-	int result;
-	if (file->search.ignorecase)
-	{
-		if (file->search.partial)
-			result = strnuppercmp (file->search.name, file->name.buffer,
-					file->search.nameLength);
-		else
-			result = struppercmp (file->search.name, file->name.buffer);
-	}
-	else
+	const char *const name = cursor->search.name;
+	const char *const tag = cursor->tag.buffer;
+	const size_t tagLength = cursor->tag.length;
+	const size_t limit = cursor->search.partial ?
+			cursor->search.nameLength : cursor->search.nameLength + 1;
+	int result = 0;
+	size_t i;
+	for (i = 0  ;  result == 0  &&  i < limit  ;  ++i)
 	{
-		if (file->search.partial)
-			result = strncmp (file->search.name, file->name.buffer,
-					file->search.nameLength);
+		if (cursor->search.ignorecase)
+			result = toupper ((int) name [i]) -
+				toupper ((int) (i < tagLength ? tag [i] : '\0'));
 		else
-			result = strcmp (file->search.name, file->name.buffer);
+			result = (int) (unsigned char) name [i] -
+				(int) (unsigned char) (i < tagLength ? tag [i] : '\0');
+		if (name [i] == '\0')
+			break;
 	}
 	return result;
 }
 
-static void findFirstNonMatchBefore (tagFile *const file)
+static void findFirstNonMatchBefore (tagCursor *const cursor)
 {
 #define JUMP_BACK 512
 	int more_lines;
 	int comp;
-	off_t start = file->pos;
+	off_t start = cursor->pos;
 	off_t pos = start;
 	do
 	{
@@ -569,39 +1536,93 @@ static void findFirstNonMatchBefore (tagFile *const file)
 			pos = 0;
 		else
 			pos = pos - JUMP_BACK;
-		more_lines = readTagLineSeek (file, pos);
-		comp = nameComparison (file);
+		more_lines = readTagLineSeek (cursor, pos);
+		comp = nameComparison (cursor);
 	} while (more_lines  &&  comp == 0  &&  pos > 0  &&  pos < start);
 }
 
-static tagResult findFirstMatchBefore (tagFile *const file)
+static tagResult findFirstMatchBefore (tagCursor *const cursor)
 {
 	tagResult result = TagFailure;
 	int more_lines;
-	off_t start = file->pos;
-	findFirstNonMatchBefore (file);
+	off_t start = cursor->pos;
+	findFirstNonMatchBefore (cursor);
 	do
 	{
-		more_lines = readTagLine (file);
-		if (nameComparison (file) == 0)
+		more_lines = readTagLine (cursor);
+		if (nameComparison (cursor) == 0)
 			result = TagSuccess;
-	} while (more_lines  &&  result != TagSuccess  &&  file->pos < start);
+	} while (more_lines  &&  result != TagSuccess  &&  cursor->pos < start);
+	return result;
+}
+
+/*  Searches the blocks of a sorted binary tag file for the first match,
+ *  which must lie in a record starting after `lower'. Only the first record
+ *  of each block is read to find the block in which the matches begin.
+ */
+static tagResult findBlocks (tagCursor *const cursor, const off_t lower)
+{
+	const tagFile *const file = cursor->file;
+	tagResult result = TagFailure;
+	unsigned long first = 0;
+	unsigned long low, high;
+	off_t start;
+	high = file->binary.count;
+	while (high - first > 1)
+	{
+		const unsigned long middle = first + (high - first) / 2;
+		if (blockPosition (file, middle) <= lower)
+			first = middle;
+		else
+			high = middle;
+	}
+	low = first;
+	high = file->binary.count;
+	while (low < high)
+	{
+		const unsigned long middle = low + (high - low) / 2;
+		seekBinary (cursor, blockPosition (file, middle));
+		if (readBinaryRecord (cursor)  &&  nameComparison (cursor) > 0)
+			low = middle + 1;
+		else
+			high = middle;
+	}
+	if (file->binary.count > 0)
+	{
+		start = blockPosition (file, low > first ? low - 1 : first);
+		if (start <= lower)
+			start = lower + 1;
+		seekBinary (cursor, start);
+		while (result == TagFailure  &&  readTagLine (cursor))
+		{
+			const int comp = nameComparison (cursor);
+			if (comp == 0)
+				result = TagSuccess;
+			else if (comp < 0)
+				break;
+		}
+	}
 	return result;
 }
 
-static tagResult findBinary (tagFile *const file)
+/*  Searches a sorted tag file for the first match. The first match must lie
+ *  in a line starting after `lower'.
+ */
+static tagResult findBinary (tagCursor *const cursor, const off_t lower)
 {
 	tagResult result = TagFailure;
-	off_t lower_limit = 0;
-	off_t upper_limit = file->size;
+	off_t lower_limit = lower;
+	off_t upper_limit = cursor->file->size;
 	off_t last_pos = 0;
-	off_t pos = upper_limit / 2;
+	off_t pos = lower_limit + ((upper_limit - lower_limit) / 2);
+	if (cursor->file->binary.present)
+		return findBlocks (cursor, lower);
 	while (result != TagSuccess)
 	{
-		if (! readTagLineSeek (file, pos))
+		if (! readTagLineSeek (cursor, pos))
 		{
 			/* in case we fell off end of file */
-			result = findFirstMatchBefore (file);
+			result = findFirstMatchBefore (cursor);
 			break;
 		}
 		else if (pos == last_pos)
@@ -611,7 +1632,7 @@ static tagResult findBinary (tagFile *const file)
 		}
 		else
 		{
-			const int comp = nameComparison (file);
+			const int comp = nameComparison (cursor);
 			last_pos = pos;
 			if (comp < 0)
 			{
@@ -626,87 +1647,1185 @@ static tagResult findBinary (tagFile *const file)
 			else if (pos == 0)
 				result = TagSuccess;
 			else
-				result = findFirstMatchBefore (file);
+				result = findFirstMatchBefore (cursor);
 		}
 	}
 	return result;
 }
 
-static tagResult findSequential (tagFile *const file)
+static tagResult findSequential (tagCursor *const cursor)
 {
 	tagResult result = TagFailure;
-	if (file->initialized)
+	if (cursor->file->initialized)
 	{
-		while (result == TagFailure  &&  readTagLine (file))
+		while (result == TagFailure  &&  readTagLine (cursor))
 		{
-			if (nameComparison (file) == 0)
+			if (nameComparison (cursor) == 0)
 				result = TagSuccess;
 		}
 	}
 	return result;
 }
 
-static tagResult find (tagFile *const file, tagEntry *const entry,
-					   const char *const name, const int options)
+/*  Reads the tag line at position `i' of the index section being searched.
+ */
+static int readIndexedLine (tagCursor *const cursor,
+							const indexSection *const section,
+							const unsigned long i)
 {
-	tagResult result;
-	if (file->search.name != NULL)
-		free (file->search.name);
-	file->search.name = duplicate (name);
-	file->search.nameLength = strlen (name);
-	file->search.partial = (options & TAG_PARTIALMATCH) != 0;
-	file->search.ignorecase = (options & TAG_IGNORECASE) != 0;
-	fseek (file->fp, 0, SEEK_END);
-	file->size = ftell (file->fp);
-	rewind (file->fp);
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
-		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
-	{
-#ifdef DEBUG
-		printf ("<performing binary search>\n");
-#endif
-		result = findBinary (file);
-	}
-	else
+	const unsigned int width = cursor->file->index.width;
+	const off_t pos = indexValue (section->data + i * width, width);
+	int result = 0;
+	if (seekTagFile (cursor, pos) == 0)
+		result = readTagLineRaw (cursor);
+	return result;
+}
+
+/*  Finds the first match in the index by binary search; unlike findBinary (),
+ *  this does not depend upon the order of the tag file itself. The first
+ *  match must lie at or after position `start' of the index.
+ */
+static tagResult findIndexed (tagCursor *const cursor, const unsigned long start)
+{
+	tagResult result = TagFailure;
+	unsigned long lower = start;
+	unsigned long upper = cursor->search.section->count;
+	while (lower < upper)
 	{
-#ifdef DEBUG
-		printf ("<performing sequential search>\n");
-#endif
-		result = findSequential (file);
+		const unsigned long middle = lower + (upper - lower) / 2;
+		if (readIndexedLine (cursor, cursor->search.section, middle)  &&
+			nameComparison (cursor) > 0)
+			lower = middle + 1;
+		else
+			upper = middle;
 	}
-
-	if (result != TagSuccess)
-		file->search.pos = file->size;
-	else
+	cursor->search.indexPos = lower;
+	if (lower < cursor->search.section->count  &&
+		readIndexedLine (cursor, cursor->search.section, lower)  &&
+		nameComparison (cursor) == 0)
 	{
-		file->search.pos = file->pos;
-		if (entry != NULL)
-			parseTagLine (file, entry);
+		result = TagSuccess;
 	}
 	return result;
 }
 
-static tagResult findNext (tagFile *const file, tagEntry *const entry)
+static tagResult findNextIndexed (tagCursor *const cursor)
 {
-	tagResult result;
-	if ((file->sortMethod == TAG_SORTED      && !file->search.ignorecase) ||
-		(file->sortMethod == TAG_FOLDSORTED  &&  file->search.ignorecase))
-	{
-		result = tagsNext (file, entry);
-		if (result == TagSuccess  && nameComparison (file) != 0)
-			result = TagFailure;
-	}
-	else
+	tagResult result = TagFailure;
+	if (cursor->search.indexPos + 1 < cursor->search.section->count)
 	{
-		result = findSequential (file);
-		if (result == TagSuccess  &&  entry != NULL)
-			parseTagLine (file, entry);
+		++cursor->search.indexPos;
+		if (readIndexedLine (cursor, cursor->search.section,
+							 cursor->search.indexPos)  &&
+			nameComparison (cursor) == 0)
+		{
+			result = TagSuccess;
+		}
 	}
 	return result;
 }
 
-/*
-*  EXTERNAL INTERFACE
+static void setSearch (tagCursor *const cursor, const char *const name,
+					   const int options)
+{
+	if (cursor->search.name != NULL)
+		free (cursor->search.name);
+	cursor->search.name = duplicate (name);
+	cursor->search.nameLength = strlen (name);
+	cursor->search.partial = (options & TAG_PARTIALMATCH) != 0;
+	cursor->search.ignorecase = (options & TAG_IGNORECASE) != 0;
+}
+
+static int isBinarySearchable (const tagCursor *const cursor)
+{
+	return ((cursor->file->sortMethod == TAG_SORTED      && !cursor->search.ignorecase) ||
+			(cursor->file->sortMethod == TAG_FOLDSORTED  &&  cursor->search.ignorecase));
+}
+
+static tagResult find (tagCursor *const cursor, tagEntry *const entry,
+					   const char *const name, const int options)
+{
+	tagResult result;
+	setSearch (cursor, name, options);
+	refresh (cursor);
+	seekTagFile (cursor, 0);
+	cursor->search.section = NULL;
+	if (cursor->file->index.data != NULL)
+	{
+#ifdef DEBUG
+		printf ("<performing indexed search>\n");
+#endif
+		cursor->search.section = cursor->search.ignorecase ?
+				&cursor->file->index.folded : &cursor->file->index.name;
+		result = findIndexed (cursor, 0);
+	}
+	else if (isBinarySearchable (cursor))
+	{
+#ifdef DEBUG
+		printf ("<performing binary search>\n");
+#endif
+		result = findBinary (cursor, 0);
+	}
+	else
+	{
+#ifdef DEBUG
+		printf ("<performing sequential search>\n");
+#endif
+		result = findSequential (cursor);
+	}
+
+	if (result != TagSuccess)
+		cursor->search.pos = cursor->file->size;
+	else
+	{
+		cursor->search.pos = cursor->pos;
+		if (entry != NULL)
+			parseTagLine (cursor, entry);
+	}
+	return result;
+}
+
+static tagResult findNext (tagCursor *const cursor, tagEntry *const entry)
+{
+	tagResult result;
+	if (cursor->search.section != NULL)
+	{
+		result = findNextIndexed (cursor);
+		if (result == TagSuccess  &&  entry != NULL)
+			parseTagLine (cursor, entry);
+	}
+	else if (isBinarySearchable (cursor))
+	{
+		result = readNext (cursor, entry);
+		if (result == TagSuccess  && nameComparison (cursor) != 0)
+			result = TagFailure;
+	}
+	else
+	{
+		result = findSequential (cursor);
+		if (result == TagSuccess  &&  entry != NULL)
+			parseTagLine (cursor, entry);
+	}
+	return result;
+}
+
+/*  Returns the bit of the completion mask for character `c'. This must agree
+ *  with characterBit () in tagindex.c in the ctags sources.
+ */
+static int characterBit (const int c)
+{
+	int result;
+	if (isalpha (c))
+		result = toupper (c) - 'A';
+	else if (isdigit (c))
+		result = 26 + (c - '0');
+	else if (c == '_')
+		result = 36;
+	else
+		result = 37 + (c % 27);
+	return result;
+}
+
+static int isWordStart (const char *const name, const size_t i)
+{
+	return (i == 0  ||
+			! isalnum ((int) (unsigned char) name [i - 1])  ||
+			(islower ((int) (unsigned char) name [i - 1])  &&
+			 isupper ((int) (unsigned char) name [i])));
+}
+
+static int isSameCharacter (const int a, const int b, const int ignorecase)
+{
+	if (ignorecase)
+		return toupper (a) == toupper (b);
+	else
+		return a == b;
+}
+
+static int isSubsequence (const char *const pattern,
+						  const char *const name, const size_t length,
+						  const int ignorecase)
+{
+	const char *p = pattern;
+	size_t i;
+	for (i = 0  ;  *p != '\0'  &&  i < length  ;  ++i)
+		if (isSameCharacter (*p, name [i], ignorecase))
+			++p;
+	return (*p == '\0');
+}
+
+static int isPrefix (const char *const pattern, const size_t patternLength,
+					 const char *const name, const size_t length,
+					 const int ignorecase)
+{
+	size_t i;
+	int result = (length >= patternLength);
+	for (i = 0  ;  result  &&  i < patternLength  ;  ++i)
+		result = isSameCharacter (pattern [i], name [i], ignorecase);
+	return result;
+}
+
+/*  Matches `pattern' against `name' as a subsequence, preferring to match
+ *  characters at the start of words (e.g. "gtfl" matches getFileLanguage at
+ *  each capital). Characters matched at word starts and runs of consecutive
+ *  matches raise the score; gaps and unmatched characters lower it.
+ */
+static int fuzzyMatch (const char *const pattern,
+					   const char *const name, const size_t length,
+					   const int ignorecase, int *const score)
+{
+	const size_t patternLength = strlen (pattern);
+	size_t next = 0;
+	size_t last = 0;
+	size_t p;
+	int result = 1;
+	*score = 0;
+	for (p = 0  ;  result  &&  p < patternLength  ;  ++p)
+	{
+		size_t i = next;
+		while (i < length  &&  ! isSameCharacter (pattern [p], name [i], ignorecase))
+			++i;
+		if (i == length)
+			result = 0;
+		else
+		{
+			if (! isWordStart (name, i)  &&  ! (p > 0  &&  i == last + 1))
+			{
+				size_t j;
+				for (j = i + 1  ;  j < length  ;  ++j)
+				{
+					if (isSameCharacter (pattern [p], name [j], ignorecase)  &&
+						isWordStart (name, j)  &&
+						isSubsequence (pattern + p + 1, name + j + 1,
+									   length - j - 1, ignorecase))
+					{
+						i = j;
+						break;
+					}
+				}
+			}
+			*score += 1;
+			if (i == 0)
+				*score += 8;
+			if (isWordStart (name, i))
+				*score += 8;
+			if (p > 0  &&  i == last + 1)
+				*score += 4;
+			else if (p > 0)
+				*score -= 1;
+			last = i;
+			next = i + 1;
+		}
+	}
+	if (result)
+	{
+		*score -= (int) ((length - patternLength) / 8);
+		if (length == patternLength)
+			*score += 16;
+	}
+	return result;
+}
+
+/*  Compares the names of candidates as the index orders them: ignoring case,
+ *  then observing it.
+ */
+static int compareNames (const char *const a, const char *const b)
+{
+	size_t i = 0;
+	int result;
+	do
+	{
+		result = toupper ((int) a [i]) - toupper ((int) b [i]);
+	} while (result == 0  &&  a [i] != '\0'  &&  b [i++] != '\0');
+	if (result == 0)
+		result = strcmp (a, b);
+	return result;
+}
+
+/*  Orders candidates by decreasing score, then by name.
+ */
+static int compareCandidates (const tagCompletion *const a,
+							  const tagCompletion *const b)
+{
+	int result = b->score - a->score;
+	if (result == 0)
+		result = compareNames (a->name, b->name);
+	return result;
+}
+
+/*  Inserts `candidate' into `list', which is kept ordered and holds at most
+ *  `max' entries. Returns the position at which it was inserted, or -1 if it
+ *  ranks too low or is already present. If a candidate is displaced from a
+ *  full list, it is returned in `dropped'.
+ */
+static int addCandidate (tagCompletion *const list, int *const count,
+						 const int max, const tagCompletion *const candidate,
+						 tagCompletion *const dropped)
+{
+	int i = *count;
+	int result = -1;
+	dropped->name = NULL;
+	if (max > 0  &&  (i < max  ||  compareCandidates (candidate, &list [i - 1]) < 0))
+	{
+		while (i > 0  &&  compareCandidates (candidate, &list [i - 1]) < 0)
+			--i;
+		if (i == 0  ||  compareCandidates (candidate, &list [i - 1]) != 0)
+		{
+			if (*count == max)
+				*dropped = list [max - 1];
+			else
+				++*count;
+			memmove (list + i + 1, list + i,
+					 (size_t) (*count - 1 - i) * sizeof (tagCompletion));
+			list [i] = *candidate;
+			result = i;
+		}
+	}
+	return result;
+}
+
+static void patternMask (const char *const pattern, unsigned char *const mask)
+{
+	const char *p;
+	memset (mask, 0, INDEX_MASK_SIZE);
+	for (p = pattern  ;  *p != '\0'  ;  ++p)
+	{
+		const int bit = characterBit ((int) (unsigned char) *p);
+		mask [bit / 8] |= (unsigned char) (1 << (bit % 8));
+	}
+}
+
+static const char *completionName (const tagFile *const file,
+								   const unsigned long i)
+{
+	const unsigned char *const record =
+			file->index.completion.data + i * INDEX_COMPLETION_SIZE;
+	const unsigned long offset =
+			(unsigned long) indexValue (record + INDEX_MASK_SIZE, 4);
+	const char *result = EmptyString;
+	if (offset < file->index.strings.count)
+		result = (const char *) file->index.strings.data + offset;
+	return result;
+}
+
+/*  Completes `pattern' from the names in the index. Names with a given prefix
+ *  are adjacent in the index, so are found by binary search; fuzzy matches
+ *  require a scan, but the character masks reject most names without looking
+ *  at them.
+ */
+static int completeIndexed (tagCursor *const cursor, const char *const pattern,
+							const int options, tagCompletion *const list,
+							const int max)
+{
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
+	const size_t patternLength = strlen (pattern);
+	const unsigned long count = cursor->file->index.completion.count;
+	tagCompletion candidate;
+	tagCompletion dropped;
+	int found = 0;
+	if ((options & TAG_FUZZYMATCH) != 0)
+	{
+		unsigned char mask [INDEX_MASK_SIZE];
+		unsigned long i;
+		patternMask (pattern, mask);
+		for (i = 0  ;  i < count  ;  ++i)
+		{
+			const unsigned char *const record =
+					cursor->file->index.completion.data + i * INDEX_COMPLETION_SIZE;
+			int j;
+			for (j = 0  ;  j < INDEX_MASK_SIZE  ;  ++j)
+				if ((record [j] & mask [j]) != mask [j])
+					break;
+			if (j == INDEX_MASK_SIZE)
+			{
+				candidate.name = completionName (cursor->file, i);
+				if (fuzzyMatch (pattern, candidate.name,
+								strlen (candidate.name), ignorecase,
+								&candidate.score))
+				{
+					addCandidate (list, &found, max, &candidate, &dropped);
+				}
+			}
+		}
+	}
+	else
+	{
+		unsigned long lower = 0;
+		unsigned long upper = count;
+		while (lower < upper)
+		{
+			const unsigned long middle = lower + (upper - lower) / 2;
+			const char *const name = completionName (cursor->file, middle);
+			size_t i;
+			int comparison = 0;
+			for (i = 0  ;  comparison == 0  &&  i < patternLength  ;  ++i)
+			{
+				comparison = toupper ((int) name [i]) - toupper ((int) pattern [i]);
+				if (name [i] == '\0')
+					break;
+			}
+			if (comparison < 0)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+		candidate.score = 0;
+		for (  ;  lower < count  &&  found < max  ;  ++lower)
+		{
+			candidate.name = completionName (cursor->file, lower);
+			if (! isPrefix (pattern, patternLength, candidate.name,
+							strlen (candidate.name), 1))
+				break;
+			if (ignorecase  ||  isPrefix (pattern, patternLength, candidate.name,
+										  strlen (candidate.name), 0))
+				list [found++] = candidate;
+		}
+	}
+	return found;
+}
+
+/*  Completes `pattern' by reading every tag in the file. The names of the
+ *  candidates are copied, and kept until the next completion.
+ */
+static int completeSequential (tagCursor *const cursor, const char *const pattern,
+							   const int options, tagCompletion *const list,
+							   const int max)
+{
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
+	const int fuzzy = (options & TAG_FUZZYMATCH) != 0;
+	const size_t patternLength = strlen (pattern);
+	tagCompletion candidate;
+	tagCompletion dropped;
+	int found = 0;
+	int i;
+	gotoFirstLogicalTag (cursor);
+	while (readTagLine (cursor))
+	{
+		const char *const name = cursor->tag.buffer;
+		const size_t length = cursor->tag.length;
+		int matched;
+		candidate.score = 0;
+		if (fuzzy)
+			matched = fuzzyMatch (pattern, name, length, ignorecase,
+								  &candidate.score);
+		else
+			matched = isPrefix (pattern, patternLength, name, length, ignorecase);
+		if (matched)
+		{
+			/*  make the name null terminated if it lies within the mapping */
+			if (name != cursor->name.buffer)
+			{
+				while (length >= cursor->name.size)
+					growString (&cursor->name);
+				memcpy (cursor->name.buffer, name, length);
+				cursor->name.buffer [length] = '\0';
+			}
+			candidate.name = cursor->name.buffer;
+			i = addCandidate (list, &found, max, &candidate, &dropped);
+			if (i >= 0)
+				list [i].name = duplicate (cursor->name.buffer);
+			if (dropped.name != NULL)
+				free ((char *) dropped.name);
+		}
+	}
+	cursor->completion.list = (char **) malloc (
+			(size_t) (found > 0 ? found : 1) * sizeof (char *));
+	if (cursor->completion.list == NULL)
+		perror (NULL);
+	else
+	{
+		for (i = 0  ;  i < found  ;  ++i)
+			cursor->completion.list [i] = (char *) list [i].name;
+		cursor->completion.count = found;
+	}
+	return found;
+}
+
+static int complete (tagCursor *const cursor, const char *const pattern,
+					 const int options, tagCompletion *const list,
+					 const int max)
+{
+	int result;
+	freeCompletions (cursor);
+	refresh (cursor);
+	if (cursor->file->index.completion.data != NULL)
+		result = completeIndexed (cursor, pattern, options, list, max);
+	else
+		result = completeSequential (cursor, pattern, options, list, max);
+	return result;
+}
+
+/*  A name looked up by tagsFindMany (), with its position in the caller's
+ *  list.
+ */
+typedef struct {
+	const char *name;
+	int which;
+} batchName;
+
+/*  Compares names looked up together as nameComparison () orders them.
+ */
+static int compareBatchNames (const void *const one, const void *const two)
+{
+	const batchName *const a = (const batchName *) one;
+	const batchName *const b = (const batchName *) two;
+	int result = strcmp (a->name, b->name);
+	if (result == 0)
+		result = a->which - b->which;
+	return result;
+}
+
+static int compareBatchNamesFolded (const void *const one, const void *const two)
+{
+	const batchName *const a = (const batchName *) one;
+	const batchName *const b = (const batchName *) two;
+	int result = compareNames (a->name, b->name);
+	if (result == 0)
+		result = a->which - b->which;
+	return result;
+}
+
+/*  Compares `name' against the first `length' characters of `tag', observing
+ *  case only if not ignoring it.
+ */
+static int compareToTag (const char *const name, const char *const tag,
+						 const size_t length, const int ignorecase)
+{
+	int result = 0;
+	size_t i;
+	for (i = 0  ;  result == 0  &&  i <= length  ;  ++i)
+	{
+		const int c = (i < length) ? tag [i] : '\0';
+		if (ignorecase)
+			result = toupper ((int) name [i]) - toupper (c);
+		else
+			result = (int) (unsigned char) name [i] - (int) (unsigned char) c;
+		if (name [i] == '\0')
+			break;
+	}
+	return result;
+}
+
+/*  Returns the end of the group of names matching the same tags as the name
+ *  at `first'.
+ */
+static int batchGroupEnd (const batchName *const batch, const int first,
+						  const int count, const int ignorecase)
+{
+	const char *const name = batch [first].name;
+	int last = first + 1;
+	while (last < count  &&  compareToTag (batch [last].name, name,
+										   strlen (name), ignorecase) == 0)
+		++last;
+	return last;
+}
+
+/*  Reports `entry' as a match for each name of a group. Returns zero if the
+ *  caller asked to stop.
+ */
+static int reportBatch (const tagEntry *const entry,
+						const batchName *const batch,
+						const int first, const int last,
+						tagFoundFunction callback, void *const data)
+{
+	int proceed = 1;
+	int i;
+	for (i = first  ;  proceed  &&  i < last  ;  ++i)
+		proceed = callback (entry, batch [i].which, data);
+	return proceed;
+}
+
+/*  Looks up each group of names by a binary search which starts from the
+ *  first match (or insertion point) of the group before it.
+ */
+static int findManySorted (tagCursor *const cursor, const batchName *const batch,
+						   const int count, const int options,
+						   tagFoundFunction callback, void *const data)
+{
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
+	unsigned long indexLower = 0;
+	off_t lower = 0;
+	int proceed = 1;
+	int found = 0;
+	int first = 0;
+	tagEntry entry;
+	while (proceed  &&  first < count)
+	{
+		const int last = batchGroupEnd (batch, first, count, ignorecase);
+		tagResult result;
+		setSearch (cursor, batch [first].name, options);
+		if (cursor->search.section != NULL)
+		{
+			result = findIndexed (cursor, indexLower);
+			indexLower = cursor->search.indexPos;
+		}
+		else
+		{
+			result = findBinary (cursor, lower);
+			if (result == TagSuccess  &&  cursor->pos > 0)
+				lower = cursor->pos - 1;
+		}
+		if (result == TagSuccess)
+		{
+			found += last - first;
+			do
+			{
+				parseTagLine (cursor, &entry);
+				proceed = reportBatch (&entry, batch, first, last,
+									   callback, data);
+			} while (proceed  &&  findNext (cursor, NULL) == TagSuccess);
+		}
+		first = last;
+	}
+	return found;
+}
+
+/*  Looks up all names in a single pass through the tag file, searching the
+ *  sorted names for the name of each tag (or, for partial matches, for each
+ *  of its leading substrings).
+ */
+static int findManySequential (tagCursor *const cursor, const batchName *const batch,
+							   const int count, const int options,
+							   tagFoundFunction callback, void *const data)
+{
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
+	const int partial = (options & TAG_PARTIALMATCH) != 0;
+	char *const matched = (char *) calloc ((size_t) count, (size_t) 1);
+	size_t shortest = (size_t) -1;
+	size_t longest = 0;
+	int proceed = 1;
+	int found = 0;
+	int i;
+	tagEntry entry;
+	if (matched == NULL)
+	{
+		perror (NULL);
+		proceed = 0;
+	}
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		const size_t length = strlen (batch [i].name);
+		if (length < shortest)
+			shortest = length;
+		if (length > longest)
+			longest = length;
+	}
+	gotoFirstLogicalTag (cursor);
+	while (proceed  &&  readTagLine (cursor))
+	{
+		int parsed = 0;
+		const size_t tagLength = cursor->tag.length;
+		size_t length = partial ? shortest : tagLength;
+		const size_t end = partial ?
+				(tagLength < longest ? tagLength : longest) : tagLength;
+		for (  ;  proceed  &&  length <= end  ;  ++length)
+		{
+			int lower = 0;
+			int upper = count;
+			while (lower < upper)
+			{
+				const int middle = lower + (upper - lower) / 2;
+				if (compareToTag (batch [middle].name, cursor->tag.buffer,
+								  length, ignorecase) < 0)
+					lower = middle + 1;
+				else
+					upper = middle;
+			}
+			if (lower < count  &&  compareToTag (batch [lower].name,
+					cursor->tag.buffer, length, ignorecase) == 0)
+			{
+				const int last = batchGroupEnd (batch, lower, count, ignorecase);
+				for (i = lower  ;  i < last  ;  ++i)
+				{
+					if (! matched [i])
+						++found;
+					matched [i] = 1;
+				}
+				if (! parsed)
+					parseTagLine (cursor, &entry);
+				parsed = 1;
+				proceed = reportBatch (&entry, batch, lower, last,
+									   callback, data);
+			}
+		}
+	}
+	free (matched);
+	return found;
+}
+
+static int findMany (tagCursor *const cursor, const char *const *const names,
+					 const int count, const int options,
+					 tagFoundFunction callback, void *const data)
+{
+	const int ignorecase = (options & TAG_IGNORECASE) != 0;
+	batchName *const batch = (batchName *) malloc (
+			(size_t) (count > 0 ? count : 1) * sizeof (batchName));
+	int found = 0;
+	int i;
+	if (batch == NULL)
+		perror (NULL);
+	else
+	{
+		for (i = 0  ;  i < count  ;  ++i)
+		{
+			batch [i].name = names [i];
+			batch [i].which = i;
+		}
+		qsort (batch, (size_t) count, sizeof (batchName),
+			   ignorecase ? compareBatchNamesFolded : compareBatchNames);
+		setSearch (cursor, "", options);
+		refresh (cursor);
+		seekTagFile (cursor, 0);
+		cursor->search.section = NULL;
+		if (cursor->file->index.data != NULL)
+		{
+			cursor->search.section = ignorecase ?
+					&cursor->file->index.folded : &cursor->file->index.name;
+			found = findManySorted (cursor, batch, count, options, callback, data);
+		}
+		else if (isBinarySearchable (cursor))
+			found = findManySorted (cursor, batch, count, options, callback, data);
+		else
+			found = findManySequential (cursor, batch, count, options,
+										callback, data);
+		free (batch);
+	}
+	return found;
+}
+
+/*  Compares `sourceFile' against the source file of the tag line last read,
+ *  which is parsed into `entry'.
+ */
+static int fileComparison (tagCursor *const cursor,
+						   const char *const sourceFile, tagEntry *const entry)
+{
+	parseTagLine (cursor, entry);
+	return strcmp (sourceFile, entry->file);
+}
+
+/*  Returns the scope of a tag: the value of the first of its extension
+ *  fields not among NonScopeKeys, or null if it has none.
+ */
+static const char *scopeOf (const tagEntry *const entry)
+{
+	const char *result = NULL;
+	unsigned int i;
+	unsigned int j;
+	for (i = 0  ;  result == NULL  &&  i < entry->fields.count  ;  ++i)
+	{
+		const char *const key = entry->fields.list [i].key;
+		for (j = 0  ;  j < sizeof (NonScopeKeys) / sizeof (NonScopeKeys [0])  ;  ++j)
+			if (strcmp (key, NonScopeKeys [j]) == 0)
+				break;
+		if (j == sizeof (NonScopeKeys) / sizeof (NonScopeKeys [0]))
+			result = entry->fields.list [i].value;
+	}
+	return result;
+}
+
+/*  Compares `scope' against the scope of the tag line last read, which is
+ *  parsed into `entry'. A tag without a scope follows every scope.
+ */
+static int scopeComparison (tagCursor *const cursor,
+							const char *const scope, tagEntry *const entry)
+{
+	const char *tagScope;
+	parseTagLine (cursor, entry);
+	tagScope = scopeOf (entry);
+	return (tagScope == NULL) ? -1 : strcmp (scope, tagScope);
+}
+
+/*  Reports each tag for which `comparison' finds `value' equal to the
+ *  corresponding value of the tag. With an index, the tags are found by
+ *  binary search of `section', which lists tags in order of that value;
+ *  otherwise every tag in the file is read.
+ */
+static int findByValue (tagCursor *const cursor, const char *const value,
+		int (*comparison) (tagCursor *, const char *, tagEntry *),
+		const indexSection *const section,
+		tagFoundFunction callback, void *const data)
+{
+	int proceed = 1;
+	int found = 0;
+	tagEntry entry;
+	if (section->data != NULL)
+	{
+		unsigned long lower = 0;
+		unsigned long upper = section->count;
+		unsigned long i;
+		while (lower < upper)
+		{
+			const unsigned long middle = lower + (upper - lower) / 2;
+			if (readIndexedLine (cursor, section, middle)  &&
+				comparison (cursor, value, &entry) > 0)
+				lower = middle + 1;
+			else
+				upper = middle;
+		}
+		for (i = lower  ;  proceed  &&  i < section->count  ;  ++i)
+		{
+			if (! readIndexedLine (cursor, section, i)  ||
+				comparison (cursor, value, &entry) != 0)
+			{
+				break;
+			}
+			++found;
+			proceed = callback (&entry, 0, data);
+		}
+	}
+	else
+	{
+		gotoFirstLogicalTag (cursor);
+		while (proceed  &&  readTagLine (cursor))
+		{
+			if (comparison (cursor, value, &entry) == 0)
+			{
+				++found;
+				proceed = callback (&entry, 0, data);
+			}
+		}
+	}
+	return found;
+}
+
+/*  Reports each tag defined in the source file `sourceFile', or in the scope
+ *  `scope', as named in the tag file.
+ */
+static int findByFile (tagCursor *const cursor, const char *const sourceFile,
+					   tagFoundFunction callback, void *const data)
+{
+	setSearch (cursor, "", 0);
+	refresh (cursor);
+	cursor->search.section = NULL;
+	return findByValue (cursor, sourceFile, fileComparison,
+						&cursor->file->index.file, callback, data);
+}
+
+static int findByScope (tagCursor *const cursor, const char *const scope,
+						tagFoundFunction callback, void *const data)
+{
+	setSearch (cursor, "", 0);
+	refresh (cursor);
+	cursor->search.section = NULL;
+	return findByValue (cursor, scope, scopeComparison,
+						&cursor->file->index.scope, callback, data);
+}
+
+/*  Returns the cursor of the tag file itself, used by the functions taking
+ *  a tag file rather than a cursor.
+ */
+static tagCursor *fileCursor (tagFile *const file)
+{
+	tagCursor *result = NULL;
+	if (file != NULL  &&  file->initialized)
+		result = &file->cursor;
+	return result;
+}
+
+/*  Adds a tag file to a tag set, without opening it.
+ */
+static tagResult addMember (tagSet *const set, const char *const path)
+{
+	tagResult result = TagFailure;
+	if (set->count == set->max)
+	{
+		const int max = set->max + 16;
+		tagSetMember *const members = (tagSetMember *) realloc (set->members,
+				(size_t) max * sizeof (tagSetMember));
+		if (members == NULL)
+			perror (NULL);
+		else
+		{
+			set->members = members;
+			set->max = max;
+		}
+	}
+	if (set->count < set->max)
+	{
+		tagSetMember *const member = &set->members [set->count];
+		memset (member, 0, sizeof (tagSetMember));
+		member->path = duplicate (path);
+		if (member->path != NULL)
+		{
+			++set->count;
+			result = TagSuccess;
+		}
+	}
+	return result;
+}
+
+/*  Adds the tag files named by the lines of `manifest'. Names not beginning
+ *  with '/' are taken relative to the directory holding the manifest.
+ */
+static int addManifest (tagSet *const set, const char *const manifest)
+{
+	FILE *const fp = fopen (manifest, "r");
+	const char *const slash = strrchr (manifest, '/');
+	const size_t directoryLength = (slash == NULL) ? 0 :
+			(size_t) (slash - manifest) + 1;
+	vstring path;
+	int added = 0;
+	int c = EOF;
+	if (fp == NULL)
+		return -1;
+	path.size = 0;
+	path.buffer = NULL;
+	do
+	{
+		size_t length = 0;
+		c = getc (fp);
+		if (c != '/'  &&  c != '\n'  &&  c != EOF)
+			length = directoryLength;
+		while (length >= path.size)
+			if (! growString (&path))
+				break;
+		if (path.buffer == NULL)
+			break;
+		memcpy (path.buffer, manifest, length);
+		for (  ;  c != '\n'  &&  c != EOF  ;  c = getc (fp))
+		{
+			if (length + 1 >= path.size  &&  ! growString (&path))
+				break;
+			path.buffer [length++] = (char) c;
+		}
+		while (length > 0  &&  isspace ((int) (unsigned char)
+										path.buffer [length - 1]))
+			--length;
+		path.buffer [length] = '\0';
+		if (length > directoryLength  ||
+			(length > 0  &&  path.buffer [0] == '/'))
+		{
+			const char *const name = path.buffer +
+					(path.buffer [0] == '/' ? 0 : directoryLength);
+			if (name [0] != '#'  &&  addMember (set, path.buffer) == TagSuccess)
+				++added;
+		}
+	} while (c != EOF);
+	free (path.buffer);
+	fclose (fp);
+	return added;
+}
+
+/*  Adds the tag files matching the shell pattern `pattern', in order of
+ *  name.
+ */
+static int addGlob (tagSet *const set, const char *const pattern)
+{
+	int added = -1;
+#ifdef HAVE_GLOB_H
+	glob_t matches;
+	const int status = glob (pattern, 0, NULL, &matches);
+	if (status == GLOB_NOMATCH)
+		added = 0;
+	else if (status == 0)
+	{
+		size_t i;
+		added = 0;
+		for (i = 0  ;  i < matches.gl_pathc  ;  ++i)
+			if (addMember (set, matches.gl_pathv [i]) == TagSuccess)
+				++added;
+		globfree (&matches);
+	}
+#else
+	(void) set;
+	(void) pattern;
+#endif
+	return added;
+}
+
+/*  Opens the tag file of a member of a tag set if not yet open.
+ */
+static tagFile *openMember (tagSetMember *const member)
+{
+	if (member->file == NULL)
+	{
+		tagFileInfo info;
+		struct stat status;
+		member->file = tagsOpen (member->path, &info);
+		if (member->file != NULL  &&
+			fstat (fileno (member->file->fp), &status) == 0)
+		{
+			member->device = status.st_dev;
+			member->inode = status.st_ino;
+			member->size = status.st_size;
+			member->mtime = status.st_mtime;
+			member->mtimeNanoseconds = mtimeNanoseconds (&status);
+		}
+	}
+	return member->file;
+}
+
+/*  Determines whether the tag file of a member of a tag set has been
+ *  replaced or changed since it was opened.
+ */
+static int isStaleMember (const tagSetMember *const member)
+{
+	struct stat status;
+	return (stat (member->path, &status) != 0  ||
+			member->device != status.st_dev  ||
+			member->inode != status.st_ino  ||
+			member->size != status.st_size  ||
+			member->mtime != status.st_mtime  ||
+			member->mtimeNanoseconds != mtimeNanoseconds (&status));
+}
+
+/*  Begins the search of every `step'th tag file of a tag set, starting with
+ *  the tag file at `first'.
+ */
+typedef struct {
+	tagSet *set;
+	int first;
+	int step;
+} setSearchWork;
+
+static void *searchMembers (void *const arg)
+{
+	const setSearchWork *const work = (const setSearchWork *) arg;
+	tagSet *const set = work->set;
+	int i;
+	for (i = work->first  ;  i < set->count  ;  i += work->step)
+	{
+		tagSetMember *const member = &set->members [i];
+		member->found = TagFailure;
+		if (openMember (member) != NULL)
+			member->found = tagsFind (member->file, &member->entry,
+									  set->name, set->options);
+	}
+	return NULL;
+}
+
+/*  Begins the search of each tag file of a tag set. Each tag file is read
+ *  by only one thread, so the threads share nothing but the set itself,
+ *  which they do not change.
+ */
+static void searchSet (tagSet *const set)
+{
+	setSearchWork work [SET_THREADS];
+	int threads = (set->count < SET_THREADS) ? set->count : SET_THREADS;
+	int t;
+#ifdef USE_THREADS
+	pthread_t thread [SET_THREADS];
+	int started [SET_THREADS];
+#else
+	threads = 1;
+#endif
+	for (t = 0  ;  t < threads  ;  ++t)
+	{
+		work [t].set = set;
+		work [t].first = t;
+		work [t].step = threads;
+	}
+#ifdef USE_THREADS
+	for (t = 1  ;  t < threads  ;  ++t)
+	{
+		started [t] = (pthread_create (&thread [t], NULL,
+									   searchMembers, &work [t]) == 0);
+		if (! started [t])
+			searchMembers (&work [t]);
+	}
+#endif
+	if (threads > 0)
+		searchMembers (&work [0]);
+#ifdef USE_THREADS
+	for (t = 1  ;  t < threads  ;  ++t)
+		if (started [t])
+			pthread_join (thread [t], NULL);
+#endif
+}
+
+/*  Orders the current tags of two tag files of a tag set by name, as
+ *  tagsFind () returns them, then by position of the tag file in the set.
+ */
+static int compareMembers (const tagSet *const set, const int a, const int b)
+{
+	const char *const nameA = set->members [a].entry.name;
+	const char *const nameB = set->members [b].entry.name;
+	int result;
+	if (set->options & TAG_IGNORECASE)
+		result = compareNames (nameA, nameB);
+	else
+		result = strcmp (nameA, nameB);
+	if (result == 0)
+		result = a - b;
+	return result;
+}
+
+/*  Restores the order of a heap of tag files whose first entry may be out
+ *  of place.
+ */
+static void siftDown (const tagSet *const set, int *const heap, const int size)
+{
+	int i = 0;
+	while (1)
+	{
+		const int left = 2 * i + 1;
+		const int right = left + 1;
+		int least = i;
+		int swap;
+		if (left < size  &&  compareMembers (set, heap [left], heap [least]) < 0)
+			least = left;
+		if (right < size  &&  compareMembers (set, heap [right], heap [least]) < 0)
+			least = right;
+		if (least == i)
+			break;
+		swap = heap [i];
+		heap [i] = heap [least];
+		heap [least] = swap;
+		i = least;
+	}
+}
+
+/*  Searches every tag file of a set, then merges the matches of each tag
+ *  file, keeping those of each tag file in a heap ordered by its next match.
+ */
+static int findInSet (tagSet *const set, const char *const name,
+					  const int options, tagFoundFunction callback,
+					  void *const data)
+{
+	int *const heap = (int *) malloc (
+			(size_t) (set->count > 0 ? set->count : 1) * sizeof (int));
+	int size = 0;
+	int found = 0;
+	int proceed = 1;
+	int i;
+	if (heap == NULL)
+	{
+		perror (NULL);
+		return 0;
+	}
+	set->name = name;
+	set->options = options;
+	searchSet (set);
+	for (i = 0  ;  i < set->count  ;  ++i)
+	{
+		if (set->members [i].found == TagSuccess)
+		{
+			int j = size++;
+			/*  sift up  */
+			while (j > 0  &&  compareMembers (set, i, heap [(j - 1) / 2]) < 0)
+			{
+				heap [j] = heap [(j - 1) / 2];
+				j = (j - 1) / 2;
+			}
+			heap [j] = i;
+		}
+	}
+	while (proceed  &&  size > 0)
+	{
+		tagSetMember *const member = &set->members [heap [0]];
+		++found;
+		proceed = callback (&member->entry, heap [0], data);
+		if (proceed  &&  tagsFindNext (member->file, &member->entry) != TagSuccess)
+			heap [0] = heap [--size];
+		siftDown (set, heap, size);
+	}
+	free (heap);
+	set->name = NULL;
+	return found;
+}
+
+/*
+*  EXTERNAL INTERFACE
 */
 
 extern tagFile *tagsOpen (const char *const filePath, tagFileInfo *const info)
@@ -727,21 +2846,12 @@ extern tagResult tagsSetSortType (tagFile *const file, const sortType type)
 
 extern tagResult tagsFirst (tagFile *const file, tagEntry *const entry)
 {
-	tagResult result = TagFailure;
-	if (file != NULL  &&  file->initialized)
-	{
-		gotoFirstLogicalTag (file);
-		result = readNext (file, entry);
-	}
-	return result;
+	return tagsCursorFirst (fileCursor (file), entry);
 }
 
 extern tagResult tagsNext (tagFile *const file, tagEntry *const entry)
 {
-	tagResult result = TagFailure;
-	if (file != NULL  &&  file->initialized)
-		result = readNext (file, entry);
-	return result;
+	return tagsCursorNext (fileCursor (file), entry);
 }
 
 extern const char *tagsField (const tagEntry *const entry, const char *const key)
@@ -755,17 +2865,137 @@ extern const char *tagsField (const tagEntry *const entry, const char *const key
 extern tagResult tagsFind (tagFile *const file, tagEntry *const entry,
 						   const char *const name, const int options)
 {
-	tagResult result = TagFailure;
+	return tagsCursorFind (fileCursor (file), entry, name, options);
+}
+
+extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry)
+{
+	return tagsCursorFindNext (fileCursor (file), entry);
+}
+
+extern int tagsFindMany (tagFile *const file, const char *const *const names,
+						 const int count, const int options,
+						 tagFoundFunction callback, void *const data)
+{
+	return tagsCursorFindMany (fileCursor (file), names, count, options,
+							   callback, data);
+}
+
+extern int tagsFindByFile (tagFile *const file, const char *const sourceFile,
+						  tagFoundFunction callback, void *const data)
+{
+	return tagsCursorFindByFile (fileCursor (file), sourceFile, callback, data);
+}
+
+extern int tagsFindByScope (tagFile *const file, const char *const scope,
+							tagFoundFunction callback, void *const data)
+{
+	return tagsCursorFindByScope (fileCursor (file), scope, callback, data);
+}
+
+extern int tagsComplete (tagFile *const file, const char *const pattern,
+						 const int options, tagCompletion *const candidates,
+						 const int max)
+{
+	return tagsCursorComplete (fileCursor (file), pattern, options,
+							   candidates, max);
+}
+
+extern tagCursor *tagsCursorNew (tagFile *const file)
+{
+	tagCursor *result = NULL;
 	if (file != NULL  &&  file->initialized)
-		result = find (file, entry, name, options);
+		result = newCursor (file);
 	return result;
 }
 
-extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry)
+extern tagResult tagsCursorFirst (tagCursor *const cursor, tagEntry *const entry)
 {
 	tagResult result = TagFailure;
-	if (file != NULL  &&  file->initialized)
-		result = findNext (file, entry);
+	if (cursor != NULL)
+	{
+		gotoFirstLogicalTag (cursor);
+		result = readNext (cursor, entry);
+	}
+	return result;
+}
+
+extern tagResult tagsCursorNext (tagCursor *const cursor, tagEntry *const entry)
+{
+	tagResult result = TagFailure;
+	if (cursor != NULL)
+		result = readNext (cursor, entry);
+	return result;
+}
+
+extern tagResult tagsCursorFind (tagCursor *const cursor, tagEntry *const entry,
+								 const char *const name, const int options)
+{
+	tagResult result = TagFailure;
+	if (cursor != NULL)
+		result = find (cursor, entry, name, options);
+	return result;
+}
+
+extern tagResult tagsCursorFindNext (tagCursor *const cursor,
+									 tagEntry *const entry)
+{
+	tagResult result = TagFailure;
+	if (cursor != NULL)
+		result = findNext (cursor, entry);
+	return result;
+}
+
+extern int tagsCursorFindMany (tagCursor *const cursor,
+							   const char *const *const names,
+							   const int count, const int options,
+							   tagFoundFunction callback, void *const data)
+{
+	int result = 0;
+	if (cursor != NULL  &&  names != NULL  &&  callback != NULL)
+		result = findMany (cursor, names, count, options, callback, data);
+	return result;
+}
+
+extern int tagsCursorFindByFile (tagCursor *const cursor,
+								 const char *const sourceFile,
+								 tagFoundFunction callback, void *const data)
+{
+	int result = 0;
+	if (cursor != NULL  &&  sourceFile != NULL  &&  callback != NULL)
+		result = findByFile (cursor, sourceFile, callback, data);
+	return result;
+}
+
+extern int tagsCursorFindByScope (tagCursor *const cursor,
+								  const char *const scope,
+								  tagFoundFunction callback, void *const data)
+{
+	int result = 0;
+	if (cursor != NULL  &&  scope != NULL  &&  callback != NULL)
+		result = findByScope (cursor, scope, callback, data);
+	return result;
+}
+
+extern int tagsCursorComplete (tagCursor *const cursor,
+							   const char *const pattern, const int options,
+							   tagCompletion *const candidates, const int max)
+{
+	int result = 0;
+	if (cursor != NULL  &&  pattern != NULL)
+		result = complete (cursor, pattern, options, candidates, max);
+	return result;
+}
+
+extern tagResult tagsCursorDelete (tagCursor *const cursor)
+{
+	tagResult result = TagFailure;
+	if (cursor != NULL  &&  cursor != &cursor->file->cursor)
+	{
+		terminateCursor (cursor);
+		free (cursor);
+		result = TagSuccess;
+	}
 	return result;
 }
 
@@ -780,17 +3010,187 @@ extern tagResult tagsClose (tagFile *const file)
 	return result;
 }
 
+extern tagSet *tagsSetNew (void)
+{
+	tagSet *const result = (tagSet *) calloc ((size_t) 1, sizeof (tagSet));
+	if (result == NULL)
+		perror (NULL);
+	return result;
+}
+
+extern tagResult tagsSetAdd (tagSet *const set, const char *const filePath)
+{
+	tagResult result = TagFailure;
+	if (set != NULL  &&  filePath != NULL)
+		result = addMember (set, filePath);
+	return result;
+}
+
+extern int tagsSetAddManifest (tagSet *const set, const char *const manifest)
+{
+	int result = -1;
+	if (set != NULL  &&  manifest != NULL)
+		result = addManifest (set, manifest);
+	return result;
+}
+
+extern int tagsSetAddGlob (tagSet *const set, const char *const pattern)
+{
+	int result = -1;
+	if (set != NULL  &&  pattern != NULL)
+		result = addGlob (set, pattern);
+	return result;
+}
+
+extern const char *tagsSetPath (const tagSet *const set, const int which)
+{
+	const char *result = NULL;
+	if (set != NULL  &&  which >= 0  &&  which < set->count)
+		result = set->members [which].path;
+	return result;
+}
+
+extern tagFile *tagsSetFile (tagSet *const set, const int which)
+{
+	tagFile *result = NULL;
+	if (set != NULL  &&  which >= 0  &&  which < set->count)
+		result = openMember (&set->members [which]);
+	return result;
+}
+
+extern int tagsSetFind (tagSet *const set, const char *const name,
+						const int options, tagFoundFunction callback,
+						void *const data)
+{
+	int result = 0;
+	if (set != NULL  &&  name != NULL  &&  callback != NULL)
+		result = findInSet (set, name, options, callback, data);
+	return result;
+}
+
+extern int tagsSetRefresh (tagSet *const set)
+{
+	int closed = 0;
+	if (set != NULL)
+	{
+		int i;
+		for (i = 0  ;  i < set->count  ;  ++i)
+		{
+			tagSetMember *const member = &set->members [i];
+			if (member->file != NULL  &&  isStaleMember (member))
+			{
+				tagsClose (member->file);
+				member->file = NULL;
+				++closed;
+			}
+		}
+	}
+	return closed;
+}
+
+extern tagResult tagsSetClose (tagSet *const set)
+{
+	tagResult result = TagFailure;
+	if (set != NULL)
+	{
+		int i;
+		for (i = 0  ;  i < set->count  ;  ++i)
+		{
+			if (set->members [i].file != NULL)
+				tagsClose (set->members [i].file);
+			free (set->members [i].path);
+		}
+		free (set->members);
+		free (set);
+		result = TagSuccess;
+	}
+	return result;
+}
+
 /*
 *  TEST FRAMEWORK
 */
 
 #ifdef READTAGS_MAIN
 
+/*  A tag file held open between queries in server mode.
+ */
+typedef struct sOpenTagFile {
+	char *path;
+	tagFile *file;
+		/* sort method recorded in the tag file, restored for each query */
+	sortType sortMethod;
+		/* identity of the tag file when opened, to detect its replacement */
+	dev_t device;
+	ino_t inode;
+	off_t size;
+	time_t mtime;
+	unsigned long mtimeNanoseconds;
+	struct sOpenTagFile *next;
+} openTagFile;
+
+/*  The settings of a query, which each query of a server begins with as
+ *  they were given on the command line.
+ */
+typedef struct {
+	const char *tagFileName;
+	const char *tagSetName;
+	int tagSetGlob;
+	int options;
+	int extensionFields;
+	int sortOverride;
+	sortType sortMethod;
+	int complete;
+	int batch;
+	int bySourceFile;
+	int byScope;
+	int completionLimit;
+} querySettings;
+
 static const char *TagFileName = "tags";
+static const char *TagSetName;
+static int TagSetGlob;
 static const char *ProgramName;
 static int extensionFields;
 static int SortOverride;
 static sortType SortMethod;
+static int Complete;
+static int Batch;
+static int BySourceFile;
+static int ByScope;
+static int CompletionLimit = 20;
+static FILE *Output;
+static int Serving;
+static int Failed;
+static querySettings ServerSettings;
+static openTagFile *OpenTagFiles;
+static tagSet *OpenTagSet;
+static char *OpenTagSetName;
+static int OpenTagSetGlob;
+
+/*  Reports an error. This ends the program, unless serving queries, when it
+ *  ends only the query, and is reported to the client.
+ */
+static void fail (const char *const format, ...)
+{
+	va_list ap;
+	va_start (ap, format);
+	if (Serving)
+	{
+		fputs ("!_ERROR\t", Output);
+		vfprintf (Output, format, ap);
+		putc ('\n', Output);
+		Failed = 1;
+	}
+	else
+	{
+		fprintf (stderr, "%s: ", ProgramName);
+		vfprintf (stderr, format, ap);
+		putc ('\n', stderr);
+		exit (1);
+	}
+	va_end (ap);
+}
 
 static void printTag (const tagEntry *entry)
 {
@@ -800,114 +3200,422 @@ static void printTag (const tagEntry *entry)
 	const char* const empty = "";
 /* "sep" returns a value only the first time it is evaluated */
 #define sep (first ? (first = 0, separator) : empty)
-	printf ("%s\t%s\t%s",
+	fprintf (Output, "%s\t%s\t%s",
 		entry->name, entry->file, entry->address.pattern);
 	if (extensionFields)
 	{
 		if (entry->kind != NULL  &&  entry->kind [0] != '\0')
-			printf ("%s\tkind:%s", sep, entry->kind);
+			fprintf (Output, "%s\tkind:%s", sep, entry->kind);
 		if (entry->fileScope)
-			printf ("%s\tfile:", sep);
+			fprintf (Output, "%s\tfile:", sep);
 #if 0
 		if (entry->address.lineNumber > 0)
-			printf ("%s\tline:%lu", sep, entry->address.lineNumber);
+			fprintf (Output, "%s\tline:%lu", sep, entry->address.lineNumber);
 #endif
 		for (i = 0  ;  i < entry->fields.count  ;  ++i)
-			printf ("%s\t%s:%s", sep, entry->fields.list [i].key,
+			fprintf (Output, "%s\t%s:%s", sep, entry->fields.list [i].key,
 				entry->fields.list [i].value);
 	}
-	putchar ('\n');
+	putc ('\n', Output);
 #undef sep
 }
 
-static void findTag (const char *const name, const int options)
+/*  Returns the tag file held open for TagFileName, opening it if it is not
+ *  yet open or has changed since it was opened.
+ */
+static tagFile *openServedTags (void)
 {
+	openTagFile *open;
+	struct stat status;
 	tagFileInfo info;
+	for (open = OpenTagFiles  ;  open != NULL  ;  open = open->next)
+		if (strcmp (open->path, TagFileName) == 0)
+			break;
+	if (stat (TagFileName, &status) != 0)
+	{
+		fail ("cannot open tag file: %s: %s", strerror (errno), TagFileName);
+		return NULL;
+	}
+	if (open == NULL)
+	{
+		open = (openTagFile *) calloc ((size_t) 1, sizeof (openTagFile));
+		if (open == NULL  ||  (open->path = duplicate (TagFileName)) == NULL)
+		{
+			free (open);
+			fail ("out of memory");
+			return NULL;
+		}
+		open->next = OpenTagFiles;
+		OpenTagFiles = open;
+	}
+	else if (open->file != NULL  &&  (open->device != status.st_dev  ||
+			 open->inode != status.st_ino  ||  open->size != status.st_size  ||
+			 open->mtime != status.st_mtime  ||
+			 open->mtimeNanoseconds != mtimeNanoseconds (&status)))
+	{
+		tagsClose (open->file);
+		open->file = NULL;
+	}
+	if (open->file != NULL)
+		tagsSetSortType (open->file, open->sortMethod);
+	else
+	{
+		open->file = tagsOpen (TagFileName, &info);
+		if (open->file == NULL)
+			fail ("cannot open tag file: %s: %s",
+				  strerror (info.status.error_number), TagFileName);
+		else
+		{
+			open->sortMethod = info.file.sort;
+			open->device = status.st_dev;
+			open->inode = status.st_ino;
+			open->size = status.st_size;
+			open->mtime = status.st_mtime;
+			open->mtimeNanoseconds = mtimeNanoseconds (&status);
+		}
+	}
+	return open->file;
+}
+
+static tagFile *openTags (void)
+{
+	tagFile *file;
+	if (Serving)
+		file = openServedTags ();
+	else
+	{
+		tagFileInfo info;
+		file = tagsOpen (TagFileName, &info);
+		if (file == NULL)
+			fail ("cannot open tag file: %s: %s",
+				  strerror (info.status.error_number), TagFileName);
+	}
+	if (file != NULL  &&  SortOverride)
+		tagsSetSortType (file, SortMethod);
+	return file;
+}
+
+/*  Closes a tag file, unless it is held open between queries.
+ */
+static void closeTags (tagFile *const file)
+{
+	if (! Serving)
+		tagsClose (file);
+}
+
+/*  Returns the tag set named by TagSetName, held open between queries in
+ *  server mode, less those of its tag files which have changed since they
+ *  were opened.
+ */
+static tagSet *openTagSet (void)
+{
+	tagSet *set;
+	int added;
+	if (OpenTagSet != NULL)
+	{
+		if (strcmp (OpenTagSetName, TagSetName) == 0  &&
+			OpenTagSetGlob == TagSetGlob)
+		{
+			tagsSetRefresh (OpenTagSet);
+			return OpenTagSet;
+		}
+		tagsSetClose (OpenTagSet);
+		free (OpenTagSetName);
+		OpenTagSet = NULL;
+		OpenTagSetName = NULL;
+	}
+	set = tagsSetNew ();
+	if (set == NULL)
+	{
+		fail ("out of memory");
+		return NULL;
+	}
+	if (TagSetGlob)
+		added = tagsSetAddGlob (set, TagSetName);
+	else
+		added = tagsSetAddManifest (set, TagSetName);
+	if (added < 0)
+	{
+		tagsSetClose (set);
+		if (TagSetGlob)
+			fail ("cannot expand tag file pattern: %s", TagSetName);
+		else
+			fail ("cannot open tag file list: %s: %s",
+				  strerror (errno), TagSetName);
+		return NULL;
+	}
+	if (Serving)
+	{
+		OpenTagSet = set;
+		OpenTagSetName = duplicate (TagSetName);
+		OpenTagSetGlob = TagSetGlob;
+		if (OpenTagSetName == NULL)
+		{
+			tagsSetClose (set);
+			OpenTagSet = NULL;
+			fail ("out of memory");
+			set = NULL;
+		}
+	}
+	return set;
+}
+
+/*  Closes a tag set, unless it is held open between queries.
+ */
+static void closeTagSet (tagSet *const set)
+{
+	if (! Serving)
+		tagsSetClose (set);
+}
+
+static int printFoundTag (const tagEntry *const entry, const int which,
+						  void *const data)
+{
+	(void) which;
+	(void) data;
+	printTag (entry);
+	return 1;
+}
+
+static void findTag (const char *const name, const int options)
+{
 	tagEntry entry;
-	tagFile *const file = tagsOpen (TagFileName, &info);
-	if (file == NULL)
+	if (TagSetName != NULL)
 	{
-		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
-				ProgramName, strerror (info.status.error_number), name);
-		exit (1);
+		tagSet *const set = openTagSet ();
+		if (set != NULL)
+		{
+			tagsSetFind (set, name, options, printFoundTag, NULL);
+			closeTagSet (set);
+		}
 	}
 	else
 	{
-		if (SortOverride)
-			tagsSetSortType (file, SortMethod);
-		if (tagsFind (file, &entry, name, options) == TagSuccess)
+		tagFile *const file = openTags ();
+		if (file != NULL)
 		{
-			do
+			if (tagsFind (file, &entry, name, options) == TagSuccess)
 			{
-				printTag (&entry);
-			} while (tagsFindNext (file, &entry) == TagSuccess);
+				do
+				{
+					printTag (&entry);
+				} while (tagsFindNext (file, &entry) == TagSuccess);
+			}
+			closeTags (file);
 		}
-		tagsClose (file);
+	}
+}
+
+static void findTags (const char *const *const names, const int count,
+					  const int options)
+{
+	if (TagSetName != NULL)
+	{
+		int i;
+		for (i = 0  ;  i < count  ;  ++i)
+			findTag (names [i], options);
+	}
+	else
+	{
+		tagFile *const file = openTags ();
+		if (file != NULL)
+		{
+			tagsFindMany (file, names, count, options, printFoundTag, NULL);
+			closeTags (file);
+		}
+	}
+}
+
+/*  Prints the tags of a source file or the members of a scope, using
+ *  tagsFindByFile () or tagsFindByScope ().
+ */
+static void findTagsBy (const char *const value,
+		int (*find) (tagFile *, const char *, tagFoundFunction, void *))
+{
+	if (TagSetName != NULL)
+	{
+		tagSet *const set = openTagSet ();
+		int i;
+		for (i = 0  ;  set != NULL  &&  tagsSetPath (set, i) != NULL  ;  ++i)
+		{
+			tagFile *const file = tagsSetFile (set, i);
+			if (file != NULL)
+				find (file, value, printFoundTag, NULL);
+		}
+		if (set != NULL)
+			closeTagSet (set);
+	}
+	else
+	{
+		tagFile *const file = openTags ();
+		if (file != NULL)
+		{
+			find (file, value, printFoundTag, NULL);
+			closeTags (file);
+		}
+	}
+}
+
+static void completeTag (const char *const pattern, const int options)
+{
+	tagFile *file;
+	if (TagSetName != NULL)
+	{
+		fail ("cannot complete names from a list of tag files");
+		return;
+	}
+	file = openTags ();
+	if (file != NULL)
+	{
+		tagCompletion *const candidates = (tagCompletion *) malloc (
+				(size_t) CompletionLimit * sizeof (tagCompletion));
+		if (candidates == NULL)
+			fail ("out of memory");
+		else
+		{
+			const int count = tagsComplete (file, pattern, options,
+											candidates, CompletionLimit);
+			int i;
+			for (i = 0  ;  i < count  ;  ++i)
+				fprintf (Output, "%s\n", candidates [i].name);
+			free (candidates);
+		}
+		closeTags (file);
 	}
 }
 
 static void listTags (void)
 {
-	tagFileInfo info;
 	tagEntry entry;
-	tagFile *const file = tagsOpen (TagFileName, &info);
-	if (file == NULL)
+	if (TagSetName != NULL)
 	{
-		fprintf (stderr, "%s: cannot open tag file: %s: %s\n",
-				ProgramName, strerror (info.status.error_number), TagFileName);
-		exit (1);
+		tagSet *const set = openTagSet ();
+		int i;
+		for (i = 0  ;  set != NULL  &&  tagsSetPath (set, i) != NULL  ;  ++i)
+		{
+			tagFile *const file = tagsSetFile (set, i);
+			if (file != NULL  &&  tagsFirst (file, &entry) == TagSuccess)
+			{
+				do
+				{
+					printTag (&entry);
+				} while (tagsNext (file, &entry) == TagSuccess);
+			}
+		}
+		if (set != NULL)
+			closeTagSet (set);
 	}
 	else
 	{
-		while (tagsNext (file, &entry) == TagSuccess)
-			printTag (&entry);
-		tagsClose (file);
+		tagFile *const file = openTags ();
+		if (file != NULL)
+		{
+			while (tagsNext (file, &entry) == TagSuccess)
+				printTag (&entry);
+			closeTags (file);
+		}
 	}
 }
 
 const char *const Usage =
 	"Find tag file entries matching specified names.\n\n"
-	"Usage: %s [-ilp] [-s[0|1]] [-t file] [name(s)]\n\n"
+	"Usage: %s [-cCefFilmp] [-s[0|1]] [-t file|-M list|-G pattern] [name(s)]\n"
+	"       %s [options] -S|-U socket\n\n"
 	"Options:\n"
+	"    -c[count]    Print names completing each name (default: 20 names).\n"
+	"    -C           Print the members of each named scope.\n"
 	"    -e           Include extension fields in output.\n"
+	"    -f           Perform fuzzy matching when completing names.\n"
+	"    -F           Print the tags defined in each named source file.\n"
 	"    -i           Perform case-insensitive matching.\n"
 	"    -l           List all tags.\n"
+	"    -m           Look up all remaining names at once.\n"
 	"    -p           Perform partial matching.\n"
 	"    -s[0|1|2]    Override sort detection of tag file.\n"
 	"    -t file      Use specified tag file (default: \"tags\").\n"
-	"Note that options are acted upon as encountered, so order is significant.\n";
+	"    -M list      Search each tag file named on a line of file list.\n"
+#ifdef HAVE_GLOB_H
+	"    -G pattern   Search each tag file matching the shell pattern.\n"
+#endif
+	"    -S           Answer queries read from standard input.\n"
+#ifdef USE_SOCKETS
+	"    -U socket    Answer queries from clients of a Unix domain socket.\n"
+#endif
+	"Note that options are acted upon as encountered, so order is significant.\n\n"
+	"Each line of a query holds options and names, separated by blanks, acted\n"
+	"upon as above after those preceding -S or -U. Its answer is followed by an\n"
+	"empty line, and begins with a line starting \"!_ERROR\" if it failed. Tag\n"
+	"files are kept open between queries, and opened again once changed.\n";
 
-extern int main (int argc, char **argv)
+static void usage (void)
 {
-	int options = 0;
-	int actionSupplied = 0;
-	int i;
-	ProgramName = argv [0];
-	if (argc == 1)
+	if (Serving)
+		fail ("invalid query");
+	else
 	{
-		fprintf (stderr, Usage, ProgramName);
+		fprintf (stderr, Usage, ProgramName, ProgramName);
 		exit (1);
 	}
-	for (i = 1  ;  i < argc  ;  ++i)
+}
+
+static void serve (FILE *const in);
+#ifdef USE_SOCKETS
+static void serveSocket (const char *const path);
+#endif
+
+/*  Acts upon a list of options and names, returning whether any action was
+ *  taken.
+ */
+static int processArguments (const int argc, char *const *const argv,
+							 int *const options)
+{
+	int actionSupplied = 0;
+	int i;
+	for (i = 0  ;  i < argc  &&  ! Failed  ;  ++i)
 	{
 		const char *const arg = argv [i];
 		if (arg [0] != '-')
 		{
-			findTag (arg, options);
+			if (BySourceFile)
+				findTagsBy (arg, tagsFindByFile);
+			else if (ByScope)
+				findTagsBy (arg, tagsFindByScope);
+			else if (Batch)
+			{
+				findTags ((const char *const *) argv + i, argc - i, *options);
+				i = argc;
+			}
+			else if (Complete)
+				completeTag (arg, *options);
+			else
+				findTag (arg, *options);
 			actionSupplied = 1;
 		}
 		else
 		{
 			size_t j;
-			for (j = 1  ;  arg [j] != '\0'  ;  ++j)
+			for (j = 1  ;  arg [j] != '\0'  &&  ! Failed  ;  ++j)
 			{
 				switch (arg [j])
 				{
-					case 'e': extensionFields = 1;         break;
-					case 'i': options |= TAG_IGNORECASE;   break;
-					case 'p': options |= TAG_PARTIALMATCH; break;
+					case 'c':
+						Complete = 1;
+						if (isdigit ((int) (unsigned char) arg [j + 1]))
+						{
+							CompletionLimit = atoi (arg + j + 1);
+							while (isdigit ((int) (unsigned char) arg [j + 1]))
+								++j;
+						}
+						break;
+					case 'e': extensionFields = 1;          break;
+					case 'f': *options |= TAG_FUZZYMATCH;   break;
+					case 'F': BySourceFile = 1;             break;
+					case 'C': ByScope = 1;                  break;
+					case 'i': *options |= TAG_IGNORECASE;   break;
+					case 'p': *options |= TAG_PARTIALMATCH; break;
 					case 'l': listTags (); actionSupplied = 1; break;
-			
+					case 'm': Batch = 1;                    break;
+
 					case 't':
 						if (arg [j+1] != '\0')
 						{
@@ -917,34 +3625,328 @@ extern int main (int argc, char **argv)
 						else if (i + 1 < argc)
 							TagFileName = argv [++i];
 						else
+							usage ();
+						TagSetName = NULL;
+						break;
+					case 'M':
+					case 'G':
+						TagSetGlob = (arg [j] == 'G');
+						if (arg [j+1] != '\0')
 						{
-							fprintf (stderr, Usage, ProgramName);
-							exit (1);
+							TagSetName = arg + j + 1;
+							j += strlen (TagSetName);
 						}
+						else if (i + 1 < argc)
+							TagSetName = argv [++i];
+						else
+							usage ();
 						break;
 					case 's':
 						SortOverride = 1;
 						++j;
 						if (arg [j] == '\0')
+						{
 							SortMethod = TAG_SORTED;
+							--j;
+						}
 						else if (strchr ("012", arg[j]) != NULL)
 							SortMethod = (sortType) (arg[j] - '0');
+						else
+							usage ();
+						break;
+					case 'S':
+					case 'U':
+						if (Serving)
+							fail ("-%c is not a query", arg [j]);
 						else
 						{
-							fprintf (stderr, Usage, ProgramName);
-							exit (1);
+							ServerSettings.tagFileName = TagFileName;
+							ServerSettings.tagSetName = TagSetName;
+							ServerSettings.tagSetGlob = TagSetGlob;
+							ServerSettings.options = *options;
+							ServerSettings.extensionFields = extensionFields;
+							ServerSettings.sortOverride = SortOverride;
+							ServerSettings.sortMethod = SortMethod;
+							ServerSettings.complete = Complete;
+							ServerSettings.batch = Batch;
+							ServerSettings.bySourceFile = BySourceFile;
+							ServerSettings.byScope = ByScope;
+							ServerSettings.completionLimit = CompletionLimit;
+							Serving = 1;
+							if (arg [j] == 'S')
+								serve (stdin);
+#ifdef USE_SOCKETS
+							else if (i + 1 < argc)
+								serveSocket (argv [++i]);
+#endif
+							else
+							{
+								Serving = 0;
+								usage ();
+							}
+							i = argc;
+							actionSupplied = 1;
 						}
 						break;
 					default:
-						fprintf (stderr, "%s: unknown option: %c\n",
-									ProgramName, arg[j]);
-						exit (1);
+						if (Serving)
+							fail ("unknown option: %c", arg [j]);
+						else
+						{
+							fprintf (stderr, "%s: unknown option: %c\n",
+										ProgramName, arg[j]);
+							exit (1);
+						}
 						break;
 				}
 			}
 		}
 	}
-	if (! actionSupplied)
+	return actionSupplied;
+}
+
+/*  Answers one query, writing the answer to Output.
+ */
+static void answer (char *const query)
+{
+	char **argv = NULL;
+	int argc = 0;
+	int max = 0;
+	int options = ServerSettings.options;
+	char *p = query;
+
+	TagFileName = ServerSettings.tagFileName;
+	TagSetName = ServerSettings.tagSetName;
+	TagSetGlob = ServerSettings.tagSetGlob;
+	extensionFields = ServerSettings.extensionFields;
+	SortOverride = ServerSettings.sortOverride;
+	SortMethod = ServerSettings.sortMethod;
+	Complete = ServerSettings.complete;
+	Batch = ServerSettings.batch;
+	BySourceFile = ServerSettings.bySourceFile;
+	ByScope = ServerSettings.byScope;
+	CompletionLimit = ServerSettings.completionLimit;
+	Failed = 0;
+
+	while (*p != '\0'  &&  ! Failed)
+	{
+		while (*p == ' '  ||  *p == '\t'  ||  *p == '\r')
+			*p++ = '\0';
+		if (*p != '\0')
+		{
+			if (argc == max)
+			{
+				char **const list = (char **) realloc (argv,
+						(size_t) (max + 16) * sizeof (char *));
+				if (list == NULL)
+					fail ("out of memory");
+				else
+				{
+					argv = list;
+					max += 16;
+				}
+			}
+			if (! Failed)
+				argv [argc++] = p;
+			while (*p != '\0'  &&  *p != ' '  &&  *p != '\t'  &&  *p != '\r')
+				++p;
+		}
+	}
+	if (! Failed  &&  argc > 0  &&
+		! processArguments (argc, argv, &options)  &&  ! Failed)
+	{
+		fail ("no action specified: specify tag name(s) or -l option");
+	}
+	free (argv);
+	putc ('\n', Output);
+	fflush (Output);
+}
+
+/*  Answers each line read from `in' as a query, until the end of input.
+ */
+static void serve (FILE *const in)
+{
+	vstring line;
+	size_t length = 0;
+	int c;
+	line.size = 0;
+	line.buffer = NULL;
+	if (! growString (&line))
+		exit (1);
+	while ((c = getc (in)) != EOF  ||  length > 0)
+	{
+		if (c == '\n'  ||  c == EOF)
+		{
+			line.buffer [length] = '\0';
+			answer (line.buffer);
+			length = 0;
+		}
+		else
+		{
+			if (length + 1 >= line.size  &&  ! growString (&line))
+				exit (1);
+			line.buffer [length++] = (char) c;
+		}
+	}
+	free (line.buffer);
+}
+
+#ifdef USE_SOCKETS
+
+/*  A client of the socket, with the part of a query not yet read in full.
+ */
+typedef struct {
+	int fd;
+	FILE *out;
+	vstring query;
+	size_t length;
+} socketClient;
+
+static void closeClient (socketClient *const client)
+{
+	fclose (client->out);
+	close (client->fd);
+	free (client->query.buffer);
+	memset (client, 0, sizeof (socketClient));
+	client->fd = -1;
+}
+
+/*  Reads what a client has sent, answering each query completed. Returns
+ *  zero once the client has closed its connection.
+ */
+static int readClient (socketClient *const client)
+{
+	char buffer [4096];
+	const ssize_t count = read (client->fd, buffer, sizeof (buffer));
+	ssize_t i;
+	for (i = 0  ;  i < count  ;  ++i)
+	{
+		if (buffer [i] == '\n')
+		{
+			client->query.buffer [client->length] = '\0';
+			Output = client->out;
+			answer (client->query.buffer);
+			client->length = 0;
+		}
+		else
+		{
+			if (client->length + 1 >= client->query.size  &&
+				! growString (&client->query))
+			{
+				return 0;
+			}
+			client->query.buffer [client->length++] = buffer [i];
+		}
+	}
+	return (count > 0);
+}
+
+/*  Answers the queries of clients connecting to the Unix domain socket
+ *  `path', which is created, until the program is ended.
+ */
+static void serveSocket (const char *const path)
+{
+	enum { MaxClients = 64 };
+	socketClient clients [MaxClients];
+	struct sockaddr_un address;
+	struct stat status;
+	const int listener = socket (AF_UNIX, SOCK_STREAM, 0);
+	int i;
+
+	memset (&address, 0, sizeof (address));
+	address.sun_family = AF_UNIX;
+	if (strlen (path) >= sizeof (address.sun_path))
+	{
+		fprintf (stderr, "%s: socket name too long: %s\n", ProgramName, path);
+		exit (1);
+	}
+	strcpy (address.sun_path, path);
+	/*  remove a socket left by an earlier server, but nothing else  */
+	if (lstat (path, &status) == 0  &&  S_ISSOCK (status.st_mode))
+		unlink (path);
+	if (listener < 0  ||
+		bind (listener, (struct sockaddr *) &address, sizeof (address)) != 0  ||
+		listen (listener, 16) != 0)
+	{
+		fprintf (stderr, "%s: cannot listen on socket: %s: %s\n",
+				ProgramName, strerror (errno), path);
+		exit (1);
+	}
+	signal (SIGPIPE, SIG_IGN);
+	for (i = 0  ;  i < MaxClients  ;  ++i)
+	{
+		memset (&clients [i], 0, sizeof (socketClient));
+		clients [i].fd = -1;
+	}
+	while (1)
+	{
+		fd_set ready;
+		int last = listener;
+		FD_ZERO (&ready);
+		FD_SET (listener, &ready);
+		for (i = 0  ;  i < MaxClients  ;  ++i)
+		{
+			if (clients [i].fd >= 0)
+			{
+				FD_SET (clients [i].fd, &ready);
+				if (clients [i].fd > last)
+					last = clients [i].fd;
+			}
+		}
+		if (select (last + 1, &ready, NULL, NULL, NULL) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			perror ("select");
+			exit (1);
+		}
+		for (i = 0  ;  i < MaxClients  ;  ++i)
+		{
+			if (clients [i].fd >= 0  &&  FD_ISSET (clients [i].fd, &ready)  &&
+				! readClient (&clients [i]))
+			{
+				closeClient (&clients [i]);
+			}
+		}
+		if (FD_ISSET (listener, &ready))
+		{
+			const int fd = accept (listener, NULL, NULL);
+			for (i = 0  ;  fd >= 0  &&  i < MaxClients  ;  ++i)
+				if (clients [i].fd < 0)
+					break;
+			if (fd < 0)
+				;  /* client went away */
+			else if (i == MaxClients  ||  fd >= FD_SETSIZE)
+				close (fd);
+			else
+			{
+				const int outFd = dup (fd);
+				clients [i].out = (outFd < 0) ? NULL : fdopen (outFd, "w");
+				if (clients [i].out == NULL  ||  ! growString (&clients [i].query))
+				{
+					if (clients [i].out != NULL)
+						fclose (clients [i].out);
+					else if (outFd >= 0)
+						close (outFd);
+					close (fd);
+				}
+				else
+					clients [i].fd = fd;
+			}
+		}
+	}
+}
+
+#endif
+
+extern int main (int argc, char **argv)
+{
+	int options = 0;
+	ProgramName = argv [0];
+	Output = stdout;
+	if (argc == 1)
+		usage ();
+	if (! processArguments (argc - 1, argv + 1, &options))
 	{
 		fprintf (stderr,
 			"%s: no action specified: specify tag name(s) or -l option\n",
@@ -17,6 +17,27 @@
 *   to this approach permits a user to regenerate a tag file at will without
 *   the tool needing to detect and resynchronize with changes to the tag file.
 *   Even for an unsorted 24MB tag file, tag searches take about one second.
+*
+*   Where the host supports mmap (), the tag file is mapped into memory when
+*   opened. Searches then compare directly against the mapped contents, and
+*   only the line of a tag actually returned is copied. A tag file should be
+*   replaced (e.g. written to a new file and renamed) rather than rewritten in
+*   place while a tool holds it open.
+*
+*   If an index written by "ctags --tag-index" accompanies the tag file (in a
+*   file named by appending ".idx" to its name), tagsFind() searches it by
+*   binary search regardless of how the tag file is sorted or whether case is
+*   ignored. Matches are then returned in order of name, and, among equal
+*   names, in the order they appear in the tag file. The index is ignored if
+*   the tag file has changed since it was written.
+*
+*   A binary tag file written by "ctags --output-format=binary" is read in
+*   the same way as a text tag file, and is recognized when opened. Its tags
+*   are stored in blocks, each beginning with a tag whose name is given in
+*   full, so tagsFind() reads only those tags to find the block holding the
+*   first match. The lines returned are those of the text tag file from which
+*   it was written. The whole of a binary tag file is read into memory when
+*   opened if it cannot be mapped.
 */
 #ifndef READTAGS_H
 #define READTAGS_H
@@ -41,6 +62,9 @@ typedef enum {
 #define TAG_OBSERVECASE   0x0
 #define TAG_IGNORECASE    0x2
 
+/* Additional option for tagsComplete() */
+#define TAG_FUZZYMATCH    0x4
+
 /*
 *  DATA DECLARATIONS
 */
@@ -51,6 +75,14 @@ struct sTagFile;
 
 typedef struct sTagFile tagFile;
 
+struct sTagCursor;
+
+typedef struct sTagCursor tagCursor;
+
+struct sTagSet;
+
+typedef struct sTagSet tagSet;
+
 /* This structure contains information about the tag file. */
 typedef struct {
 
@@ -139,6 +171,25 @@ typedef struct {
 
 } tagEntry;
 
+/* Function called by tagsFindMany() and the other functions below taking
+ * one for each tag found. It is passed the tag entry, a position (for
+ * tagsFindMany(), that within the list of names of the name matched), and
+ * the data pointer passed to the function. Returning zero ends the search.
+ */
+typedef int (*tagFoundFunction) (const tagEntry *const entry, const int which, void *const data);
+
+/* This structure describes a candidate returned by tagsComplete(). */
+typedef struct {
+
+		/* name of tag (valid until the next call to tagsComplete() or
+		 * tagsClose() for the same tag file) */
+	const char *name;
+
+		/* quality of match, higher being better (zero for prefix matches) */
+	int score;
+
+} tagCompletion;
+
 
 /*
 *  FUNCTION PROTOTYPES
@@ -236,6 +287,101 @@ extern tagResult tagsFind (tagFile *const file, tagEntry *const entry, const cha
 */
 extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry);
 
+/*
+*  Find the tags matching each of the `count' names in `names' at once,
+*  calling `callback' for every match. The options are those of tagsFind().
+*  The names are sorted and looked up in order, each search starting where
+*  the last left off; if the tag file can only be searched sequentially, it
+*  is read just once for all of the names. Matches are therefore reported in
+*  order of name rather than in the order of `names' (and, when the tag file
+*  is read sequentially, in the order of the tag file). The entry passed to
+*  the callback is only valid during the call. The function returns the
+*  number of names for which a tag was found. It changes the position from
+*  which tagsNext() reads, and ends any search begun by tagsFind().
+*/
+extern int tagsFindMany (tagFile *const file, const char *const *const names, const int count, const int options, tagFoundFunction callback, void *const data);
+
+/*
+*  Find the tags defined in the source file `sourceFile', named exactly as in
+*  the tag file, calling `callback' for each (with zero for `which'), as for
+*  tagsFindMany(). If the tag file has an index, the tags are found by binary
+*  search and reported in the order they appear in the tag file; otherwise
+*  every tag in the file is read. The function returns the number of tags
+*  found. Like tagsFindMany(), it ends any search begun by tagsFind().
+*/
+extern int tagsFindByFile (tagFile *const file, const char *const sourceFile, tagFoundFunction callback, void *const data);
+
+/*
+*  Find the members of the scope `scope': the tags whose scope extension
+*  field (such as "class:" or "namespace:", whose key is the kind of the
+*  enclosing tag) has exactly the value `scope' (e.g. "Outer::Inner"), with
+*  any key. The scope of a tag is its first extension field other than those
+*  of known keys ("language", "typeref", "inherits", "access",
+*  "implementation" and "signature"). The tags are reported as by
+*  tagsFindByFile(), using the index, if present, to find them in time
+*  proportional to the logarithm of the number of tags plus the number
+*  found.
+*/
+extern int tagsFindByScope (tagFile *const file, const char *const scope, tagFoundFunction callback, void *const data);
+
+/*
+*  Find up to `max' distinct tag names completing `pattern', for use by
+*  completion and symbol search in editors. The candidates are stored in
+*  `candidates', which must have room for `max' entries, best first, and their
+*  number is returned. The following options may be combined:
+*
+*    TAG_PARTIALMATCH
+*        Names beginning with `pattern' qualify, and are returned in order of
+*        name ignoring case. This is the default.
+*
+*    TAG_FUZZYMATCH
+*        Names containing the characters of `pattern' in order qualify (e.g.
+*        "gtfl" matches "getFileLanguage"). Names matching at the starts of
+*        words and in runs of consecutive characters score higher.
+*
+*    TAG_IGNORECASE
+*        Matching will be performed in a case-insenstive manner.
+*
+*  If the tag file has an index (see above), prefix completion takes time
+*  proportional to the logarithm of the number of names, and fuzzy completion
+*  inspects only the names containing every character of `pattern'. Otherwise
+*  every tag in the file is read. Like tagsFind(), this changes the position
+*  from which tagsNext() reads.
+*/
+extern int tagsComplete (tagFile *const file, const char *const pattern, const int options, tagCompletion *const candidates, const int max);
+
+/*
+*  Each tag file has a position and search state of its own, used by the
+*  functions above. A cursor is an additional, independent position and
+*  search state for the same tag file, so that several threads may read a
+*  tag file opened once, each using a cursor of its own, without locking.
+*  Where the tag file is mapped into memory, cursors share its mapping and
+*  index; otherwise each cursor opens the tag file again.
+*
+*  Once a cursor has been created, the tag file is assumed not to change
+*  while it remains open: it is no longer remapped if it changes size, nor
+*  is its index discarded if it becomes out of date. Create the first cursor
+*  (and call tagsSetSortType(), if needed) before other threads use the tag
+*  file, and delete all cursors before calling tagsClose(). The functions
+*  above, taking the tag file itself, may still be used by one thread at a
+*  time.
+*
+*  tagsCursorNew() returns a new cursor positioned before the first tag, or
+*  null if one could not be created. The remaining functions behave as their
+*  counterparts above, acting upon the cursor rather than upon the tag file.
+*  tagsCursorDelete() frees a cursor created by tagsCursorNew().
+*/
+extern tagCursor *tagsCursorNew (tagFile *const file);
+extern tagResult tagsCursorFirst (tagCursor *const cursor, tagEntry *const entry);
+extern tagResult tagsCursorNext (tagCursor *const cursor, tagEntry *const entry);
+extern tagResult tagsCursorFind (tagCursor *const cursor, tagEntry *const entry, const char *const name, const int options);
+extern tagResult tagsCursorFindNext (tagCursor *const cursor, tagEntry *const entry);
+extern int tagsCursorFindMany (tagCursor *const cursor, const char *const *const names, const int count, const int options, tagFoundFunction callback, void *const data);
+extern int tagsCursorFindByFile (tagCursor *const cursor, const char *const sourceFile, tagFoundFunction callback, void *const data);
+extern int tagsCursorFindByScope (tagCursor *const cursor, const char *const scope, tagFoundFunction callback, void *const data);
+extern int tagsCursorComplete (tagCursor *const cursor, const char *const pattern, const int options, tagCompletion *const candidates, const int max);
+extern tagResult tagsCursorDelete (tagCursor *const cursor);
+
 /*
 *  Call tagsTerminate() at completion of reading the tag file, which will
 *  close the file and free any internal memory allocated. The function will
@@ -243,6 +389,54 @@ extern tagResult tagsFindNext (tagFile *const file, tagEntry *const entry);
 */
 extern tagResult tagsClose (tagFile *const file);
 
+/*
+*  A tag set is a list of tag files, such as the shards of the tag file of a
+*  large source tree, searched together as though they were one. The tag
+*  files are opened when first searched and held open until the set is
+*  closed, so that later searches need not open them again.
+*
+*  tagsSetNew() returns a new, empty tag set, or null if one could not be
+*  created. tagsSetAdd() adds the tag file `filePath' to the set.
+*  tagsSetAddManifest() adds each tag file named on a line of the file
+*  `manifest', ignoring empty lines and lines beginning with '#'; a name not
+*  beginning with '/' is taken relative to the directory holding the
+*  manifest. tagsSetAddGlob() adds, in order of name, each tag file matching
+*  the shell pattern `pattern'. These two return the number of tag files
+*  added, or -1 if the manifest could not be read or the pattern could not
+*  be expanded (or if this library was built without support for patterns).
+*
+*  tagsSetFind() finds the tags matching `name' in every tag file of the set,
+*  with the options of tagsFind(), calling `callback' for each match with the
+*  position of its tag file in the set (as passed to tagsSetPath()). Where
+*  threads are supported (HAVE_PTHREAD_H is defined, and the program linked
+*  with the threads library), up to eight tag files are searched at once,
+*  each by a thread of its own. Their matches are then merged, so that they
+*  are reported in order of name provided that each tag file returns its own
+*  matches in order of name (i.e. it is sorted, or has an index, as
+*  appropriate to the options). Among equal names, matches are reported in
+*  the order the tag files were added. The entry passed to the callback is
+*  only valid during the call, and returning zero from it ends the search.
+*  The function returns the number of matches reported. Tag files which
+*  cannot be opened are passed over, and opened again by the next search.
+*
+*  tagsSetPath() returns the path of the tag file at position `which' in the
+*  set, or null if there is none. tagsSetFile() returns the tag file itself,
+*  opening it if needed, or null if it cannot be opened; it remains owned by
+*  the set. tagsSetRefresh() closes each tag file of the set which has been
+*  replaced or has changed (in size or modification time) since it was
+*  opened, so that the next search opens it again, and returns the number
+*  closed. tagsSetClose() closes every tag file of the set and frees it.
+*/
+extern tagSet *tagsSetNew (void);
+extern tagResult tagsSetAdd (tagSet *const set, const char *const filePath);
+extern int tagsSetAddManifest (tagSet *const set, const char *const manifest);
+extern int tagsSetAddGlob (tagSet *const set, const char *const pattern);
+extern int tagsSetFind (tagSet *const set, const char *const name, const int options, tagFoundFunction callback, void *const data);
+extern const char *tagsSetPath (const tagSet *const set, const int which);
+extern tagFile *tagsSetFile (tagSet *const set, const int which);
+extern int tagsSetRefresh (tagSet *const set);
+extern tagResult tagsSetClose (tagSet *const set);
+
 #ifdef __cplusplus
 };
 #endif
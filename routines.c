@@ -47,6 +47,13 @@
 # endif
 #endif
 
+#ifdef HAVE_GETTIMEOFDAY
+# ifdef HAVE_SYS_TIME_H
+#  include <sys/time.h>  /* to declare gettimeofday() */
+# endif
+#elif defined (HAVE_TIME_H)
+# include <time.h>  /* to declare time() */
+#endif
 #ifdef HAVE_DOS_H
 # include <dos.h>  /* to declare MAXPATH */
 #endif
@@ -120,6 +127,14 @@
 # define S_ISUID 0
 #endif
 
+#if defined (HAVE_STAT_ST_MTIM)
+# define mtimeNanoseconds(status)	((unsigned long) (status).st_mtim.tv_nsec)
+#elif defined (HAVE_STAT_ST_MTIMESPEC)
+# define mtimeNanoseconds(status)	((unsigned long) (status).st_mtimespec.tv_nsec)
+#else
+# define mtimeNanoseconds(status)	0UL
+#endif
+
 /*  Hack for rediculous practice of Microsoft Visual C++.
  */
 #if defined (WIN32)
@@ -231,9 +246,13 @@ extern void error (
 
 /*
  *  Memory allocation functions
+ *
+ *  When memory accounting is configured, the names of these functions are
+ *  macros calling the accounting functions below (see routines.h), so their
+ *  names are parenthesized where they are defined and called here.
  */
 
-extern void *eMalloc (const size_t size)
+extern void *(eMalloc) (const size_t size)
 {
 	void *buffer = malloc (size);
 
@@ -243,7 +262,7 @@ extern void *eMalloc (const size_t size)
 	return buffer;
 }
 
-extern void *eCalloc (const size_t count, const size_t size)
+extern void *(eCalloc) (const size_t count, const size_t size)
 {
 	void *buffer = calloc (count, size);
 
@@ -253,11 +272,11 @@ extern void *eCalloc (const size_t count, const size_t size)
 	return buffer;
 }
 
-extern void *eRealloc (void *const ptr, const size_t size)
+extern void *(eRealloc) (void *const ptr, const size_t size)
 {
 	void *buffer;
 	if (ptr == NULL)
-		buffer = eMalloc (size);
+		buffer = (eMalloc) (size);
 	else
 	{
 		buffer = realloc (ptr, size);
@@ -267,12 +286,392 @@ extern void *eRealloc (void *const ptr, const size_t size)
 	return buffer;
 }
 
-extern void eFree (void *const ptr)
+extern void (eFree) (void *const ptr)
 {
 	Assert (ptr != NULL);
 	free (ptr);
 }
 
+#ifdef MEMORY_ACCOUNTING
+
+/*  Each block allocated is recorded in a hash table, open addressed by its
+ *  address, with its size and the place in the source (file and line) which
+ *  allocated it. Totals are kept for each place and each source file. The
+ *  tables themselves are allocated directly, and so not accounted.
+ */
+typedef struct sMemoryTotals {
+	const char *file;
+	unsigned long allocations;    /* new blocks allocated */
+	unsigned long reallocations;  /* blocks resized */
+	unsigned long bytes;          /* total of sizes requested */
+	size_t current;               /* bytes allocated and not yet freed */
+	size_t peak;                  /* greatest value of current */
+} memoryTotals;
+
+typedef struct sAllocationSite {
+	memoryTotals totals;          /* current and peak not kept */
+	int line;
+	unsigned int file;            /* index into MemoryAccounts.files */
+} allocationSite;
+
+typedef struct sAllocation {
+	const void *address;          /* NULL if slot is empty */
+	size_t size;
+	unsigned int site;            /* index into MemoryAccounts.sites */
+} allocation;
+
+static struct sMemoryAccounts {
+	allocation *blocks;           /* hash table of blocks allocated */
+	unsigned long blockSlots, blockCount;
+	unsigned int *siteSlots;      /* hash table of site indexes plus one */
+	unsigned int siteSlotCount;
+	allocationSite *sites;
+	unsigned int siteCount, siteMax;
+	memoryTotals *files;
+	unsigned int fileCount, fileMax;
+	memoryTotals total;
+	boolean reported;             /* no more is recorded once reported */
+} MemoryAccounts;
+
+static void *accountsAlloc (void *const ptr, const size_t size)
+{
+	void *const buffer = realloc (ptr, size);
+	if (buffer == NULL)
+		error (FATAL, "out of memory");
+	return buffer;
+}
+
+static unsigned long hashAddress (const void *const address)
+{
+	return (unsigned long) (((size_t) address >> 3) * 2654435761UL);
+}
+
+static unsigned int hashSite (const char *const file, const int line)
+{
+	unsigned int h = (unsigned int) line;
+	const char *p;
+	for (p = file  ;  *p != '\0'  ;  ++p)
+		h = h * 31 + (unsigned char) *p;
+	return h;
+}
+
+/*  Returns the slot holding the block at `address', or the empty slot where
+ *  it belongs.
+ */
+static unsigned long findBlock (const void *const address)
+{
+	const unsigned long mask = MemoryAccounts.blockSlots - 1;
+	unsigned long slot = hashAddress (address) & mask;
+
+	while (MemoryAccounts.blocks [slot].address != NULL  &&
+		   MemoryAccounts.blocks [slot].address != address)
+		slot = (slot + 1) & mask;
+	return slot;
+}
+
+static void growBlocks (void)
+{
+	allocation *const old = MemoryAccounts.blocks;
+	const unsigned long oldSlots = MemoryAccounts.blockSlots;
+	unsigned long i;
+
+	MemoryAccounts.blockSlots = oldSlots == 0 ? 4096 : oldSlots * 2;
+	MemoryAccounts.blocks = accountsAlloc (NULL,
+			MemoryAccounts.blockSlots * sizeof (allocation));
+	memset (MemoryAccounts.blocks, 0,
+			MemoryAccounts.blockSlots * sizeof (allocation));
+	for (i = 0  ;  i < oldSlots  ;  ++i)
+		if (old [i].address != NULL)
+			MemoryAccounts.blocks [findBlock (old [i].address)] = old [i];
+	if (old != NULL)
+		free (old);
+}
+
+/*  Empties a slot, moving back any later block of the same run which would
+ *  otherwise no longer be found.
+ */
+static void removeBlock (unsigned long slot)
+{
+	const unsigned long mask = MemoryAccounts.blockSlots - 1;
+	unsigned long next = slot;
+
+	for (;;)
+	{
+		unsigned long home;
+
+		next = (next + 1) & mask;
+		if (MemoryAccounts.blocks [next].address == NULL)
+			break;
+		home = hashAddress (MemoryAccounts.blocks [next].address) & mask;
+		if ((next > slot  &&  (home <= slot  ||  home > next))  ||
+			(next < slot  &&  (home <= slot  &&  home > next)))
+		{
+			MemoryAccounts.blocks [slot] = MemoryAccounts.blocks [next];
+			slot = next;
+		}
+	}
+	MemoryAccounts.blocks [slot].address = NULL;
+	--MemoryAccounts.blockCount;
+}
+
+static unsigned int findSourceFile (const char *const file)
+{
+	unsigned int i;
+
+	for (i = 0  ;  i < MemoryAccounts.fileCount  ;  ++i)
+		if (strcmp (MemoryAccounts.files [i].file, file) == 0)
+			return i;
+	if (MemoryAccounts.fileCount == MemoryAccounts.fileMax)
+	{
+		MemoryAccounts.fileMax = MemoryAccounts.fileMax == 0 ? 64 :
+				MemoryAccounts.fileMax * 2;
+		MemoryAccounts.files = accountsAlloc (MemoryAccounts.files,
+				MemoryAccounts.fileMax * sizeof (memoryTotals));
+	}
+	memset (MemoryAccounts.files + i, 0, sizeof (memoryTotals));
+	MemoryAccounts.files [i].file = file;
+	return MemoryAccounts.fileCount++;
+}
+
+static void growSites (void)
+{
+	unsigned int i;
+
+	MemoryAccounts.siteSlotCount = MemoryAccounts.siteSlotCount == 0 ? 1024 :
+			MemoryAccounts.siteSlotCount * 2;
+	MemoryAccounts.siteSlots = accountsAlloc (MemoryAccounts.siteSlots,
+			MemoryAccounts.siteSlotCount * sizeof (unsigned int));
+	memset (MemoryAccounts.siteSlots, 0,
+			MemoryAccounts.siteSlotCount * sizeof (unsigned int));
+	for (i = 0  ;  i < MemoryAccounts.siteCount  ;  ++i)
+	{
+		const allocationSite *const site = MemoryAccounts.sites + i;
+		const unsigned int mask = MemoryAccounts.siteSlotCount - 1;
+		unsigned int slot = hashSite (site->totals.file, site->line) & mask;
+
+		while (MemoryAccounts.siteSlots [slot] != 0)
+			slot = (slot + 1) & mask;
+		MemoryAccounts.siteSlots [slot] = i + 1;
+	}
+}
+
+static unsigned int findSite (const char *const file, const int line)
+{
+	unsigned int mask = MemoryAccounts.siteSlotCount - 1;
+	unsigned int slot = hashSite (file, line) & mask;
+	allocationSite *site;
+
+	while (MemoryAccounts.siteSlots [slot] != 0)
+	{
+		site = MemoryAccounts.sites + MemoryAccounts.siteSlots [slot] - 1;
+		if (site->line == line  &&  (site->totals.file == file  ||
+			strcmp (site->totals.file, file) == 0))
+			return MemoryAccounts.siteSlots [slot] - 1;
+		slot = (slot + 1) & mask;
+	}
+	if (MemoryAccounts.siteCount == MemoryAccounts.siteMax)
+	{
+		MemoryAccounts.siteMax = MemoryAccounts.siteMax == 0 ? 256 :
+				MemoryAccounts.siteMax * 2;
+		MemoryAccounts.sites = accountsAlloc (MemoryAccounts.sites,
+				MemoryAccounts.siteMax * sizeof (allocationSite));
+	}
+	site = MemoryAccounts.sites + MemoryAccounts.siteCount;
+	memset (site, 0, sizeof (allocationSite));
+	site->totals.file = file;
+	site->line = line;
+	site->file = findSourceFile (file);
+	MemoryAccounts.siteSlots [slot] = ++MemoryAccounts.siteCount;
+	if (MemoryAccounts.siteCount * 2 > MemoryAccounts.siteSlotCount)
+		growSites ();
+	return MemoryAccounts.siteCount - 1;
+}
+
+static void chargeTotals (
+		memoryTotals *const totals, const size_t size, const boolean resized)
+{
+	if (resized)
+		++totals->reallocations;
+	else
+		++totals->allocations;
+	totals->bytes += size;
+	totals->current += size;
+	if (totals->current > totals->peak)
+		totals->peak = totals->current;
+}
+
+static void recordRelease (const void *const address)
+{
+	if (address != NULL  &&  MemoryAccounts.blockCount > 0)
+	{
+		const unsigned long slot = findBlock (address);
+		const allocation *const block = MemoryAccounts.blocks + slot;
+
+		if (block->address != NULL)
+		{
+			const allocationSite *const site = MemoryAccounts.sites + block->site;
+
+			MemoryAccounts.files [site->file].current -= block->size;
+			MemoryAccounts.total.current -= block->size;
+			removeBlock (slot);
+		}
+	}
+}
+
+static int compareSourceFiles (const void *const a, const void *const b)
+{
+	const memoryTotals *const x = (const memoryTotals *) a;
+	const memoryTotals *const y = (const memoryTotals *) b;
+	return (x->peak < y->peak) - (x->peak > y->peak);
+}
+
+static int compareSites (const void *const a, const void *const b)
+{
+	const allocationSite *const x = (const allocationSite *) a;
+	const allocationSite *const y = (const allocationSite *) b;
+	const unsigned long xCount = x->totals.allocations + x->totals.reallocations;
+	const unsigned long yCount = y->totals.allocations + y->totals.reallocations;
+	return (xCount < yCount) - (xCount > yCount);
+}
+
+static void printMemoryTotals (const char *const name, const memoryTotals *const totals)
+{
+	fprintf (stderr, "%-20s %10lu %10lu %12lu %12lu %12lu\n", name,
+			(unsigned long) totals->peak / 1024,
+			(unsigned long) totals->current / 1024,
+			totals->allocations, totals->reallocations, totals->bytes / 1024);
+}
+
+/*  Prints the memory allocated by each source file, and the places in the
+ *  source which allocated most often, when ctags exits. Memory still held at
+ *  exit was not freed by the clean-up at the end of main ().
+ */
+static void printMemoryReport (void)
+{
+	const char *const program = ExecutableName != NULL ? ExecutableName : "ctags";
+	unsigned int i;
+
+	qsort (MemoryAccounts.files, MemoryAccounts.fileCount,
+			sizeof (memoryTotals), compareSourceFiles);
+	fprintf (stderr, "%s: memory allocated, by source file:\n", program);
+	fprintf (stderr, "%-20s %10s %10s %12s %12s %12s\n", "source file",
+			"peak kB", "at exit kB", "allocations", "resizes", "total kB");
+	for (i = 0  ;  i < MemoryAccounts.fileCount  ;  ++i)
+		printMemoryTotals (MemoryAccounts.files [i].file, MemoryAccounts.files + i);
+	printMemoryTotals ("all", &MemoryAccounts.total);
+
+	qsort (MemoryAccounts.sites, MemoryAccounts.siteCount,
+			sizeof (allocationSite), compareSites);
+	fprintf (stderr, "%s: busiest allocation sites:\n", program);
+	fprintf (stderr, "%-20s %12s %12s %12s\n", "site",
+			"allocations", "resizes", "total kB");
+	for (i = 0  ;  i < MemoryAccounts.siteCount  &&  i < 15  ;  ++i)
+	{
+		const allocationSite *const site = MemoryAccounts.sites + i;
+		char name [64];
+
+		sprintf (name, "%.50s:%d", site->totals.file, site->line);
+		fprintf (stderr, "%-20s %12lu %12lu %12lu\n", name,
+				site->totals.allocations, site->totals.reallocations,
+				site->totals.bytes / 1024);
+	}
+
+	free (MemoryAccounts.blocks);
+	free (MemoryAccounts.siteSlots);
+	free (MemoryAccounts.sites);
+	free (MemoryAccounts.files);
+	memset (&MemoryAccounts, 0, sizeof (MemoryAccounts));
+	MemoryAccounts.reported = TRUE;
+}
+
+static void recordAllocation (
+		const void *const address, const size_t size,
+		const char *const file, const int line, const boolean resized)
+{
+	allocation *block;
+	allocationSite *site;
+	unsigned long slot;
+
+	if (MemoryAccounts.reported)
+		return;
+	if (MemoryAccounts.blockSlots == 0)
+	{
+		growSites ();
+		atexit (printMemoryReport);
+	}
+	if ((MemoryAccounts.blockCount + 1) * 2 > MemoryAccounts.blockSlots)
+		growBlocks ();
+
+	/*  A block freed other than through eFree () is forgotten when its
+	 *  address is reused.
+	 */
+	recordRelease (address);
+
+	slot = findBlock (address);
+	block = MemoryAccounts.blocks + slot;
+	block->address = address;
+	block->size = size;
+	block->site = findSite (file, line);
+	++MemoryAccounts.blockCount;
+
+	site = MemoryAccounts.sites + block->site;
+	chargeTotals (&site->totals, size, resized);
+	chargeTotals (MemoryAccounts.files + site->file, size, resized);
+	chargeTotals (&MemoryAccounts.total, size, resized);
+}
+
+extern void *accountedMalloc (
+		const size_t size, const char *const file, const int line)
+{
+	void *const buffer = (eMalloc) (size);
+	recordAllocation (buffer, size, file, line, FALSE);
+	return buffer;
+}
+
+extern void *accountedCalloc (
+		const size_t count, const size_t size,
+		const char *const file, const int line)
+{
+	void *const buffer = (eCalloc) (count, size);
+	recordAllocation (buffer, count * size, file, line, FALSE);
+	return buffer;
+}
+
+extern void *accountedRealloc (
+		void *const ptr, const size_t size,
+		const char *const file, const int line)
+{
+	void *buffer;
+
+	if (ptr == NULL)
+		buffer = accountedMalloc (size, file, line);
+	else
+	{
+		recordRelease (ptr);
+		buffer = (eRealloc) (ptr, size);
+		recordAllocation (buffer, size, file, line, TRUE);
+	}
+	return buffer;
+}
+
+extern void accountedFree (void *const ptr)
+{
+	recordRelease (ptr);
+	(eFree) (ptr);
+}
+
+extern char *accountedStrdup (
+		const char *const str, const char *const file, const int line)
+{
+	const size_t size = strlen (str) + 1;
+	char *const result = (char *) (eMalloc) (size);
+	memcpy (result, str, size);
+	recordAllocation (result, size, file, line, FALSE);
+	return result;
+}
+
+#endif  /* MEMORY_ACCOUNTING */
+
 /*
  *  String manipulation functions
  */
@@ -318,7 +717,7 @@ extern char* strstr (const char *str, const char *substr)
 }
 #endif
 
-extern char* eStrdup (const char* str)
+extern char* (eStrdup) (const char* str)
 {
 	char* result = xMalloc (strlen (str) + 1, char);
 	strcpy (result, str);
@@ -443,6 +842,8 @@ extern fileStatus *eStat (const char *const fileName)
 					(S_IXUSR | S_IXGRP | S_IXOTH)) != 0);
 				file.isSetuid = (boolean) ((status.st_mode & S_ISUID) != 0);
 				file.size = status.st_size;
+				file.mtime = (unsigned long) status.st_mtime;
+				file.mtimeNanoseconds = mtimeNanoseconds (status);
 			}
 		}
 	}
@@ -896,4 +1297,21 @@ extern FILE *tempFile (const char *const mode, char **const pName)
 	return fp;
 }
 
+/*
+ *  Timing functions
+ */
+
+/*  Returns the elapsed time in seconds since an arbitrary moment.
+ */
+extern double wallClock (void)
+{
+#ifdef HAVE_GETTIMEOFDAY
+	struct timeval now;
+	gettimeofday (&now, NULL);
+	return (double) now.tv_sec + (double) now.tv_usec / 1000000.0;
+#else
+	return (double) time (NULL);
+#endif
+}
+
 /* vi:set tabstop=4 shiftwidth=4: */
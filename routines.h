@@ -76,6 +76,12 @@ typedef struct {
 
 		/* Size of file (pointed to) */
 	unsigned long size;
+
+		/* Last modification time of file (pointed to) */
+	unsigned long mtime;
+
+		/* Nanoseconds of last modification time, or 0 if not known */
+	unsigned long mtimeNanoseconds;
 } fileStatus; 
 
 /*
@@ -129,6 +135,27 @@ extern char* absoluteDirname (char *file);
 extern char* relativeFilename (const char *file, const char *dir);
 extern FILE *tempFile (const char *const mode, char **const pName);
 
+/* Timing functions */
+extern double wallClock (void);
+
+/*  When configured with --enable-memory-accounting, each allocation made
+ *  through these functions is charged to the place in the source making it,
+ *  and a report of the memory allocated is printed when ctags exits.
+ */
+#ifdef MEMORY_ACCOUNTING
+extern void *accountedMalloc (const size_t size, const char *const file, const int line);
+extern void *accountedCalloc (const size_t count, const size_t size, const char *const file, const int line);
+extern void *accountedRealloc (void *const ptr, const size_t size, const char *const file, const int line);
+extern void accountedFree (void *const ptr);
+extern char *accountedStrdup (const char *const str, const char *const file, const int line);
+
+# define eMalloc(size)        accountedMalloc ((size), __FILE__, __LINE__)
+# define eCalloc(count,size)  accountedCalloc ((count), (size), __FILE__, __LINE__)
+# define eRealloc(ptr,size)   accountedRealloc ((ptr), (size), __FILE__, __LINE__)
+# define eFree(ptr)           accountedFree (ptr)
+# define eStrdup(str)         accountedStrdup ((str), __FILE__, __LINE__)
+#endif
+
 #endif  /* _ROUTINES_H */
 
 /* vi:set tabstop=4 shiftwidth=4: */
@@ -26,6 +26,7 @@
 #include "read.h"
 #include "routines.h"
 #include "sort.h"
+#include "trace.h"
 
 /*
 *   FUNCTION DEFINITIONS
@@ -45,6 +46,28 @@ extern void catFile (const char *const name)
 	}
 }
 
+/*  Orders lines ignoring case and then, among lines equal ignoring case, by
+ *  case, so that identical lines always come together to be dropped.
+ */
+static int compareTagsFolded(const void *const one, const void *const two)
+{
+	const char *const line1 = *(const char* const*) one;
+	const char *const line2 = *(const char* const*) two;
+	int result = struppercmp (line1, line2);
+
+	if (result == 0)
+		result = strcmp (line1, line2);
+	return result;
+}
+
+static int compareTags (const void *const one, const void *const two)
+{
+	const char *const line1 = *(const char* const*) one;
+	const char *const line2 = *(const char* const*) two;
+
+	return strcmp (line1, line2);
+}
+
 #ifdef EXTERNAL_SORT
 
 #ifdef NON_CONST_PUTENV_PROTOTYPE
@@ -56,7 +79,10 @@ extern void catFile (const char *const name)
 extern void externalSortTags (const boolean toStdout)
 {
 	const char *const sortNormalCommand = "sort -u -o";
-	const char *const sortFoldedCommand = "sort -u -f -o";
+	/*  Keys of the whole line, first ignoring case and then not, so that
+	 *  only identical lines are dropped, as by compareTagsFolded ().
+	 */
+	const char *const sortFoldedCommand = "sort -u -k 1f -k 1 -o";
 	const char *sortCommand =
 		Option.sorted == SO_FOLDSORTED ? sortFoldedCommand : sortNormalCommand;
 	PE_CONST char *const sortOrder1 = "LC_COLLATE=C";
@@ -114,22 +140,6 @@ static void failedSort (FILE *const fp, const char* msg)
 		error (FATAL, "%s: %s", msg, cannotSort);
 }
 
-static int compareTagsFolded(const void *const one, const void *const two)
-{
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
-
-	return struppercmp (line1, line2);
-}
-
-static int compareTags (const void *const one, const void *const two)
-{
-	const char *const line1 = *(const char* const*) one;
-	const char *const line2 = *(const char* const*) two;
-
-	return strcmp (line1, line2);
-}
-
 static void writeSortedTags (
 		char **const table, const size_t numTags, const boolean toStdout)
 {
@@ -172,17 +182,15 @@ extern void internalSortTags (const boolean toStdout)
 	/*  Allocate a table of line pointers to be sorted.
 	 */
 	size_t numTags = TagFile.numTags.added + TagFile.numTags.prev;
-	const size_t tableSize = numTags * sizeof (char *);
-	char **const table = (char **) malloc (tableSize);  /* line pointers */
-	DebugStatement ( size_t mallocSize = tableSize; )  /* cumulative total */
+	char **const table = xMalloc (numTags, char *);  /* line pointers */
+	DebugStatement ( size_t mallocSize = numTags * sizeof (char *); )  /* cumulative total */
 
 
 	cmpFunc = Option.sorted == SO_FOLDSORTED ? compareTagsFolded : compareTags;
-	if (table == NULL)
-		failedSort (fp, "out of memory");
 
 	/*  Open the tag file and place its lines into allocated buffers.
 	 */
+	traceBegin ("sort", "read tag file", tagFileName ());
 	fp = fopen (tagFileName (), "r");
 	if (fp == NULL)
 		failedSort (fp, NULL);
@@ -201,9 +209,7 @@ extern void internalSortTags (const boolean toStdout)
 		{
 			const size_t stringSize = strlen (line) + 1;
 
-			table [i] = (char *) malloc (stringSize);
-			if (table [i] == NULL)
-				failedSort (fp, "out of memory");
+			table [i] = xMalloc (stringSize, char);
 			DebugStatement ( mallocSize += stringSize; )
 			strcpy (table [i], line);
 			++i;
@@ -212,19 +218,227 @@ extern void internalSortTags (const boolean toStdout)
 	numTags = i;
 	fclose (fp);
 	vStringDelete (vLine);
+	traceEnd ();
 
 	/*  Sort the lines.
 	 */
+	traceBegin ("sort", "qsort", NULL);
 	qsort (table, numTags, sizeof (*table), cmpFunc);
+	traceEnd ();
 
+	traceBegin ("sort", "write tag file", tagFileName ());
 	writeSortedTags (table, numTags, toStdout);
+	traceEnd ();
 
 	PrintStatus (("sort memory: %ld bytes\n", (long) mallocSize));
 	for (i = 0 ; i < numTags ; ++i)
-		free (table [i]);
-	free (table);
+		eFree (table [i]);
+	eFree (table);
 }
 
 #endif
 
+/*
+ *  These functions merge tag files already sorted, reading a line at a time
+ *  from each, so that memory use does not grow with their size.
+ */
+
+typedef struct sMergeInput {
+	const char *name;
+	FILE *fp;
+	vString *line;              /* current line of the file */
+	unsigned long lineNumber;
+} mergeInput;
+
+/*  Pseudo tags written afresh for the merged tag file by openTagFile (),
+ *  and so dropped from the files merged.
+ */
+static const char *const MergedPseudoTags [] = {
+	"!_TAG_FILE_FORMAT\t", "!_TAG_FILE_SORTED\t", "!_TAG_PROGRAM_AUTHOR\t",
+	"!_TAG_PROGRAM_NAME\t", "!_TAG_PROGRAM_URL\t", "!_TAG_PROGRAM_VERSION\t"
+};
+
+static int compareMergedLines (const char *const line1, const char *const line2)
+{
+	if (Option.sorted == SO_FOLDSORTED)
+		return compareTagsFolded (&line1, &line2);
+	else
+		return compareTags (&line1, &line2);
+}
+
+/*  Checks the order of two lines of a file being merged. A file sorted
+ *  ignoring case need not order by case the lines equal ignoring case.
+ */
+static boolean isMergedInOrder (const char *const line1, const char *const line2)
+{
+	int result;
+
+	if (Option.sorted == SO_FOLDSORTED)
+		result = struppercmp (line1, line2);
+	else
+		result = strcmp (line1, line2);
+	return (boolean) (result >= 0);
+}
+
+/*  Checks that the pseudo tags of a file being merged agree with the
+ *  tag file, returning TRUE if the line is one of MergedPseudoTags.
+ */
+static boolean checkMergedPseudoTag (
+		const mergeInput *const input, const char *const line)
+{
+	const size_t count = sizeof (MergedPseudoTags) / sizeof (MergedPseudoTags [0]);
+	const char sorted = Option.sorted == SO_FOLDSORTED ? '2' : '1';
+	boolean result = FALSE;
+	size_t i;
+
+	for (i = 0  ;  ! result  &&  i < count  ;  ++i)
+		if (strncmp (line, MergedPseudoTags [i],
+					strlen (MergedPseudoTags [i])) == 0)
+			result = TRUE;
+	if (result)
+	{
+		const char *const value = strchr (line, '\t') + 1;
+
+		if (strncmp (line, "!_TAG_FILE_SORTED", 17) == 0  &&  *value != sorted)
+		{
+			if (*value == '1'  ||  *value == '2')
+				error (FATAL, "\"%s\" is sorted %s; use --sort=%s",
+					input->name, *value == '2' ? "ignoring case" : "by case",
+					*value == '2' ? "foldcase" : "yes");
+			else
+				error (FATAL, "\"%s\" is not sorted", input->name);
+		}
+		else if (strncmp (line, "!_TAG_FILE_FORMAT", 17) == 0  &&
+				 (unsigned int) atoi (value) > Option.tagFileFormat)
+		{
+			error (FATAL, "\"%s\" has format %d; use --format=%d",
+				input->name, atoi (value), atoi (value));
+		}
+	}
+	return result;
+}
+
+/*  Reads the next tag line of a file being merged, returning FALSE at the
+ *  end of the file.
+ */
+static boolean readMergedLine (mergeInput *const input)
+{
+	const char *line;
+
+	do
+	{
+		line = readLine (input->line, input->fp);
+		if (line != NULL)
+			++input->lineNumber;
+	} while (line != NULL  &&  (*line == '\0'  ||  strcmp (line, "\n") == 0  ||
+			 checkMergedPseudoTag (input, line)));
+
+	if (line != NULL  &&  line [strlen (line) - 1] != '\n')
+	{
+		/*  Terminate the last line of a file lacking a final newline. */
+		vStringPut (input->line, '\n');
+	}
+	return (boolean) (line != NULL);
+}
+
+static boolean isMergedBefore (
+		const mergeInput *const inputs, const unsigned int a, const unsigned int b)
+{
+	const char *const line1 = vStringValue (inputs [a].line);
+	const char *const line2 = vStringValue (inputs [b].line);
+	const int result = compareMergedLines (line1, line2);
+
+	return (boolean) (result < 0  ||  (result == 0  &&  a < b));
+}
+
+static void siftMergeHeap (const mergeInput *const inputs,
+		unsigned int *const heap, const unsigned int count, unsigned int i)
+{
+	for (;;)
+	{
+		const unsigned int left = 2 * i + 1;
+		unsigned int least = i;
+		unsigned int temp;
+
+		if (left < count  &&  isMergedBefore (inputs, heap [left], heap [least]))
+			least = left;
+		if (left + 1 < count  &&
+				isMergedBefore (inputs, heap [left + 1], heap [least]))
+			least = left + 1;
+		if (least == i)
+			break;
+		temp = heap [i];
+		heap [i] = heap [least];
+		heap [least] = temp;
+		i = least;
+	}
+}
+
+/*  Writes the tag lines of the files named to `fp' in sorted order,
+ *  dropping identical lines. Each file must be sorted the way the tag file
+ *  is to be sorted.
+ */
+extern void mergeSortedTags (const stringList *const files, FILE *const fp)
+{
+	const unsigned int fileCount = stringListCount (files);
+	mergeInput *const inputs = xMalloc (fileCount, mergeInput);
+	unsigned int *const heap = xMalloc (fileCount, unsigned int);
+	vString *const previous = vStringNew ();
+	unsigned int count = 0;
+	unsigned int i;
+
+	for (i = 0  ;  i < fileCount  ;  ++i)
+	{
+		mergeInput *const input = &inputs [i];
+
+		input->name = vStringValue (stringListItem (files, i));
+		input->fp = fopen (input->name, "r");
+		if (input->fp == NULL)
+			error (FATAL | PERROR, "cannot open \"%s\"", input->name);
+		input->line = vStringNew ();
+		input->lineNumber = 0;
+		verbose ("merging %s\n", input->name);
+		if (readMergedLine (input))
+			heap [count++] = i;
+	}
+	for (i = count / 2  ;  i > 0  ;  --i)
+		siftMergeHeap (inputs, heap, count, i - 1);
+
+	while (count > 0)
+	{
+		mergeInput *const input = &inputs [heap [0]];
+
+		if (vStringLength (previous) > 0  &&
+			strcmp (vStringValue (input->line), vStringValue (previous)) == 0)
+		{
+			++TagFile.numTags.duplicate;
+		}
+		else
+		{
+			if (fputs (vStringValue (input->line), fp) == EOF)
+				error (FATAL | PERROR, "cannot write tag file");
+			vStringCopy (previous, input->line);
+			++TagFile.numTags.added;
+		}
+		if (! readMergedLine (input))
+			heap [0] = heap [--count];
+		else if (! isMergedInOrder (vStringValue (input->line),
+					vStringValue (previous)))
+		{
+			error (FATAL, "\"%s\" is not sorted (line %lu)",
+				input->name, input->lineNumber);
+		}
+		siftMergeHeap (inputs, heap, count, 0);
+	}
+
+	for (i = 0  ;  i < fileCount  ;  ++i)
+	{
+		fclose (inputs [i].fp);
+		vStringDelete (inputs [i].line);
+	}
+	vStringDelete (previous);
+	eFree (heap);
+	eFree (inputs);
+}
+
 /* vi:set tabstop=4 shiftwidth=4: */
@@ -16,10 +16,15 @@
 */
 #include "general.h"  /* must always come first */
 
+#include <stdio.h>
+
+#include "strlist.h"
+
 /*
 *   FUNCTION PROTOTYPES
 */
 extern void catFile (const char *const name);
+extern void mergeSortedTags (const stringList *const files, FILE *const fp);
 
 #ifdef EXTERNAL_SORT
 extern void externalSortTags (const boolean toStdout);
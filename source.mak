@@ -5,7 +5,7 @@
 HEADERS = \
 	args.h ctags.h debug.h entry.h general.h get.h keyword.h \
 	main.h options.h parse.h parsers.h read.h routines.h sort.h \
-	strlist.h vstring.h
+	strlist.h tagbinary.h tagcache.h tagindex.h trace.h vstring.h
 
 SOURCES = \
 	args.c \
@@ -54,8 +54,12 @@ SOURCES = \
 	sort.c \
 	sql.c \
 	strlist.c \
+	tagbinary.c \
+	tagcache.c \
+	tagindex.c \
 	tcl.c \
 	tex.c \
+	trace.c \
 	verilog.c \
 	vhdl.c \
 	vim.c \
@@ -119,8 +123,12 @@ OBJECTS = \
 	sort.$(OBJEXT) \
 	sql.$(OBJEXT) \
 	strlist.$(OBJEXT) \
+	tagbinary.$(OBJEXT) \
+	tagcache.$(OBJEXT) \
+	tagindex.$(OBJEXT) \
 	tcl.$(OBJEXT) \
 	tex.$(OBJEXT) \
+	trace.$(OBJEXT) \
 	verilog.$(OBJEXT) \
 	vhdl.$(OBJEXT) \
 	vim.$(OBJEXT) \
@@ -2348,7 +2348,10 @@ static void initialize (const langType language)
 static void findSqlTags (void)
 {
 	tokenInfo *const token = newToken ();
-	exception_t exception = (exception_t) (setjmp (Exception));
+	exception_t exception;
+
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
+	exception = (exception_t) (setjmp (Exception));
 
 	while (exception == ExceptionNone)
 		parseSqlFile (token);
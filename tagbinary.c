@@ -0,0 +1,547 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to convert a sorted tag file into a binary
+*   tag file (see tagbinary.h for its format).
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <string.h>
+#include <stdio.h>
+
+#include "debug.h"
+#include "options.h"
+#include "read.h"
+#include "routines.h"
+#include "tagbinary.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sByteBuffer {
+	unsigned char *data;
+	unsigned long length;
+	unsigned long max;
+} byteBuffer;
+
+/*  Distinct strings, each numbered in the order first added.  */
+typedef struct sStringTable {
+	byteBuffer strings;     /* null terminated strings */
+	unsigned long *offset;  /* offset of each string within `strings' */
+	unsigned long count;
+	unsigned long max;
+	unsigned long *bucket;  /* hash table of string numbers plus one */
+	unsigned long buckets;
+} stringTable;
+
+typedef struct sBinaryWriter {
+	FILE *fp;
+	byteBuffer block;       /* records of the block being assembled */
+	unsigned int records;   /* number of records in `block' */
+	byteBuffer previous;    /* name of the last record in `block' */
+	byteBuffer index;       /* offset of each block written */
+	unsigned long blocks;   /* number of blocks written */
+	stringTable files;
+	stringTable keys;
+	stringTable values;
+} binaryWriter;
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern boolean isBinaryTagLine (const char *const line)
+{
+	return (boolean) (strncmp (line, TAG_BINARY_MAGIC,
+			strlen (TAG_BINARY_MAGIC)) == 0);
+}
+
+static void addBytes (byteBuffer *const buffer,
+		const void *const bytes, const unsigned long length)
+{
+	if (buffer->length + length > buffer->max)
+	{
+		if (buffer->max == 0)
+			buffer->max = 1024;
+		while (buffer->length + length > buffer->max)
+			buffer->max *= 2;
+		buffer->data = xRealloc (buffer->data, buffer->max, unsigned char);
+	}
+	if (length > 0)
+		memcpy (buffer->data + buffer->length, bytes, (size_t) length);
+	buffer->length += length;
+}
+
+static void addByte (byteBuffer *const buffer, const int c)
+{
+	const unsigned char byte = (unsigned char) c;
+	addBytes (buffer, &byte, 1);
+}
+
+static void addVarint (byteBuffer *const buffer, const unsigned long value)
+{
+	unsigned long remaining = value;
+	while (remaining >= 0x80)
+	{
+		addByte (buffer, (int) ((remaining & 0x7f) | 0x80));
+		remaining >>= 7;
+	}
+	addByte (buffer, (int) remaining);
+}
+
+static void addFixed (byteBuffer *const buffer, const unsigned long value,
+		const unsigned int width)
+{
+	unsigned long remaining = value;
+	unsigned int i;
+
+	for (i = 0  ;  i < width  ;  ++i)
+	{
+		addByte (buffer, (int) (remaining & 0xff));
+		if (i < sizeof (remaining) - 1)
+			remaining >>= 8;
+		else
+			remaining = 0;
+	}
+}
+
+static void addString (byteBuffer *const buffer,
+		const char *const string, const size_t length)
+{
+	addBytes (buffer, string, length);
+	addByte (buffer, '\0');
+}
+
+static void freeBuffer (byteBuffer *const buffer)
+{
+	if (buffer->data != NULL)
+		eFree (buffer->data);
+	buffer->data = NULL;
+	buffer->length = 0;
+	buffer->max = 0;
+}
+
+/*
+ *  String tables
+ */
+
+static unsigned long hashString (const char *const string, const size_t length)
+{
+	unsigned long hash = 2166136261UL;
+	size_t i;
+	for (i = 0  ;  i < length  ;  ++i)
+		hash = ((hash ^ (unsigned char) string [i]) * 16777619UL) & 0xffffffffUL;
+	return hash;
+}
+
+static void insertBucket (stringTable *const table, const unsigned long number)
+{
+	const char *const string = (const char *) table->strings.data +
+			table->offset [number];
+	unsigned long i = hashString (string, strlen (string)) % table->buckets;
+	while (table->bucket [i] != 0)
+		i = (i + 1) % table->buckets;
+	table->bucket [i] = number + 1;
+}
+
+static void growBuckets (stringTable *const table)
+{
+	unsigned long i;
+	if (table->bucket != NULL)
+		eFree (table->bucket);
+	table->buckets = (table->buckets == 0) ? 256 : 2 * table->buckets;
+	table->bucket = xCalloc (table->buckets, unsigned long);
+	for (i = 0  ;  i < table->count  ;  ++i)
+		insertBucket (table, i);
+}
+
+/*  Returns the number of the string, adding it to the table if new.  */
+static unsigned long tableString (stringTable *const table,
+		const char *const string, const size_t length)
+{
+	unsigned long i;
+	unsigned long number;
+
+	if (2 * (table->count + 1) > table->buckets)
+		growBuckets (table);
+	i = hashString (string, length) % table->buckets;
+	while (table->bucket [i] != 0)
+	{
+		const char *const s = (const char *) table->strings.data +
+				table->offset [table->bucket [i] - 1];
+		if (strncmp (s, string, length) == 0  &&  s [length] == '\0')
+			return table->bucket [i] - 1;
+		i = (i + 1) % table->buckets;
+	}
+	if (table->count == table->max)
+	{
+		table->max = (table->max == 0) ? 256 : 2 * table->max;
+		table->offset = xRealloc (table->offset, table->max, unsigned long);
+	}
+	number = table->count++;
+	table->offset [number] = table->strings.length;
+	addString (&table->strings, string, length);
+	table->bucket [i] = number + 1;
+	return number;
+}
+
+static void freeTable (stringTable *const table)
+{
+	freeBuffer (&table->strings);
+	if (table->offset != NULL)
+		eFree (table->offset);
+	if (table->bucket != NULL)
+		eFree (table->bucket);
+	memset (table, 0, sizeof (stringTable));
+}
+
+/*
+ *  Records
+ */
+
+/*  Returns whether a string is a number which reads back the same way.  */
+static boolean isNumber (const char *const string, const size_t length)
+{
+	boolean result = (boolean) (length > 0  &&  length <= 9  &&
+			(length == 1  ||  string [0] != '0'));
+	size_t i;
+	for (i = 0  ;  result  &&  i < length  ;  ++i)
+		result = (boolean) (string [i] >= '0'  &&  string [i] <= '9');
+	return result;
+}
+
+static unsigned long numberValue (const char *const string, const size_t length)
+{
+	unsigned long result = 0;
+	size_t i;
+	for (i = 0  ;  i < length  ;  ++i)
+		result = 10 * result + (unsigned long) (string [i] - '0');
+	return result;
+}
+
+/*  Returns the end of the address of a tag line, found as readtags finds it,
+ *  or NULL if it has none.
+ */
+static const char *endOfAddress (const char *const address,
+		const char *const end)
+{
+	const char *p = address;
+
+	if (p < end  &&  (*p == '/'  ||  *p == '?'))
+	{
+		const char delimiter = *p;
+		do
+		{
+			p = memchr (p + 1, delimiter, (size_t) (end - p - 1));
+		} while (p != NULL  &&  *(p - 1) == '\\');
+		if (p != NULL)
+			++p;
+	}
+	else
+	{
+		while (p < end  &&  *p >= '0'  &&  *p <= '9')
+			++p;
+		if (p == address)
+			p = NULL;
+	}
+	return p;
+}
+
+/*  Determines whether the text following an address is ";\"" and a list of
+ *  extension fields which can be stored separately, counting them.
+ */
+static boolean hasFields (const char *const start, const char *const end,
+		unsigned long *const count)
+{
+	boolean result = FALSE;
+
+	*count = 0;
+	if (end - start >= 2  &&  start [0] == ';'  &&  start [1] == '"')
+	{
+		const char *p = start + 2;
+		result = TRUE;
+		while (result  &&  p < end)
+		{
+			if (*p != '\t'  ||  p + 1 == end  ||  p [1] == '\t')
+				result = FALSE;
+			else
+			{
+				const char *const tab = memchr (p + 1, '\t',
+						(size_t) (end - p - 1));
+				p = (tab == NULL) ? end : tab;
+				++*count;
+			}
+		}
+	}
+	if (! result)
+		*count = 0;
+	return result;
+}
+
+static void addName (binaryWriter *const writer,
+		const char *const name, const size_t length)
+{
+	size_t prefix = 0;
+
+	while (prefix < length  &&  prefix < writer->previous.length  &&
+			writer->previous.data [prefix] == (unsigned char) name [prefix])
+		++prefix;
+	addVarint (&writer->block, prefix);
+	addVarint (&writer->block, length - prefix);
+	addBytes (&writer->block, name + prefix, length - prefix);
+	writer->previous.length = 0;
+	addBytes (&writer->previous, name, length);
+}
+
+static void addField (binaryWriter *const writer,
+		const char *const field, const size_t length)
+{
+	byteBuffer *const block = &writer->block;
+	const char *const colon = memchr (field, ':', length);
+
+	if (colon == NULL)
+	{
+		addVarint (block, 0);
+		addVarint (block, tableString (&writer->values, field, length) + 2);
+	}
+	else
+	{
+		const size_t keyLength = colon - field;
+		const char *const value = colon + 1;
+		const size_t valueLength = length - keyLength - 1;
+
+		addVarint (block, tableString (&writer->keys, field, keyLength) + 1);
+		if (keyLength == 9  &&  strncmp (field, "signature", keyLength) == 0)
+		{
+			/*  rarely shared, so not worth a table entry  */
+			addVarint (block, 0);
+			addString (block, value, valueLength);
+		}
+		else if (isNumber (value, valueLength))
+		{
+			addVarint (block, 1);
+			addVarint (block, numberValue (value, valueLength));
+		}
+		else
+			addVarint (block, tableString (&writer->values, value, valueLength) + 2);
+	}
+}
+
+static void addRecord (binaryWriter *const writer,
+		const char *const line, const size_t length)
+{
+	byteBuffer *const block = &writer->block;
+	const char *const end = line + length;
+	const char *const tab1 = memchr (line, '\t', length);
+	const char *tab2 = NULL;
+
+	if (tab1 != NULL)
+		tab2 = memchr (tab1 + 1, '\t', (size_t) (end - tab1 - 1));
+	if (tab1 == NULL  ||  tab1 == line  ||  tab2 == NULL)
+	{
+		/*  not a tag line; kept as it is  */
+		addName (writer, line, length);
+		addVarint (block, 0);
+	}
+	else
+	{
+		const char *const address = tab2 + 1;
+		const char *addressEnd = endOfAddress (address, end);
+		unsigned long fieldCount = 0;
+		boolean fields = FALSE;
+
+		if (addressEnd != NULL)
+			fields = hasFields (addressEnd, end, &fieldCount);
+		if (! fields)
+			addressEnd = end;
+
+		addName (writer, line, (size_t) (tab1 - line));
+		addVarint (block, tableString (&writer->files, tab1 + 1,
+				(size_t) (tab2 - tab1 - 1)) + 1);
+		if (isNumber (address, (size_t) (addressEnd - address)))
+			addVarint (block, numberValue (address,
+					(size_t) (addressEnd - address)) + 1);
+		else
+		{
+			addVarint (block, 0);
+			addString (block, address, (size_t) (addressEnd - address));
+		}
+		addVarint (block, 2 * fieldCount + (fields ? 1 : 0));
+		if (fields)
+		{
+			const char *p = addressEnd + 2;
+			while (p < end)
+			{
+				const char *const field = p + 1;
+				const char *const tab = memchr (field, '\t',
+						(size_t) (end - field));
+				p = (tab == NULL) ? end : tab;
+				addField (writer, field, (size_t) (p - field));
+			}
+		}
+	}
+	++writer->records;
+}
+
+static void writeBlock (binaryWriter *const writer)
+{
+	if (writer->records > 0)
+	{
+		byteBuffer count;
+
+		memset (&count, 0, sizeof (count));
+		addVarint (&count, writer->records);
+		addFixed (&writer->index, (unsigned long) ftell (writer->fp), 8);
+		fwrite (count.data, (size_t) 1, (size_t) count.length, writer->fp);
+		fwrite (writer->block.data, (size_t) 1, (size_t) writer->block.length,
+				writer->fp);
+		freeBuffer (&count);
+		++writer->blocks;
+	}
+	writer->block.length = 0;
+	writer->previous.length = 0;
+	writer->records = 0;
+}
+
+static void writeTable (FILE *const fp, const stringTable *const table)
+{
+	byteBuffer header;
+	unsigned long i;
+
+	memset (&header, 0, sizeof (header));
+	addFixed (&header, table->count, 4);
+	addFixed (&header, table->strings.length, 4);
+	for (i = 0  ;  i < table->count  ;  ++i)
+		addFixed (&header, table->offset [i], 4);
+	fwrite (header.data, (size_t) 1, (size_t) header.length, fp);
+	if (table->strings.length > 0)
+		fwrite (table->strings.data, (size_t) 1,
+				(size_t) table->strings.length, fp);
+	freeBuffer (&header);
+}
+
+/*  Writes the tag lines read from `textFp' as records, after the pseudo-tag
+ *  lines at its start.
+ */
+static void writeBinary (binaryWriter *const writer, FILE *const textFp)
+{
+	FILE *const fp = writer->fp;
+	vString *const line = vStringNew ();
+	unsigned long blocksOffset = 0;
+	unsigned long offset [5];
+	boolean pseudo = TRUE;
+	byteBuffer header;
+	int i;
+
+	memset (&header, 0, sizeof (header));
+	for (i = 0  ;  i < TAG_BINARY_HEADER_SIZE  ;  ++i)
+		putc ('\0', fp);
+	while (readLine (line, textFp) != NULL)
+	{
+		vStringStripNewline (line);
+		if (pseudo  &&  strncmp (vStringValue (line), "!_", (size_t) 2) == 0)
+			fprintf (fp, "%s\n", vStringValue (line));
+		else
+		{
+			if (pseudo)
+				blocksOffset = (unsigned long) ftell (fp);
+			pseudo = FALSE;
+			if (writer->records == TAG_BINARY_BLOCK_SIZE)
+				writeBlock (writer);
+			addRecord (writer, vStringValue (line), vStringLength (line));
+		}
+	}
+	if (pseudo)
+		blocksOffset = (unsigned long) ftell (fp);
+	writeBlock (writer);
+	offset [0] = (unsigned long) ftell (fp);
+	if (writer->index.length > 0)
+		fwrite (writer->index.data, (size_t) 1, (size_t) writer->index.length, fp);
+	offset [1] = (unsigned long) ftell (fp);
+	writeTable (fp, &writer->files);
+	offset [2] = (unsigned long) ftell (fp);
+	writeTable (fp, &writer->keys);
+	offset [3] = (unsigned long) ftell (fp);
+	writeTable (fp, &writer->values);
+	offset [4] = (unsigned long) ftell (fp);
+
+	addBytes (&header, TAG_BINARY_MAGIC, strlen (TAG_BINARY_MAGIC));
+	addFixed (&header, TAG_BINARY_VERSION, 4);
+	addFixed (&header, TAG_BINARY_BLOCK_SIZE, 4);
+	addFixed (&header, blocksOffset, 8);
+	addFixed (&header, offset [0], 8);
+	addFixed (&header, offset [1], 8);
+	addFixed (&header, offset [2], 8);
+	addFixed (&header, offset [3], 8);
+	addFixed (&header, writer->blocks, 8);
+	addFixed (&header, offset [4], 8);
+	Assert (header.length == TAG_BINARY_HEADER_SIZE);
+	fseek (fp, 0L, SEEK_SET);
+	fwrite (header.data, (size_t) 1, (size_t) header.length, fp);
+	freeBuffer (&header);
+	vStringDelete (line);
+}
+
+/*  Replaces the sorted tag file just written with its binary form.
+ */
+extern void writeBinaryTagFile (const char *const tagFileName)
+{
+	char *const tempName = xMalloc (strlen (tagFileName) + 2, char);
+	FILE *const textFp = fopen (tagFileName, "rb");
+
+	sprintf (tempName, "%s~", tagFileName);
+	if (textFp == NULL)
+		error (WARNING | PERROR, "cannot read \"%s\" to convert it", tagFileName);
+	else
+	{
+		binaryWriter writer;
+
+		verbose ("writing binary tag file %s\n", tagFileName);
+		memset (&writer, 0, sizeof (writer));
+		writer.fp = fopen (tempName, "wb");
+		if (writer.fp == NULL)
+		{
+			error (WARNING | PERROR, "cannot open \"%s\"", tempName);
+			fclose (textFp);
+		}
+		else
+		{
+			writeBinary (&writer, textFp);
+			fclose (textFp);
+			if (fclose (writer.fp) != 0)
+			{
+				error (WARNING | PERROR, "cannot write \"%s\"", tempName);
+				remove (tempName);
+			}
+			else if (rename (tempName, tagFileName) != 0)
+			{
+				/*  Some hosts cannot rename onto an existing file.  */
+				remove (tagFileName);
+				if (rename (tempName, tagFileName) != 0)
+				{
+					error (WARNING | PERROR, "cannot rename \"%s\"", tempName);
+					remove (tempName);
+				}
+			}
+		}
+		freeBuffer (&writer.block);
+		freeBuffer (&writer.previous);
+		freeBuffer (&writer.index);
+		freeTable (&writer.files);
+		freeTable (&writer.keys);
+		freeTable (&writer.values);
+	}
+	eFree (tempName);
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
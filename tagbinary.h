@@ -0,0 +1,69 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to tagbinary.c
+*
+*   A binary tag file holds the same tags as a sorted ctags format tag file,
+*   in less space. The readtags library reads either kind of file. Fixed size
+*   values are stored little-endian; a varint is stored seven bits to a byte,
+*   least significant first, with the high bit set on all but the last byte.
+*
+*       header   magic "CTAGSBIN" (8 bytes)
+*                version, records per block (4 bytes each)
+*                offsets of the blocks, the block index, and the file name,
+*                key and value tables; number of blocks; size of the file
+*                (8 bytes each)
+*       pseudo   the pseudo-tag lines, as text
+*       blocks   each a varint count of records, then the records
+*       index    offset of each block (8 bytes each)
+*       tables   count of strings and their total size, offset of each
+*                string (4 bytes each), then the null terminated strings
+*
+*   Each record is a tag line, stored as varints and null terminated strings:
+*
+*       name     length shared with the name of the previous record in the
+*                block, then length and characters of the remainder (not
+*                null terminated)
+*       file     file name table entry plus one; zero stores the whole line
+*                in place of the name, and nothing else follows
+*       address  line number plus one; zero is followed by the address as
+*                a string
+*       fields   twice the count of extension fields, plus one if the
+*                address is followed by ";\""; then for each field the key
+*                table entry plus one (zero for a field without a key) and
+*                a value: zero followed by a string, one followed by a
+*                number, or the value table entry plus two
+*
+*   Records are in the order of the tag file from which they were written,
+*   so the first record of each block allows a binary search of the blocks.
+*/
+#ifndef _TAGBINARY_H
+#define _TAGBINARY_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   MACROS
+*/
+#define TAG_BINARY_MAGIC        "CTAGSBIN"
+#define TAG_BINARY_VERSION      1
+#define TAG_BINARY_HEADER_SIZE  72
+#define TAG_BINARY_BLOCK_SIZE   64  /* records per block */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean isBinaryTagLine (const char *const line);
+extern void writeBinaryTagFile (const char *const tagFileName);
+
+#endif  /* _TAGBINARY_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,812 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to reuse the tags of source files from a
+*   cache of tags made earlier (see tagcache.h for its layout).
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#if defined (HAVE_STDLIB_H)
+# include <stdlib.h>  /* to declare strtoul () */
+#endif
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <errno.h>
+#ifdef HAVE_UNISTD_H
+# include <unistd.h>  /* to declare getpid () */
+#endif
+#if defined (HAVE_SYS_TYPES_H)
+# include <sys/types.h>
+#endif
+#ifdef HAVE_SYS_STAT_H
+# include <sys/stat.h>  /* to declare mkdir () */
+#endif
+#ifdef HAVE_DIRECT_H
+# include <direct.h>  /* to declare mkdir () */
+#endif
+
+#include "ctags.h"
+#include "debug.h"
+#include "entry.h"
+#include "main.h"
+#include "options.h"
+#include "parse.h"
+#include "read.h"
+#include "routines.h"
+#include "tagcache.h"
+#include "trace.h"
+#include "vstring.h"
+
+/*
+*   MACROS
+*/
+#define KEY_LENGTH  32  /* hexadecimal digits in a cache key */
+
+/*  Cache keys are MurmurHash3_x86_128 hashes, with a seed of zero.
+ */
+#define MURMUR_C1  0x239b961bUL
+#define MURMUR_C2  0xab0e9789UL
+#define MURMUR_C3  0x38b34ae5UL
+#define MURMUR_C4  0xa1e38b93UL
+
+#define rotate32(x,n)  ((((x) << (n)) | ((x) >> (32 - (n)))) & 0xffffffffUL)
+#define mixLane(k,n,c1,c2)  \
+	((rotate32 (((k) * (c1)) & 0xffffffffUL, n) * (c2)) & 0xffffffffUL)
+#define littleEndian32(p)  \
+	((unsigned long) (p) [0]         | ((unsigned long) (p) [1] << 8) | \
+	 ((unsigned long) (p) [2] << 16) | ((unsigned long) (p) [3] << 24))
+
+#if defined (WIN32) || defined (MSDOS)
+# define makeDirectory(path)  mkdir (path)
+#else
+# define makeDirectory(path)  mkdir (path, 0777)
+#endif
+
+#ifdef HAVE_UNISTD_H
+# define processId()  ((unsigned long) getpid ())
+#else
+# define processId()  0UL
+#endif
+
+/*  Flags of a tag record.
+ */
+#define RECORD_LINE_NUMBER  0x1
+#define RECORD_FILE_SCOPE   0x2
+#define RECORD_FILE_ENTRY   0x4
+#define RECORD_TRUNCATE     0x8
+
+#define RECORD_STRINGS  12  /* number of string fields of a tag record */
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sCacheBuffer {
+	char *buffer;
+	size_t length;
+	size_t max;
+} cacheBuffer;
+
+typedef struct sKeyHash {
+	unsigned long h [4];         /* state of each 32 bit lane */
+	unsigned char block [16];    /* bytes not yet making a whole block */
+	size_t pending;              /* number of bytes in block */
+	unsigned long length;        /* number of bytes hashed */
+} keyHash;
+
+typedef struct sCacheReader {
+	const char *next;  /* next byte of entry to read */
+	const char *end;   /* end of entry */
+	boolean valid;     /* has every field read so far been well formed? */
+	boolean renumber;  /* are anonymous names to be renumbered? */
+	unsigned int renumbered;  /* number of Renumbered strings in use */
+} cacheReader;
+
+/*
+*   DATA DEFINITIONS
+*/
+
+/*  State of the cache for the file being tagged.
+ */
+static struct sTagCache {
+	boolean disabled;     /* was an entry unable to be written? */
+	boolean recording;    /* are the tags being made recorded? */
+	boolean uncacheable;  /* was a tag made which cannot be cached? */
+	char key [KEY_LENGTH + 1];  /* key of file, in hexadecimal */
+	unsigned long size;   /* size of file in bytes */
+	unsigned long lines;  /* number of lines in file */
+	unsigned int anonymousBase;  /* anonymous names made before the file */
+	cacheBuffer entry;    /* entry read for file, or being recorded */
+	size_t checkpoint;    /* length of entry at checkpointTagCache () */
+	unsigned long hits;   /* number of files whose tags were read */
+} Cache = { FALSE, FALSE, FALSE, "", 0, 0, 0, { NULL, 0, 0 }, 0, 0 };
+
+/*  Fields of the tag record being read whose anonymous names have been
+ *  renumbered.
+ */
+static vString *Renumbered [RECORD_STRINGS];
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*
+ *  Cache keys
+ */
+
+/*  Mixes one 16 byte block into a MurmurHash3_x86_128 state.
+ */
+static void hashBlock (unsigned long *const h, const unsigned char *const block)
+{
+	unsigned long k [4];
+	int i;
+
+	for (i = 0  ;  i < 4  ;  ++i)
+		k [i] = littleEndian32 (block + 4 * i);
+
+	h [0] ^= mixLane (k [0], 15, MURMUR_C1, MURMUR_C2);
+	h [0] = (rotate32 (h [0], 19) + h [1]) & 0xffffffffUL;
+	h [0] = (h [0] * 5 + 0x561ccd1bUL) & 0xffffffffUL;
+
+	h [1] ^= mixLane (k [1], 16, MURMUR_C2, MURMUR_C3);
+	h [1] = (rotate32 (h [1], 17) + h [2]) & 0xffffffffUL;
+	h [1] = (h [1] * 5 + 0x0bcaa747UL) & 0xffffffffUL;
+
+	h [2] ^= mixLane (k [2], 17, MURMUR_C3, MURMUR_C4);
+	h [2] = (rotate32 (h [2], 15) + h [3]) & 0xffffffffUL;
+	h [2] = (h [2] * 5 + 0x96cd1c35UL) & 0xffffffffUL;
+
+	h [3] ^= mixLane (k [3], 18, MURMUR_C4, MURMUR_C1);
+	h [3] = (rotate32 (h [3], 13) + h [0]) & 0xffffffffUL;
+	h [3] = (h [3] * 5 + 0x32ac3b17UL) & 0xffffffffUL;
+}
+
+/*  Adds bytes to a key hash, keeping any incomplete block for later.
+ */
+static void hashBytes (
+		keyHash *const hash, const unsigned char *bytes, size_t length)
+{
+	hash->length += length;
+	if (hash->pending > 0)
+	{
+		size_t count = sizeof (hash->block) - hash->pending;
+		if (count > length)
+			count = length;
+		memcpy (hash->block + hash->pending, bytes, count);
+		hash->pending += count;
+		bytes += count;
+		length -= count;
+		if (hash->pending < sizeof (hash->block))
+			return;
+		hashBlock (hash->h, hash->block);
+		hash->pending = 0;
+	}
+	for (  ;  length >= sizeof (hash->block)  ;  length -= sizeof (hash->block))
+	{
+		hashBlock (hash->h, bytes);
+		bytes += sizeof (hash->block);
+	}
+	memcpy (hash->block, bytes, length);
+	hash->pending = length;
+}
+
+static unsigned long finishLane (unsigned long h)
+{
+	h = ((h ^ (h >> 16)) * 0x85ebca6bUL) & 0xffffffffUL;
+	h = ((h ^ (h >> 13)) * 0xc2b2ae35UL) & 0xffffffffUL;
+	return h ^ (h >> 16);
+}
+
+/*  Completes a key hash, writing it to `key' as 32 hexadecimal digits.
+ */
+static void finishHash (keyHash *const hash, char *const key)
+{
+	static const unsigned long constants [5] = {
+		MURMUR_C1, MURMUR_C2, MURMUR_C3, MURMUR_C4, MURMUR_C1
+	};
+	static const int rotations [4] = { 15, 16, 17, 18 };
+	unsigned long *const h = hash->h;
+	int i;
+
+	memset (hash->block + hash->pending, 0,
+			sizeof (hash->block) - hash->pending);
+	for (i = 0  ;  i < 4  ;  ++i)
+		if (hash->pending > (size_t) (4 * i))
+			h [i] ^= mixLane (littleEndian32 (hash->block + 4 * i),
+					rotations [i], constants [i], constants [i + 1]);
+
+	for (i = 0  ;  i < 4  ;  ++i)
+		h [i] ^= hash->length & 0xffffffffUL;
+	h [0] = (h [0] + h [1] + h [2] + h [3]) & 0xffffffffUL;
+	for (i = 1  ;  i < 4  ;  ++i)
+		h [i] = (h [i] + h [0]) & 0xffffffffUL;
+	for (i = 0  ;  i < 4  ;  ++i)
+		h [i] = finishLane (h [i]);
+	h [0] = (h [0] + h [1] + h [2] + h [3]) & 0xffffffffUL;
+	for (i = 1  ;  i < 4  ;  ++i)
+		h [i] = (h [i] + h [0]) & 0xffffffffUL;
+
+	for (i = 0  ;  i < 4  ;  ++i)
+		sprintf (key + 8 * i, "%08lx", h [i]);
+}
+
+static void describeFlag (vString *const description, const boolean flag)
+{
+	vStringPut (description, flag ? '1' : '0');
+}
+
+/*  Appends to `description' everything other than the contents of the file
+ *  being tagged which affects the tags its parser makes. Options which only
+ *  affect how tags are written (e.g. --sort or --output-format) are left out,
+ *  since cached tags are written anew.
+ */
+static void describeTagging (
+		const langType language, vString *const description)
+{
+	const struct sExtFields *const fields = &Option.extensionFields;
+	unsigned int i;
+
+	vStringCatS (description, TAG_CACHE_MAGIC " " PROGRAM_VERSION "\n");
+	describeLanguage (language, description);
+	describeFlag (description, (boolean) isHeaderFile ());
+	describeFlag (description, fields->access);
+	describeFlag (description, fields->fileScope);
+	describeFlag (description, fields->implementation);
+	describeFlag (description, fields->inheritance);
+	describeFlag (description, fields->kind);
+	describeFlag (description, fields->kindKey);
+	describeFlag (description, fields->kindLong);
+	describeFlag (description, fields->language);
+	describeFlag (description, fields->lineNumber);
+	describeFlag (description, fields->scope);
+	describeFlag (description, fields->signature);
+	describeFlag (description, fields->typeRef);
+	describeFlag (description, Option.include.fileNames);
+	describeFlag (description, Option.include.qualifiedTags);
+	describeFlag (description, Option.include.fileScope);
+	describeFlag (description, Option.if0);
+	describeFlag (description, Option.lineDirectives);
+	vStringPut (description, '0' + (int) Option.locate);
+	vStringPut (description, '\n');
+	if (Option.ignore != NULL)
+		for (i = 0  ;  i < stringListCount (Option.ignore)  ;  ++i)
+		{
+			vStringCat (description, stringListItem (Option.ignore, i));
+			vStringPut (description, '\n');
+		}
+}
+
+/*  Computes the key of the file just opened for the current options,
+ *  leaving the file positioned at its start.
+ */
+static boolean computeKey (const langType language)
+{
+	keyHash hash = { { 0, 0, 0, 0 }, { 0 }, 0, 0 };
+	unsigned char buffer [BUFSIZ];
+	vString *const description = vStringNew ();
+	size_t length;
+	fpos_t start;
+	boolean result;
+
+	describeTagging (language, description);
+	hashBytes (&hash, (const unsigned char *) vStringValue (description),
+			vStringLength (description) + 1);
+	vStringDelete (description);
+
+	Cache.size = 0;
+	Cache.lines = 0;
+	fgetpos (File.fp, &start);
+	while ((length = fread (buffer, 1, sizeof (buffer), File.fp)) > 0)
+	{
+		const unsigned char *p = buffer;
+		const unsigned char *const end = buffer + length;
+
+		hashBytes (&hash, buffer, length);
+		Cache.size += length;
+		while ((p = memchr (p, '\n', (size_t) (end - p))) != NULL)
+		{
+			++Cache.lines;
+			++p;
+		}
+	}
+	result = (boolean) ! ferror (File.fp);
+	clearerr (File.fp);
+	fsetpos (File.fp, &start);
+
+	finishHash (&hash, Cache.key);
+	return result;
+}
+
+/*  Returns the path of the entry for the current key, or of its directory.
+ */
+static vString *entryPath (const boolean directory)
+{
+	vString *path;
+	char prefix [3];
+
+	prefix [0] = Cache.key [0];
+	prefix [1] = Cache.key [1];
+	prefix [2] = '\0';
+	path = combinePathAndFile (Option.cacheDirectory, prefix);
+	if (! directory)
+	{
+		vString *const file = combinePathAndFile (vStringValue (path),
+				Cache.key + 2);
+		vStringDelete (path);
+		path = file;
+	}
+	return path;
+}
+
+/*
+ *  Cache entries
+ */
+
+static void putBytes (
+		cacheBuffer *const entry, const char *const bytes, const size_t length)
+{
+	if (entry->length + length > entry->max)
+	{
+		if (entry->max == 0)
+			entry->max = BUFSIZ;
+		while (entry->length + length > entry->max)
+			entry->max *= 2;
+		entry->buffer = xRealloc (entry->buffer, entry->max, char);
+	}
+	memcpy (entry->buffer + entry->length, bytes, length);
+	entry->length += length;
+}
+
+static void putString (cacheBuffer *const entry, const char *const string)
+{
+	if (string == NULL)
+		putBytes (entry, "n", 1);
+	else
+	{
+		putBytes (entry, "s", 1);
+		putBytes (entry, string, strlen (string) + 1);
+	}
+}
+
+/*  Finds the next anonymous name in `string', returning a pointer to its
+ *  number, which is stored in `number', or NULL if there is none.
+ */
+static const char *findAnonymousName (
+		const char *const string, unsigned long *const number)
+{
+	const size_t length = strlen (ANONYMOUS_PREFIX);
+	const char *p = string;
+	const char *result = NULL;
+
+	while (result == NULL  &&  (p = strstr (p, ANONYMOUS_PREFIX)) != NULL)
+	{
+		p += length;
+		if (isdigit ((int) *p))
+		{
+			result = p;
+			*number = strtoul (p, NULL, 10);
+		}
+	}
+	return result;
+}
+
+/*  Writes a string field of a tag. Anonymous names are numbered across all
+ *  the files tagged, so any made for this file are written as an 'a' string
+ *  with their numbers relative to Cache.anonymousBase, to be renumbered when
+ *  the entry is read. A file whose tags name any other anonymous name (e.g.
+ *  one found in its source) cannot be cached, since it would be renumbered.
+ */
+static void putField (cacheBuffer *const entry, const char *const string)
+{
+	const char *digits;
+	unsigned long number;
+
+	if (string == NULL  ||  (digits = findAnonymousName (string, &number)) == NULL)
+		putString (entry, string);
+	else
+	{
+		const char *p = string;
+
+		putBytes (entry, "a", 1);
+		do
+		{
+			char relative [24];
+
+			if (number <= Cache.anonymousBase  ||  number > getAnonymousCount ())
+				Cache.uncacheable = TRUE;
+			sprintf (relative, "%lu", number - Cache.anonymousBase);
+			putBytes (entry, p, (size_t) (digits - p));
+			putBytes (entry, relative, strlen (relative));
+			p = digits;
+			while (isdigit ((int) *p))
+				++p;
+		} while ((digits = findAnonymousName (p, &number)) != NULL);
+		putBytes (entry, p, strlen (p) + 1);
+	}
+}
+
+static void putNumber (cacheBuffer *const entry, const unsigned long number)
+{
+	char digits [24];
+	sprintf (digits, "%lu", number);
+	putString (entry, digits);
+}
+
+static void putHeader (cacheBuffer *const entry)
+{
+	char number [24];
+	sprintf (number, "\t%d\t", TAG_CACHE_VERSION);
+	putBytes (entry, TAG_CACHE_MAGIC, strlen (TAG_CACHE_MAGIC));
+	putBytes (entry, number, strlen (number));
+	putBytes (entry, Cache.key, strlen (Cache.key));
+	sprintf (number, "\t%lu\n", Cache.size);
+	putBytes (entry, number, strlen (number));
+}
+
+static void putTagRecord (
+		cacheBuffer *const entry, const tagEntryInfo *const tag)
+{
+	unsigned long flags = 0;
+
+	if (tag->lineNumberEntry)  flags |= RECORD_LINE_NUMBER;
+	if (tag->isFileScope)      flags |= RECORD_FILE_SCOPE;
+	if (tag->isFileEntry)      flags |= RECORD_FILE_ENTRY;
+	if (tag->truncateLine)     flags |= RECORD_TRUNCATE;
+
+	putBytes (entry, "T", 1);
+	putField (entry, tag->name);
+	putField (entry, tag->kindName);
+	putNumber (entry, (unsigned long) (unsigned char) tag->kind);
+	putNumber (entry, flags);
+	putNumber (entry, tag->lineNumber);
+	putNumber (entry, getInputFileOffset (&tag->filePosition));
+	putField (entry, tag->language);
+	putField (entry, tag->extensionFields.access);
+	putField (entry, tag->extensionFields.fileScope);
+	putField (entry, tag->extensionFields.implementation);
+	putField (entry, tag->extensionFields.inheritance);
+	putField (entry, tag->extensionFields.scope [0]);
+	putField (entry, tag->extensionFields.scope [1]);
+	putField (entry, tag->extensionFields.signature);
+	putField (entry, tag->extensionFields.typeRef [0]);
+	putField (entry, tag->extensionFields.typeRef [1]);
+}
+
+/*  Renumbers the anonymous names of a string written by putField (),
+ *  following those made before the file being tagged.
+ */
+static const char *renumber (cacheReader *const reader, const char *string)
+{
+	vString *result;
+	const char *digits;
+	unsigned long number;
+
+	Assert (reader->renumbered < RECORD_STRINGS);
+	if (Renumbered [reader->renumbered] == NULL)
+		Renumbered [reader->renumbered] = vStringNew ();
+	result = Renumbered [reader->renumbered++];
+	vStringClear (result);
+	while ((digits = findAnonymousName (string, &number)) != NULL)
+	{
+		char absolute [24];
+
+		sprintf (absolute, "%lu", number + Cache.anonymousBase);
+		vStringNCatS (result, string, (size_t) (digits - string));
+		vStringCatS (result, absolute);
+		string = digits;
+		while (isdigit ((int) *string))
+			++string;
+	}
+	vStringCatS (result, string);
+	return vStringValue (result);
+}
+
+static const char *getString (cacheReader *const reader)
+{
+	const char *result = NULL;
+
+	if (reader->next < reader->end  &&  *reader->next == 'n')
+		++reader->next;
+	else if (reader->next < reader->end  &&
+			 (*reader->next == 's'  ||  *reader->next == 'a'))
+	{
+		const char *const string = reader->next + 1;
+		const char *const null = memchr (string, '\0',
+				(size_t) (reader->end - string));
+		if (null == NULL)
+			reader->valid = FALSE;
+		else
+		{
+			if (*reader->next == 'a'  &&  reader->renumber)
+				result = renumber (reader, string);
+			else
+				result = string;
+			reader->next = null + 1;
+		}
+	}
+	else
+		reader->valid = FALSE;
+	return result;
+}
+
+static unsigned long getNumber (cacheReader *const reader)
+{
+	const char *const digits = getString (reader);
+	unsigned long result = 0;
+
+	if (digits == NULL  ||  *digits == '\0')
+		reader->valid = FALSE;
+	else
+	{
+		char *end;
+		result = strtoul (digits, &end, 10);
+		if (*end != '\0')
+			reader->valid = FALSE;
+	}
+	return result;
+}
+
+/*  Reads the tag records of an entry, making a tag for each of them if
+ *  `make' is set, after which the anonymous names made for the file are
+ *  counted as made. Returns whether the whole entry is well formed.
+ */
+static boolean readTagRecords (
+		const cacheBuffer *const entry, const size_t start, const boolean make)
+{
+	cacheReader reader;
+	unsigned long anonymous;
+
+	reader.next = entry->buffer + start;
+	reader.end = entry->buffer + entry->length;
+	reader.valid = TRUE;
+	reader.renumber = make;
+	while (reader.valid  &&  reader.next < reader.end  &&  *reader.next == 'T')
+	{
+		tagEntryInfo tag;
+		unsigned long flags;
+		unsigned long offset;
+
+		++reader.next;
+		reader.renumbered = 0;
+		initTagEntry (&tag, NULL);
+		tag.name                           = getString (&reader);
+		tag.kindName                       = getString (&reader);
+		tag.kind                           = (char) getNumber (&reader);
+		flags                              = getNumber (&reader);
+		tag.lineNumber                     = getNumber (&reader);
+		offset                             = getNumber (&reader);
+		tag.language                       = getString (&reader);
+		tag.extensionFields.access         = getString (&reader);
+		tag.extensionFields.fileScope      = getString (&reader);
+		tag.extensionFields.implementation = getString (&reader);
+		tag.extensionFields.inheritance    = getString (&reader);
+		tag.extensionFields.scope [0]      = getString (&reader);
+		tag.extensionFields.scope [1]      = getString (&reader);
+		tag.extensionFields.signature      = getString (&reader);
+		tag.extensionFields.typeRef [0]    = getString (&reader);
+		tag.extensionFields.typeRef [1]    = getString (&reader);
+		if (tag.name == NULL)
+			reader.valid = FALSE;
+		else if (reader.valid  &&  make)
+		{
+			tag.lineNumberEntry = (boolean) ((flags & RECORD_LINE_NUMBER) != 0);
+			tag.isFileScope     = (boolean) ((flags & RECORD_FILE_SCOPE) != 0);
+			tag.isFileEntry     = (boolean) ((flags & RECORD_FILE_ENTRY) != 0);
+			tag.truncateLine    = (boolean) ((flags & RECORD_TRUNCATE) != 0);
+			fseek (File.fp, (long) offset, SEEK_SET);
+			fgetpos (File.fp, &tag.filePosition);
+			makeTagEntry (&tag);
+		}
+	}
+	if (reader.valid  &&  reader.next < reader.end  &&  *reader.next == 'E')
+	{
+		++reader.next;
+		anonymous = getNumber (&reader);
+		if (reader.valid  &&  make)
+			setAnonymousCount (Cache.anonymousBase + (unsigned int) anonymous);
+	}
+	else
+		reader.valid = FALSE;
+	return (boolean) (reader.valid  &&  reader.next == reader.end);
+}
+
+/*  Reads the entry for the current key into Cache.entry, returning the
+ *  length of its header if it is a valid entry for the key, or 0 otherwise.
+ */
+static size_t readEntry (const char *const path)
+{
+	FILE *const fp = fopen (path, "rb");
+	size_t result = 0;
+
+	Cache.entry.length = 0;
+	if (fp != NULL)
+	{
+		char buffer [BUFSIZ];
+		size_t length;
+		cacheBuffer header;
+
+		while ((length = fread (buffer, 1, sizeof (buffer), fp)) > 0)
+			putBytes (&Cache.entry, buffer, length);
+		if (! ferror (fp))
+		{
+			header.buffer = NULL;
+			header.length = header.max = 0;
+			putHeader (&header);
+			if (Cache.entry.length > header.length  &&
+				memcmp (Cache.entry.buffer, header.buffer, header.length) == 0 &&
+				readTagRecords (&Cache.entry, header.length, FALSE))
+			{
+				result = header.length;
+			}
+			else
+				verbose ("ignoring invalid tag cache entry %s\n", path);
+			eFree (header.buffer);
+		}
+		fclose (fp);
+	}
+	return result;
+}
+
+/*  Makes the tags of the file just opened from its entry in the cache, if
+ *  there is one. Otherwise, prepares to record the tags made by its parser
+ *  in a new entry. Returns whether the tags were made from the cache.
+ */
+extern boolean readTagCache (const langType language)
+{
+	boolean hit = FALSE;
+
+	Cache.recording = FALSE;
+	Cache.anonymousBase = getAnonymousCount ();
+	if (Option.cacheDirectory != NULL)
+	{
+		traceBegin ("cache", "cache lookup", vStringValue (File.name));
+		if (computeKey (language))
+		{
+			vString *const path = entryPath (FALSE);
+			const size_t start = readEntry (vStringValue (path));
+
+			if (start > 0)
+			{
+				verbose ("reading tags from cache entry %s\n", vStringValue (path));
+				readTagRecords (&Cache.entry, start, TRUE);
+				if (Option.printTotals)
+					addTotals (0, Cache.lines, 0L);
+				++Cache.hits;
+				hit = TRUE;
+			}
+			else if (! Cache.disabled)
+			{
+				Cache.entry.length = 0;
+				putHeader (&Cache.entry);
+				Cache.recording = TRUE;
+				Cache.uncacheable = FALSE;
+			}
+			vStringDelete (path);
+		}
+		traceEnd ();
+	}
+	return hit;
+}
+
+/*  Records a tag made by the parser of the file being tagged.
+ */
+extern void cacheTagEntry (const tagEntryInfo *const tag)
+{
+	if (Cache.recording  &&  ! Cache.uncacheable)
+	{
+		/*  Tags placed in another source file by #line directives cannot be
+		 *  relocated, so the tags of such a file are not cached.
+		 */
+		if (strcmp (getSourceFileName (), vStringValue (File.name)) != 0)
+			Cache.uncacheable = TRUE;
+		else
+			putTagRecord (&Cache.entry, tag);
+	}
+}
+
+/*  Records the tags recorded so far, so that rewindTagCache () may discard
+ *  those recorded afterwards.
+ */
+extern void checkpointTagCache (void)
+{
+	Cache.checkpoint = Cache.entry.length;
+}
+
+extern void rewindTagCache (void)
+{
+	if (Cache.recording)
+		Cache.entry.length = Cache.checkpoint;
+}
+
+/*  Stores the tags recorded for the file being tagged as its entry in the
+ *  cache. The entry is written under a temporary name and renamed into
+ *  place, so that processes sharing the cache never read a partial entry.
+ */
+extern void writeTagCache (void)
+{
+	if (Cache.recording  &&  ! Cache.uncacheable)
+	{
+		vString *const directory = entryPath (TRUE);
+		vString *const path = entryPath (FALSE);
+		vString *const temporary = vStringNew ();
+		char suffix [32];
+		boolean stored = FALSE;
+		FILE *fp;
+
+		sprintf (suffix, ".%lu.tmp", processId ());
+		vStringCopy (temporary, path);
+		vStringCatS (temporary, suffix);
+		putBytes (&Cache.entry, "E", 1);
+		putNumber (&Cache.entry, getAnonymousCount () - Cache.anonymousBase);
+
+		makeDirectory (Option.cacheDirectory);
+		makeDirectory (vStringValue (directory));
+		fp = fopen (vStringValue (temporary), "wb");
+		if (fp != NULL)
+		{
+			stored = (boolean) (fwrite (Cache.entry.buffer, 1,
+					Cache.entry.length, fp) == Cache.entry.length);
+			if (fclose (fp) != 0)
+				stored = FALSE;
+			if (stored  &&
+				rename (vStringValue (temporary), vStringValue (path)) != 0)
+			{
+				stored = FALSE;
+			}
+		}
+		if (stored)
+			verbose ("wrote tag cache entry %s\n", vStringValue (path));
+		else
+		{
+			const int errorNumber = errno;
+			remove (vStringValue (temporary));
+
+			/*  Another process may have stored the same entry meanwhile.
+			 */
+			if (! doesFileExist (vStringValue (path)))
+			{
+				errno = errorNumber;
+				error (WARNING | PERROR, "cannot write tag cache entry \"%s\"",
+						vStringValue (path));
+				error (WARNING, "tag cache will no longer be updated");
+				Cache.disabled = TRUE;
+			}
+		}
+		vStringDelete (temporary);
+		vStringDelete (path);
+		vStringDelete (directory);
+	}
+	Cache.recording = FALSE;
+}
+
+extern unsigned long tagCacheHits (void)
+{
+	return Cache.hits;
+}
+
+extern void freeTagCacheResources (void)
+{
+	unsigned int i;
+
+	for (i = 0  ;  i < RECORD_STRINGS  ;  ++i)
+		if (Renumbered [i] != NULL)
+		{
+			vStringDelete (Renumbered [i]);
+			Renumbered [i] = NULL;
+		}
+	if (Cache.entry.buffer != NULL)
+		eFree (Cache.entry.buffer);
+	Cache.entry.buffer = NULL;
+	Cache.entry.length = Cache.entry.max = 0;
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
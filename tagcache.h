@@ -0,0 +1,62 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to tagcache.c
+*
+*   The tag cache is a directory, named by --cache, holding the tags made for
+*   source files, keyed by the MurmurHash3_x86_128 hash of the contents of
+*   each file and of all the options and language settings which determine
+*   the tags made for it. The entry for key K is stored in the file
+*   "K[0..1]/K[2..31]" below the cache directory, so that a cache can be
+*   shared by any number of checkouts and processes. An entry records the
+*   tags as the parser made them, without the name of the source file, which
+*   is supplied again when they are read; they are therefore written in
+*   whatever output format is selected. Entries are laid out as follows:
+*
+*       header   "CTAGSCACHE", version, key and size of the source file in
+*                bytes, separated by tabs and ended by a newline
+*       records  'T' followed by the fields of one tag entry (see
+*                putTagRecord () in tagcache.c), each either 's' and a null
+*                terminated string, 'a' and a null terminated string whose
+*                anonymous names (see ANONYMOUS_PREFIX in parse.h) are
+*                numbered from those made before the file, or 'n' for a
+*                missing value
+*       trailer  'E' and the number of anonymous names made for the file,
+*                as a string, ending the entry
+*/
+#ifndef _TAGCACHE_H
+#define _TAGCACHE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include "entry.h"
+#include "parse.h"
+
+/*
+*   MACROS
+*/
+#define TAG_CACHE_MAGIC    "CTAGSCACHE"
+#define TAG_CACHE_VERSION  3
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern boolean readTagCache (const langType language);
+extern void cacheTagEntry (const tagEntryInfo *const tag);
+extern void checkpointTagCache (void);
+extern void rewindTagCache (void);
+extern void writeTagCache (void);
+extern unsigned long tagCacheHits (void);
+extern void freeTagCacheResources (void);
+
+#endif  /* _TAGCACHE_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
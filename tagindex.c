@@ -0,0 +1,593 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to write the sidecar index of a tag file
+*   (see tagindex.h for its format).
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#if defined (HAVE_STDLIB_H)
+# include <stdlib.h>  /* to declare qsort () */
+#endif
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+
+#include "debug.h"
+#include "options.h"
+#include "routines.h"
+#include "tagindex.h"
+#include "vstring.h"
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef struct sIndexEntry {
+	unsigned long offset;  /* offset of tag line within tag file */
+	unsigned long name;    /* offset of tag name within NameBuffer */
+	unsigned long file;    /* offset of source file name within NameBuffer */
+	unsigned long scope;   /* offset of scope within NameBuffer, or NoScope */
+} indexEntry;
+
+typedef struct sIndexTable {
+	indexEntry *entry;
+	unsigned long count;
+	unsigned long max;
+} indexTable;
+
+/*
+*   DATA DEFINITIONS
+*/
+
+/*  Tag and source file names and scopes of all lines of the tag file, each
+ *  terminated by a null.
+ *  qsort() provides no context pointer to its comparison function, so the
+ *  comparison functions find the names here.
+ */
+static char *NameBuffer = NULL;
+static unsigned long NameLength = 0;
+static unsigned long NameMax = 0;
+
+static const unsigned long NoScope = (unsigned long) -1;
+
+/*  Keys of the extension fields written by ctags other than the scope of a
+ *  tag, whose key is the kind of the enclosing tag (see addExtensionFields ()
+ *  in entry.c). This must agree with readtags.c.
+ */
+static const char *const NonScopeKeys [] = {
+	"kind", "line", "language", "typeref", "file", "inherits", "access",
+	"implementation", "signature"
+};
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+extern char *tagIndexFileName (const char *const tagFileName)
+{
+	char *const result = xMalloc (strlen (tagFileName) +
+			strlen (TAG_INDEX_SUFFIX) + 1, char);
+	strcpy (result, tagFileName);
+	strcat (result, TAG_INDEX_SUFFIX);
+	return result;
+}
+
+static void addNameCharacter (const int c)
+{
+	if (NameLength == NameMax)
+	{
+		NameMax = (NameMax == 0) ? 4096 : 2 * NameMax;
+		NameBuffer = xRealloc (NameBuffer, NameMax, char);
+	}
+	NameBuffer [NameLength++] = (char) c;
+}
+
+static void addEntry (indexTable *const table, const unsigned long offset,
+		const unsigned long name, const unsigned long file,
+		const unsigned long scope)
+{
+	if (table->count == table->max)
+	{
+		table->max = (table->max == 0) ? 1024 : 2 * table->max;
+		table->entry = xRealloc (table->entry, table->max, indexEntry);
+	}
+	table->entry [table->count].offset = offset;
+	table->entry [table->count].name = name;
+	table->entry [table->count].file = file;
+	table->entry [table->count].scope = scope;
+	++table->count;
+}
+
+/*  Adds `length' characters of `string' to NameBuffer, returning their
+ *  offset.
+ */
+static unsigned long addName (const char *const string, const size_t length)
+{
+	const unsigned long result = NameLength;
+	size_t i;
+
+	for (i = 0  ;  i < length  ;  ++i)
+		addNameCharacter (string [i]);
+	addNameCharacter ('\0');
+	return result;
+}
+
+static boolean isScopeKey (const char *const key, const size_t length)
+{
+	boolean result = TRUE;
+	unsigned int i;
+
+	for (i = 0  ;  result  &&  i < sizeof (NonScopeKeys) / sizeof (NonScopeKeys [0])  ;  ++i)
+	{
+		if (strlen (NonScopeKeys [i]) == length  &&
+			strncmp (NonScopeKeys [i], key, length) == 0)
+		{
+			result = FALSE;
+		}
+	}
+	return result;
+}
+
+/*  Returns the start of the extension fields of a tag line, following its
+ *  address (skipped as readtags does), or NULL if it has none.
+ */
+static const char *extensionFields (const char *const address)
+{
+	const char *p = address;
+	const char *result = NULL;
+
+	if (*p == '/'  ||  *p == '?')
+	{
+		const int delimiter = *p;
+		do
+			p = strchr (p + 1, delimiter);
+		while (p != NULL  &&  *(p - 1) == '\\');
+		if (p != NULL)
+			++p;
+	}
+	else
+	{
+		while (isdigit ((int) (unsigned char) *p))
+			++p;
+	}
+	if (p != NULL  &&  strncmp (p, ";\"", (size_t) 2) == 0)
+		result = p + 2;
+	return result;
+}
+
+/*  Returns the offset within NameBuffer of the scope of a tag, recorded from
+ *  the first extension field of `fields' not among NonScopeKeys, or NoScope.
+ */
+static unsigned long addScope (const char *const fields)
+{
+	unsigned long result = NoScope;
+	const char *p = fields;
+
+	while (result == NoScope  &&  p != NULL  &&  *p != '\0')
+	{
+		const char *const field = p + strspn (p, "\t");
+		const char *const colon = strchr (field, ':');
+		const size_t length = strcspn (field, "\t");
+
+		if (colon != NULL  &&  colon < field + length  &&
+			isScopeKey (field, (size_t) (colon - field)))
+		{
+			result = addName (colon + 1,
+					length - (size_t) (colon + 1 - field));
+		}
+		p = field + length;
+	}
+	return result;
+}
+
+/*  Records a tag line beginning at `lineStart' with its name, source file and
+ *  scope. Pseudo-tags and lines without a name are skipped, as readtags
+ *  does.
+ */
+static void addLine (indexTable *const table, const unsigned long lineStart,
+		vString *const line)
+{
+	const char *const name = vStringValue (line);
+	const char *const nameEnd = strchr (name, '\t');
+	const char *file = "";
+	const char *fileEnd = file;
+	unsigned long nameOffset;
+	unsigned long fileOffset;
+	unsigned long scopeOffset = NoScope;
+
+	if (vStringLength (line) > 0  &&  vStringLast (line) == '\r')
+		vStringChop (line);
+	if (nameEnd != NULL)
+	{
+		file = nameEnd + 1;
+		fileEnd = strchr (file, '\t');
+		if (fileEnd == NULL)
+			fileEnd = file + strlen (file);
+	}
+	if (name [0] != '\0'  &&  name [0] != '\t'  &&
+		! (name [0] == '!'  &&  name [1] == '_'))
+	{
+		nameOffset = addName (name,
+				nameEnd == NULL ? vStringLength (line) : (size_t) (nameEnd - name));
+		fileOffset = addName (file, (size_t) (fileEnd - file));
+		if (*fileEnd == '\t')
+			scopeOffset = addScope (extensionFields (fileEnd + 1));
+		addEntry (table, lineStart, nameOffset, fileOffset, scopeOffset);
+	}
+}
+
+/*  Reads the name, source file, scope and offset of every tag line. Offsets
+ *  are counted here rather than taken from readLine(), which rewrites line
+ *  terminators.
+ */
+static unsigned long readTagLines (FILE *const fp, indexTable *const table)
+{
+	vString *const line = vStringNew ();
+	unsigned long offset = 0;
+	int c;
+
+	do
+	{
+		const unsigned long lineStart = offset;
+
+		vStringClear (line);
+		while ((c = getc (fp)) != EOF  &&  c != '\n')
+		{
+			vStringPut (line, c);
+			++offset;
+		}
+		if (c == '\n')
+			++offset;
+		if (c != EOF  ||  vStringLength (line) > 0)
+			addLine (table, lineStart, line);
+	} while (c != EOF);
+	vStringDelete (line);
+	return offset;
+}
+
+static int compareOffsets (const indexEntry *const a, const indexEntry *const b)
+{
+	int result = 0;
+	if (a->offset < b->offset)
+		result = -1;
+	else if (a->offset > b->offset)
+		result = 1;
+	return result;
+}
+
+static int compareNames (const void *const one, const void *const two)
+{
+	const indexEntry *const a = (const indexEntry *) one;
+	const indexEntry *const b = (const indexEntry *) two;
+	const unsigned char *s1 = (const unsigned char *) NameBuffer + a->name;
+	const unsigned char *s2 = (const unsigned char *) NameBuffer + b->name;
+	int result;
+
+	while (*s1 != '\0'  &&  *s1 == *s2)
+		++s1, ++s2;
+	result = (int) *s1 - (int) *s2;
+	if (result == 0)
+		result = compareOffsets (a, b);
+	return result;
+}
+
+static int compareNamesFolded (const void *const one, const void *const two)
+{
+	const indexEntry *const a = (const indexEntry *) one;
+	const indexEntry *const b = (const indexEntry *) two;
+	int result = struppercmp (NameBuffer + a->name, NameBuffer + b->name);
+	if (result == 0)
+		result = compareNames (one, two);
+	return result;
+}
+
+static int compareFiles (const void *const one, const void *const two)
+{
+	const indexEntry *const a = (const indexEntry *) one;
+	const indexEntry *const b = (const indexEntry *) two;
+	int result = strcmp (NameBuffer + a->file, NameBuffer + b->file);
+	if (result == 0)
+		result = compareOffsets (a, b);
+	return result;
+}
+
+/*  Orders tags by scope, those without one last.
+ */
+static int compareScopes (const void *const one, const void *const two)
+{
+	const indexEntry *const a = (const indexEntry *) one;
+	const indexEntry *const b = (const indexEntry *) two;
+	int result;
+
+	if (a->scope == NoScope  ||  b->scope == NoScope)
+		result = (a->scope == NoScope) - (b->scope == NoScope);
+	else
+		result = strcmp (NameBuffer + a->scope, NameBuffer + b->scope);
+	if (result == 0)
+		result = compareOffsets (a, b);
+	return result;
+}
+
+/*  Returns the bit of the completion mask for character `c'. Letters are
+ *  folded to upper case; other characters not given their own bit share the
+ *  remaining bits. This must agree with readtags.c.
+ */
+static int characterBit (const int c)
+{
+	int result;
+	if (isalpha (c))
+		result = toupper (c) - 'A';
+	else if (isdigit (c))
+		result = 26 + (c - '0');
+	else if (c == '_')
+		result = 36;
+	else
+		result = 37 + (c % 27);
+	return result;
+}
+
+static boolean isSameName (const indexEntry *const a, const indexEntry *const b)
+{
+	return (boolean) (strcmp (NameBuffer + a->name, NameBuffer + b->name) == 0);
+}
+
+/*  Counts the distinct names of a table sorted by compareNamesFolded (), and
+ *  the length of the strings needed to hold them.
+ */
+static unsigned long countNames (const indexTable *const table,
+		unsigned long *const stringsLength)
+{
+	unsigned long count = 0;
+	unsigned long i;
+
+	*stringsLength = 0;
+	for (i = 0  ;  i < table->count  ;  ++i)
+	{
+		if (i == 0  ||  ! isSameName (&table->entry [i - 1], &table->entry [i]))
+		{
+			++count;
+			*stringsLength += strlen (NameBuffer + table->entry [i].name) + 1;
+		}
+	}
+	return count;
+}
+
+static void writeValue (FILE *const fp, const unsigned long value,
+		const unsigned int width)
+{
+	unsigned long remaining = value;
+	unsigned int i;
+
+	for (i = 0  ;  i < width  ;  ++i)
+	{
+		putc ((int) (remaining & 0xff), fp);
+		if (i < sizeof (remaining) - 1)
+			remaining >>= 8;
+		else
+			remaining = 0;
+	}
+}
+
+static void writeOffsets (FILE *const fp, const indexTable *const table,
+		const unsigned long count, const unsigned int width)
+{
+	unsigned long i;
+
+	for (i = 0  ;  i < count  ;  ++i)
+		writeValue (fp, table->entry [i].offset, width);
+}
+
+static void writeCompletions (FILE *const fp, const indexTable *const table)
+{
+	unsigned long stringOffset = 0;
+	unsigned long i;
+
+	for (i = 0  ;  i < table->count  ;  ++i)
+	{
+		if (i == 0  ||  ! isSameName (&table->entry [i - 1], &table->entry [i]))
+		{
+			const char *const name = NameBuffer + table->entry [i].name;
+			unsigned char mask [TAG_INDEX_MASK_SIZE];
+			const char *p;
+
+			memset (mask, 0, sizeof (mask));
+			for (p = name  ;  *p != '\0'  ;  ++p)
+			{
+				const int bit = characterBit ((int) (unsigned char) *p);
+				mask [bit / 8] |= (unsigned char) (1 << (bit % 8));
+			}
+			fwrite (mask, sizeof (mask), (size_t) 1, fp);
+			writeValue (fp, stringOffset, 4);
+			stringOffset += strlen (name) + 1;
+		}
+	}
+}
+
+static void writeStrings (FILE *const fp, const indexTable *const table)
+{
+	unsigned long i;
+
+	for (i = 0  ;  i < table->count  ;  ++i)
+	{
+		if (i == 0  ||  ! isSameName (&table->entry [i - 1], &table->entry [i]))
+		{
+			const char *const name = NameBuffer + table->entry [i].name;
+			fwrite (name, strlen (name) + 1, (size_t) 1, fp);
+		}
+	}
+}
+
+static void writeSectionEntry (FILE *const fp, const tagIndexSection id,
+		const unsigned long count, const unsigned long offset)
+{
+	writeValue (fp, (unsigned long) id, 4);
+	writeValue (fp, count, 4);
+	writeValue (fp, offset, 8);
+}
+
+/*  Computes the check of the contents of the tag file recorded in the index:
+ *  an FNV-1a hash of its first and last TAG_INDEX_CHECK_SIZE bytes. The
+ *  ends of a tag file hold its pseudo tags and the last tags sorted, and
+ *  so change with almost any change to the file. This must agree with
+ *  readtags.c.
+ */
+static unsigned long contentCheck (FILE *const fp, const unsigned long size)
+{
+	unsigned char buffer [TAG_INDEX_CHECK_SIZE];
+	const unsigned long last = size > 2 * TAG_INDEX_CHECK_SIZE ?
+			size - TAG_INDEX_CHECK_SIZE : TAG_INDEX_CHECK_SIZE;
+	unsigned long result = 2166136261UL;
+	unsigned long position;
+
+	for (position = 0  ;  position < size  ;  position = last)
+	{
+		size_t length;
+		size_t i;
+
+		fseek (fp, (long) position, SEEK_SET);
+		length = fread (buffer, 1, sizeof (buffer), fp);
+		for (i = 0  ;  i < length  ;  ++i)
+			result = ((result ^ buffer [i]) * 16777619UL) & 0xffffffffUL;
+		if (position == last)
+			break;
+	}
+	return result;
+}
+
+/*  Writes the index. The sections are written in the order in which the
+ *  table is sorted for them, folded name order first.
+ */
+static void writeIndex (FILE *const fp, const indexTable *const table,
+		const unsigned long tagFileSize, const fileStatus *const status,
+		const unsigned long check)
+{
+	const unsigned int width = (tagFileSize > 0xffffffffUL) ? 8 : 4;
+	const unsigned long offsetsSize = table->count * width;
+	const unsigned int sectionCount = 6;
+	unsigned long stringsLength;
+	unsigned long nameCount;
+	unsigned long scopeCount = 0;
+	unsigned long i;
+	unsigned long offset = TAG_INDEX_HEADER_SIZE +
+			sectionCount * TAG_INDEX_SECTION_SIZE;
+
+	qsort (table->entry, (size_t) table->count, sizeof (indexEntry),
+			compareNamesFolded);
+	nameCount = countNames (table, &stringsLength);
+	for (i = 0  ;  i < table->count  ;  ++i)
+		if (table->entry [i].scope != NoScope)
+			++scopeCount;
+
+	fputs (TAG_INDEX_MAGIC, fp);
+	writeValue (fp, TAG_INDEX_VERSION, 4);
+	writeValue (fp, width, 4);
+	writeValue (fp, sectionCount, 4);
+	writeValue (fp, 0, 4);
+	writeValue (fp, tagFileSize, 8);
+	writeValue (fp, status->mtime, 8);
+	writeValue (fp, status->mtimeNanoseconds, 4);
+	writeValue (fp, check, 4);
+
+	writeSectionEntry (fp, TAG_INDEX_FOLDED, table->count, offset);
+	offset += offsetsSize;
+	writeSectionEntry (fp, TAG_INDEX_COMPLETION, nameCount, offset);
+	offset += nameCount * TAG_INDEX_COMPLETION_SIZE;
+	writeSectionEntry (fp, TAG_INDEX_STRINGS, stringsLength, offset);
+	offset += stringsLength;
+	writeSectionEntry (fp, TAG_INDEX_NAME, table->count, offset);
+	offset += offsetsSize;
+	writeSectionEntry (fp, TAG_INDEX_FILE, table->count, offset);
+	offset += offsetsSize;
+	writeSectionEntry (fp, TAG_INDEX_SCOPE, scopeCount, offset);
+
+	writeOffsets (fp, table, table->count, width);
+	writeCompletions (fp, table);
+	writeStrings (fp, table);
+
+	qsort (table->entry, (size_t) table->count, sizeof (indexEntry),
+			compareNames);
+	writeOffsets (fp, table, table->count, width);
+
+	qsort (table->entry, (size_t) table->count, sizeof (indexEntry),
+			compareFiles);
+	writeOffsets (fp, table, table->count, width);
+
+	qsort (table->entry, (size_t) table->count, sizeof (indexEntry),
+			compareScopes);
+	writeOffsets (fp, table, scopeCount, width);
+}
+
+extern void writeTagIndex (const char *const tagFileName)
+{
+	char *const indexName = tagIndexFileName (tagFileName);
+	char *const tempName = xMalloc (strlen (indexName) + 2, char);
+	FILE *const tagFp = fopen (tagFileName, "rb");
+
+	sprintf (tempName, "%s~", indexName);
+	if (tagFp == NULL)
+		error (WARNING | PERROR, "cannot read \"%s\" to index it", tagFileName);
+	else
+	{
+		indexTable table;
+		unsigned long size;
+		unsigned long check;
+		FILE *indexFp;
+
+		verbose ("writing tag index %s\n", indexName);
+		table.entry = NULL;
+		table.count = 0;
+		table.max = 0;
+		size = readTagLines (tagFp, &table);
+		check = contentCheck (tagFp, size);
+		fclose (tagFp);
+
+		/*  Force eStat() to look at the tag file just written.  */
+		eStatFree (eStat (tagFileName));
+
+		/*  The index is written under a temporary name and then renamed, so
+		 *  that readers holding the previous index open are not disturbed.
+		 */
+		indexFp = fopen (tempName, "wb");
+		if (indexFp == NULL)
+			error (WARNING | PERROR, "cannot open \"%s\"", tempName);
+		else
+		{
+			writeIndex (indexFp, &table, size, eStat (tagFileName), check);
+			if (fclose (indexFp) != 0)
+			{
+				error (WARNING | PERROR, "cannot write \"%s\"", tempName);
+				remove (tempName);
+			}
+			else if (rename (tempName, indexName) != 0)
+			{
+				/*  Some hosts cannot rename onto an existing file.  */
+				remove (indexName);
+				if (rename (tempName, indexName) != 0)
+				{
+					error (WARNING | PERROR, "cannot rename \"%s\"", tempName);
+					remove (tempName);
+				}
+			}
+		}
+		if (table.entry != NULL)
+			eFree (table.entry);
+		if (NameBuffer != NULL)
+			eFree (NameBuffer);
+		NameBuffer = NULL;
+		NameLength = 0;
+		NameMax = 0;
+	}
+	eFree (tempName);
+	eFree (indexName);
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,79 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to tagindex.c
+*
+*   A tag index is a sidecar file, named by appending ".idx" to the name of
+*   the tag file, which lists the byte offsets of the tag lines in name order.
+*   The readtags library uses it in place of a binary search through the tag
+*   file itself. All values are stored little-endian:
+*
+*       header   magic "CTAGSIDX" (8 bytes)
+*                version, offset width (4 or 8), section count, reserved (4 bytes each)
+*                size and modification time of the tag file (8 bytes each)
+*                nanoseconds of the modification time, or 0 where not
+*                known, and check of the contents of the tag file (see
+*                contentCheck () in tagindex.c) (4 bytes each)
+*       sections section count entries of id, count (4 bytes each) and
+*                offset within index file (8 bytes)
+*
+*   The layout of each section is given below with its identifier. Readers
+*   ignore sections they do not recognize. The index is only trusted by
+*   readtags while the size, modification time and contents check of the tag
+*   file match those recorded in the header; the contents check catches a tag
+*   file rewritten with the same size within the resolution of its timestamp.
+*/
+#ifndef _TAGINDEX_H
+#define _TAGINDEX_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   MACROS
+*/
+#define TAG_INDEX_SUFFIX        ".idx"
+#define TAG_INDEX_MAGIC         "CTAGSIDX"
+#define TAG_INDEX_VERSION       2
+#define TAG_INDEX_HEADER_SIZE   48
+#define TAG_INDEX_CHECK_SIZE    4096
+#define TAG_INDEX_SECTION_SIZE  16
+#define TAG_INDEX_MASK_SIZE     8
+#define TAG_INDEX_COMPLETION_SIZE  (TAG_INDEX_MASK_SIZE + 4)
+
+/*
+*   DATA DECLARATIONS
+*/
+typedef enum eTagIndexSection {
+	TAG_INDEX_NAME = 1,    /* line offsets ordered by name (strcmp) */
+	TAG_INDEX_FOLDED,      /* line offsets ordered by name ignoring case,
+	                          then by name */
+	TAG_INDEX_COMPLETION,  /* distinct names in TAG_INDEX_FOLDED order, each
+	                          an 8 byte mask of the characters in the name
+	                          (see characterBit () in tagindex.c) and the
+	                          4 byte offset of the name in TAG_INDEX_STRINGS */
+	TAG_INDEX_STRINGS,     /* null terminated strings; count is in bytes */
+	TAG_INDEX_FILE,        /* line offsets ordered by source file name
+	                          (strcmp), then by position in the tag file */
+	TAG_INDEX_SCOPE        /* offsets of the lines having a scope (see
+	                          NonScopeKeys in tagindex.c), ordered by the
+	                          value of the scope (strcmp), then by position
+	                          in the tag file */
+} tagIndexSection;
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern char *tagIndexFileName (const char *const tagFileName);
+extern void writeTagIndex (const char *const tagFileName);
+
+#endif  /* _TAGINDEX_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
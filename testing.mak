@@ -17,9 +17,9 @@ DIFF = if diff $(DIFF_OPTIONS) tags.ref tags.test > $(DIFF_FILE); then \
 		echo "FAILED: differences left in $(DIFF_FILE)" ; \
 	  fi
 
-.PHONY: test test.include test.fields test.extra test.linedir test.etags test.eiffel test.linux
+.PHONY: test test.include test.fields test.extra test.linedir test.etags test.eiffel test.linux test.timeout test.cache test.merge test.dedup test.shard
 
-test: test.include test.fields test.extra test.linedir test.etags test.eiffel test.linux
+test: test.include test.fields test.extra test.linedir test.etags test.eiffel test.linux test.timeout test.cache test.merge test.dedup test.shard
 
 test.%: DIFF_FILE = $@.diff
 
@@ -93,9 +93,112 @@ test.linux: $(CTAGS_TEST) $(CTAGS_REF)
 	@- $(DIFF)
 endif
 
-TEST_ARTIFACTS = test.*.diff tags.ref tags.test
+#	A parse abandoned by --parse-timeout must leave nothing behind to affect
+#	the tags of the files which follow it in the same language.
+TIMEOUT_FILE = timeout.f90 timeout.php
+TEST_TIMEOUT_OPTIONS = $(TEST_OPTIONS) --parse-timeout=0.000001
+test.timeout: $(CTAGS_TEST)
+	@ echo -n "Testing parse timeout..."
+	@ awk 'BEGIN { print "module big"; print "contains"; \
+		for (i = 0; i < 20000; ++i) \
+			printf "subroutine s%d (a)\n  integer :: a\n", i; \
+		print "end module big" }' > timeout.f90
+	@ awk 'BEGIN { print "<?php"; \
+		for (i = 0; i < 20000; ++i) \
+			printf "function f%d ($$a) {\n  return $$a;\n}\n", i; \
+		print "?>" }' > timeout.php
+	@ $(CTAGS_TEST) $(TEST_OPTIONS) -o tags.ref Test/*.f
+	@ $(CTAGS_TEST) $(TEST_TIMEOUT_OPTIONS) -o tags.test $(TIMEOUT_FILE) Test/*.f 2> /dev/null
+	@ rm -f $(TIMEOUT_FILE)
+	@- $(DIFF)
+
+#	Tags read from the cache, whether just written to it (here also for the
+#	copy of a file) or written by an earlier run, must be those of an uncached
+#	run, including the numbers of anonymous tags, and a file edited since
+#	(here without changing its size) must be parsed again.
+CACHE_DIRECTORY = cache.test
+CACHE_FILE = cache.c
+TEST_CACHE_OPTIONS = $(TEST_OPTIONS) --cache=$(CACHE_DIRECTORY)
+test.cache: $(CTAGS_TEST)
+	@ echo -n "Testing tag cache..."
+	@ rm -rf $(CACHE_DIRECTORY)
+	@ cp Test/bit_field.c $(CACHE_FILE)
+	@ $(CTAGS_TEST) -R $(TEST_OPTIONS) -o cache.ref Test $(CACHE_FILE) 2> /dev/null
+	@ $(CTAGS_TEST) -R $(TEST_CACHE_OPTIONS) -o cache.cold Test $(CACHE_FILE) 2> /dev/null
+	@ $(CTAGS_TEST) -R $(TEST_CACHE_OPTIONS) -o cache.warm Test $(CACHE_FILE) 2> /dev/null
+	@ sed 's/bit_fields/bit_fixups/' Test/bit_field.c > $(CACHE_FILE)
+	@ $(CTAGS_TEST) -R $(TEST_OPTIONS) -o cache.edit.ref Test $(CACHE_FILE) 2> /dev/null
+	@ $(CTAGS_TEST) -R $(TEST_CACHE_OPTIONS) -o cache.edit Test $(CACHE_FILE) 2> /dev/null
+	@ cat cache.ref cache.ref cache.edit.ref > tags.ref
+	@ cat cache.cold cache.warm cache.edit > tags.test
+	@ rm -rf $(CACHE_DIRECTORY) $(CACHE_FILE) cache.ref cache.cold cache.warm cache.edit.ref cache.edit
+	@- $(DIFF)
+
+#	Merging the sorted halves of the tags of Test must give the tag file
+#	sorted by ctags, and --dedup must drop just the lines which sorting
+#	would, whether or not case is folded. Patterns are used, since some tags
+#	of Test differ only in case and are easily lost.
+TEST_MERGE_OPTIONS = -u --c-kinds=+lpx
+MERGE_FILES = merge.all merge.1 merge.2 merge.sorted merge.folded merge.unsorted
+test.merge: $(CTAGS_TEST)
+	@ echo -n "Testing tag file merging..."
+	@ $(CTAGS_TEST) -R $(TEST_MERGE_OPTIONS) -o merge.all Test 2> /dev/null
+	@ grep -v '^!_TAG' merge.all | awk 'NR % 2 == 1' > merge.1
+	@ grep -v '^!_TAG' merge.all | awk 'NR % 2 == 0' > merge.2
+	@ LC_ALL=C sort -o merge.1 merge.1 ; LC_ALL=C sort -o merge.2 merge.2
+	@ $(CTAGS_TEST) --sort=yes --merge=merge.1,merge.2 -o tags.test
+	@ LC_ALL=C sort -f -o merge.1 merge.1 ; LC_ALL=C sort -f -o merge.2 merge.2
+	@ $(CTAGS_TEST) --sort=foldcase --merge=merge.1,merge.2 -o merge.folded
+	@ $(CTAGS_TEST) -R $(TEST_MERGE_OPTIONS) --dedup --sort=foldcase -o merge.sorted Test 2> /dev/null
+	@ $(CTAGS_TEST) -R $(TEST_MERGE_OPTIONS) --dedup -o merge.unsorted Test 2> /dev/null
+	@ cat merge.folded merge.sorted merge.unsorted >> tags.test
+	@ $(CTAGS_TEST) -R $(TEST_MERGE_OPTIONS) --sort=yes -o tags.ref Test 2> /dev/null
+	@ $(CTAGS_TEST) -R $(TEST_MERGE_OPTIONS) --sort=foldcase -o merge.folded Test 2> /dev/null
+	@ awk '!seen [$$0]++' merge.all > merge.unsorted
+	@ cat merge.folded merge.folded merge.unsorted >> tags.ref
+	@ rm -f $(MERGE_FILES)
+	@- $(DIFF)
+
+# The same file tagged under two paths gives identical tags but for the file
+# name, which etags writes only in the header of each file's section, so
+# --dedup must drop none of them.
+DEDUP_FILES = dedup.a/x.c dedup.b/x.c
+TEST_DEDUP_OPTIONS = -u --c-kinds=+lpx
+test.dedup: $(CTAGS_TEST)
+	@ echo -n "Testing duplicate tags..."
+	@ mkdir -p dedup.a dedup.b
+	@ cp Test/bit_field.c dedup.a/x.c ; cp Test/bit_field.c dedup.b/x.c
+	@ $(CTAGS_TEST) -e -o tags.ref $(DEDUP_FILES)
+	@ $(CTAGS_TEST) $(TEST_DEDUP_OPTIONS) -o dedup.tags $(DEDUP_FILES)
+	@ cat dedup.tags >> tags.ref
+	@ $(CTAGS_TEST) -e --dedup -o tags.test $(DEDUP_FILES)
+	@ $(CTAGS_TEST) $(TEST_DEDUP_OPTIONS) --dedup -o dedup.tags $(DEDUP_FILES)
+	@ cat dedup.tags >> tags.test
+	@ rm -rf dedup.a dedup.b dedup.tags
+	@- $(DIFF)
+
+# The shards of a tree, taken together, must hold exactly its tags. Scopes
+# are left out, since the TeX parser carries them from one file to the next,
+# and anonymous names are stripped of their numbers, which are counted
+# across the files of a run.
+SHARD_FILES = shard.1 shard.2 shard.3
+TEST_SHARD_OPTIONS = $(TEST_OPTIONS) --fields=-s
+SHARD_LINES = sed 's/__anon[0-9]*/__anon/g' | LC_ALL=C sort
+test.shard: $(CTAGS_TEST)
+	@ echo -n "Testing sharding..."
+	@ $(CTAGS_TEST) -R $(TEST_SHARD_OPTIONS) -o shard.1 Test 2> /dev/null
+	@ grep -v '^!_TAG' shard.1 | $(SHARD_LINES) > tags.ref
+	@ $(CTAGS_TEST) -R $(TEST_SHARD_OPTIONS) --shard=1/3 -o shard.1 Test 2> /dev/null
+	@ $(CTAGS_TEST) -R $(TEST_SHARD_OPTIONS) --shard=2/3 -o shard.2 Test 2> /dev/null
+	@ $(CTAGS_TEST) -R $(TEST_SHARD_OPTIONS) --shard=3/3 -o shard.3 Test 2> /dev/null
+	@ cat $(SHARD_FILES) | grep -v '^!_TAG' | $(SHARD_LINES) > tags.test
+	@ rm -f $(SHARD_FILES)
+	@- $(DIFF)
+
+TEST_ARTIFACTS = test.*.diff tags.ref tags.test $(TIMEOUT_FILE) $(CACHE_FILE) cache.ref cache.cold cache.warm cache.edit.ref cache.edit $(MERGE_FILES) dedup.tags $(SHARD_FILES)
 
 clean-test:
 	rm -f $(TEST_ARTIFACTS)
+	rm -rf $(CACHE_DIRECTORY) dedup.a dedup.b
 
 # vi:ts=4 sw=4
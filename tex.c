@@ -558,6 +558,7 @@ static void findTexTags (void)
 	tokenInfo *const token = newToken ();
 	exception_t exception;
 
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
 	exception = (exception_t) (setjmp (Exception));
 	while (exception == ExceptionNone)
 		parseTexFile (token);
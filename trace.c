@@ -0,0 +1,153 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   This module contains functions to write a trace of the course of a run
+*   (see trace.h for its format).
+*/
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+#include <stdio.h>
+
+#include "debug.h"
+#include "entry.h"
+#include "routines.h"
+#include "trace.h"
+
+/*
+*   DATA DEFINITIONS
+*/
+static struct sTrace {
+	FILE *fp;              /* trace file, or NULL if not tracing */
+	double start;          /* elapsed time at which the trace began */
+	unsigned long bytes;   /* bytes read from source files */
+	double regexSeconds;   /* time matching regular expressions by line */
+} Trace = { NULL, 0.0, 0, 0.0 };
+
+/*
+*   FUNCTION DEFINITIONS
+*/
+
+/*  Writes a JSON string, escaping quotes, backslashes and control characters.
+ */
+static void writeTraceString (const char *const string)
+{
+	const unsigned char *p;
+
+	putc ('"', Trace.fp);
+	for (p = (const unsigned char *) string  ;  *p != '\0'  ;  ++p)
+	{
+		if (*p == '"'  ||  *p == '\\')
+			fprintf (Trace.fp, "\\%c", *p);
+		else if (*p < 0x20)
+			fprintf (Trace.fp, "\\u%04x", *p);
+		else
+			putc (*p, Trace.fp);
+	}
+	putc ('"', Trace.fp);
+}
+
+/*  Writes the fields common to all events, leaving the event open.
+ */
+static void writeTraceEvent (const char *const phase)
+{
+	fprintf (Trace.fp, ",\n{\"ph\":\"%s\",\"ts\":%.3f,\"pid\":1,\"tid\":1",
+			phase, (wallClock () - Trace.start) * 1000000.0);
+}
+
+extern void openTrace (const char *const fileName)
+{
+	Assert (Trace.fp == NULL);
+	Trace.fp = fopen (fileName, "w");
+	if (Trace.fp == NULL)
+		error (FATAL | PERROR, "cannot open trace file \"%s\"", fileName);
+	Trace.start = wallClock ();
+	Trace.bytes = 0;
+	Trace.regexSeconds = 0.0;
+	fputs ("[{\"ph\":\"M\",\"name\":\"process_name\",\"pid\":1,\"tid\":1,"
+			"\"args\":{\"name\":\"ctags\"}}", Trace.fp);
+}
+
+extern void closeTrace (void)
+{
+	if (Trace.fp != NULL)
+	{
+		fputs ("\n]\n", Trace.fp);
+		if (fclose (Trace.fp) != 0)
+			error (WARNING | PERROR, "cannot write trace file");
+		Trace.fp = NULL;
+	}
+}
+
+extern boolean isTracing (void)
+{
+	return (boolean) (Trace.fp != NULL);
+}
+
+/*  Begins a span of the trace, which lasts until the matching traceEnd ().
+ *  `path' names the file or directory concerned, if not NULL.
+ */
+extern void traceBegin (
+		const char *const category, const char *const name,
+		const char *const path)
+{
+	if (Trace.fp != NULL)
+	{
+		writeTraceEvent ("B");
+		fputs (",\"cat\":", Trace.fp);
+		writeTraceString (category);
+		fputs (",\"name\":", Trace.fp);
+		writeTraceString (name);
+		if (path != NULL)
+		{
+			fputs (",\"args\":{\"path\":", Trace.fp);
+			writeTraceString (path);
+			putc ('}', Trace.fp);
+		}
+		putc ('}', Trace.fp);
+	}
+}
+
+extern void traceEnd (void)
+{
+	if (Trace.fp != NULL)
+	{
+		writeTraceEvent ("E");
+		putc ('}', Trace.fp);
+	}
+}
+
+extern void traceRegexTime (const double seconds)
+{
+	Trace.regexSeconds += seconds;
+}
+
+/*  Updates the counters of the trace after a file of `bytes' bytes is
+ *  tagged.
+ */
+extern void traceProgress (const unsigned long bytes)
+{
+	if (Trace.fp != NULL)
+	{
+		Trace.bytes += bytes;
+		writeTraceEvent ("C");
+		fprintf (Trace.fp, ",\"name\":\"tags\",\"args\":{\"tags\":%lu}}",
+				TagFile.numTags.added);
+		writeTraceEvent ("C");
+		fprintf (Trace.fp, ",\"name\":\"bytes read\",\"args\":{\"bytes\":%lu}}",
+				Trace.bytes);
+		writeTraceEvent ("C");
+		fprintf (Trace.fp, ",\"name\":\"regex matching\",\"args\":{\"ms\":%.3f}}",
+				Trace.regexSeconds * 1000.0);
+	}
+}
+
+/* vi:set tabstop=4 shiftwidth=4: */
@@ -0,0 +1,40 @@
+/*
+*   $Id$
+*
+*   Copyright (c) 2026
+*
+*   This source code is released for free distribution under the terms of the
+*   GNU General Public License.
+*
+*   External interface to trace.c
+*
+*   A trace, requested by --trace, records the course of a run as a JSON
+*   array of events in the Trace Event Format read by the Chrome and Perfetto
+*   trace viewers. Spans of time ("B" and "E" events, which nest) are made for
+*   directory reads, language detection, the opening, parsing and closing of
+*   each file, and the sorting and completion of the tag file. After each file
+*   counters ("C" events) give the number of tags written and bytes read so
+*   far, and the time spent matching regular expressions against each line.
+*/
+#ifndef _TRACE_H
+#define _TRACE_H
+
+/*
+*   INCLUDE FILES
+*/
+#include "general.h"  /* must always come first */
+
+/*
+*   FUNCTION PROTOTYPES
+*/
+extern void openTrace (const char *const fileName);
+extern void closeTrace (void);
+extern boolean isTracing (void);
+extern void traceBegin (const char *const category, const char *const name, const char *const path);
+extern void traceEnd (void);
+extern void traceRegexTime (const double seconds);
+extern void traceProgress (const unsigned long bytes);
+
+#endif  /* _TRACE_H */
+
+/* vi:set tabstop=4 shiftwidth=4: */
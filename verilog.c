@@ -300,7 +300,10 @@ static void findVerilogTags (void)
 	vString *const name = vStringNew ();
 	volatile boolean newStatement = TRUE;
 	volatile int c = '\0';
-	exception_t exception = (exception_t) setjmp (Exception);
+	exception_t exception;
+
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
+	exception = (exception_t) setjmp (Exception);
 
 	if (exception == ExceptionNone) while (c != EOF)
 	{
@@ -812,7 +812,10 @@ static void parseVhdlFile (tokenInfo * const token)
 static void findVhdlTags (void)
 {
 	tokenInfo *const token = newToken ();
-	exception_t exception = (exception_t) (setjmp (Exception));
+	exception_t exception;
+
+	catchParseTimeout (&Exception, (int) ExceptionEOF);
+	exception = (exception_t) (setjmp (Exception));
 
 	while (exception == ExceptionNone)
 		parseVhdlFile (token);